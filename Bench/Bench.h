@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Command line of a benchmark or check: "--name value" pairs after the command name
+class BenchArgs
+{
+public:
+	BenchArgs( int argc, char* argv[] );
+
+	double Number( std::string_view name, double defaultValue ) const;
+	std::string Text( std::string_view name, std::string_view defaultValue ) const;
+
+private:
+	std::vector<std::string> m_args;
+};
+
+// Wall clock milliseconds since construction (or the last Restart)
+class Stopwatch
+{
+public:
+	Stopwatch() : m_start( std::chrono::steady_clock::now() ) {}
+
+	void Restart() { m_start = std::chrono::steady_clock::now(); }
+	double ElapsedMs() const { return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - m_start ).count(); }
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// The commands, each returns the exit code of the program
+int RunObjParserBench( const BenchArgs& args );
+int RunObjParserFuzz( const BenchArgs& args );
+int RunDedupBench( const BenchArgs& args );
+int RunNGonBench( const BenchArgs& args );
+int RunPixelBench( const BenchArgs& args );
+int RunChecks( const BenchArgs& args );
+
+// The checks of RunChecks, false and the reason in failure if one fails
+bool CheckParseStream( std::string& failure );
+bool CheckMeshletBuild( std::string& failure );
+bool CheckMeshletFrustum( std::string& failure );
+bool CheckMeshletCone( std::string& failure );
+bool CheckMeshletFile( std::string& failure );
+bool CheckVertexQuantization( std::string& failure );
+bool CheckLodChain( std::string& failure );
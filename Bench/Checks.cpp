@@ -0,0 +1,44 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Correctness checks that need no window or OpenGL context, "--only <name>" runs a single one
+
+struct Check
+{
+	const char* name;
+	bool ( *run )( std::string& failure );
+};
+
+static const Check CHECKS[] =
+{
+	{ "stream",          CheckParseStream },
+	{ "meshlet-build",   CheckMeshletBuild },
+	{ "meshlet-frustum", CheckMeshletFrustum },
+	{ "meshlet-cone",    CheckMeshletCone },
+	{ "meshlet-file",    CheckMeshletFile },
+	{ "quantize",        CheckVertexQuantization },
+	{ "lod",             CheckLodChain },
+};
+
+int RunChecks( const BenchArgs& args )
+{
+	const std::string only = args.Text( "only", "" );
+
+	int failedCount = 0;
+	for ( const Check& check : CHECKS )
+	{
+		if ( !only.empty() && only != check.name ) continue;
+
+		std::string failure;
+		Stopwatch stopwatch;
+		const bool passed = check.run( failure );
+
+		std::printf( "%-16s %s (%.0f ms)%s%s\n", check.name, passed ? "passed" : "FAILED", stopwatch.ElapsedMs(), passed ? "" : ": ", failure.c_str() );
+		if ( !passed ) ++failedCount;
+	}
+
+	return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
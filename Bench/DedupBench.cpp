@@ -0,0 +1,171 @@
+#include "Bench.h"
+#include "ObjGenerator.h"
+
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Vertex deduplication of ObjParser on height fields where every corner has the same vt and vn,
+// against std::unordered_map with the full key hash and with the hash ObjParser had before,
+// which ignored the position index (so all vertices of such a mesh went into one bucket).
+
+namespace
+{
+	struct CornerKey
+	{
+		std::uint32_t v  = 0;
+		std::uint32_t vt = 0;
+		std::uint32_t vn = 0;
+
+		bool operator==( const CornerKey& other ) const noexcept { return v == other.v && vt == other.vt && vn == other.vn; }
+	};
+
+	// fasthash64 as in ObjParser.cpp
+	constexpr std::uint64_t FastHashMix( std::uint64_t h )
+	{
+		h ^= h >> 23;
+		h *= 0x2127599bf4325c37ULL;
+		h ^= h >> 47;
+		return h;
+	}
+
+	constexpr std::uint64_t FastHash64( const std::uint64_t v, const std::uint64_t seed )
+	{
+		constexpr std::uint64_t m = 0x880355f21e6d1965ULL;
+		std::uint64_t h = seed ^ ( m * sizeof( std::uint64_t ) );
+		h ^= FastHashMix( v );
+		h *= m * m;
+		return FastHashMix( h );
+	}
+
+	struct FullKeyHash
+	{
+		std::size_t operator()( const CornerKey& key ) const noexcept { return FastHash64( ( static_cast<std::uint64_t>( key.v ) << 32 ) | key.vt, key.vn ); }
+	};
+
+	struct TexcoordNormalHash
+	{
+		std::size_t operator()( const CornerKey& key ) const noexcept { return FastHash64( key.vt, key.vn ); }
+	};
+
+	// The face corners of a triangulated file, 0 based, in file order
+	std::vector<CornerKey> ReadCorners( const std::string& text )
+	{
+		std::vector<CornerKey> corners;
+		for ( std::size_t lineBegin = 0; lineBegin < text.size(); )
+		{
+			std::size_t lineEnd = text.find( '\n', lineBegin );
+			if ( lineEnd == std::string::npos ) lineEnd = text.size();
+
+			if ( text.compare( lineBegin, 2, "f " ) == 0 )
+			{
+				const char* p = text.data() + lineBegin + 2;
+				const char* end = text.data() + lineEnd;
+				while ( p < end )
+				{
+					CornerKey key;
+					std::uint32_t* fields[] = { &key.v, &key.vt, &key.vn };
+					for ( std::uint32_t* field : fields )
+					{
+						if ( p < end && *p != '/' ) p = std::from_chars( p, end, *field ).ptr;
+						if ( *field > 0 ) --*field;
+						if ( p < end && *p == '/' ) ++p;
+					}
+					corners.push_back( key );
+					while ( p < end && *p == ' ' ) ++p;
+				}
+			}
+			lineBegin = lineEnd + 1;
+		}
+		return corners;
+	}
+
+	template <typename HashT>
+	double DedupMs( const std::vector<CornerKey>& corners, std::size_t& vertexCount )
+	{
+		Stopwatch stopwatch;
+
+		std::unordered_map<CornerKey, unsigned int, HashT> vertexIndices;
+		std::vector<unsigned int> indices;
+		indices.reserve( corners.size() );
+		for ( const CornerKey& corner : corners )
+		{
+			const auto inserted = vertexIndices.emplace( corner, static_cast<unsigned int>( vertexIndices.size() ) );
+			indices.push_back( inserted.first->second );
+		}
+
+		vertexCount = vertexIndices.size();
+		return stopwatch.ElapsedMs();
+	}
+}
+
+// Doubling file sizes up to --size MB, so the growth of the time shows: linear for the flat table,
+// quadratic for the old hash (run only up to --oldlimit corners, it takes minutes above that).
+int RunDedupBench( const BenchArgs& args )
+{
+	const double      maxMegabytes = args.Number( "size", 8.0 );
+	const std::size_t oldLimit     = static_cast<std::size_t>( args.Number( "oldlimit", 200000.0 ) );
+	const int         repeat       = std::max( 1, static_cast<int>( args.Number( "repeat", 3.0 ) ) );
+
+	std::printf( "one shared vt and vn, triangles\n" );
+	std::printf( "%7s %9s %9s | %-19s | %-19s | %-19s\n", "MB", "corners", "vertices", "ObjParser flat", "unordered, full key", "unordered, vt+vn" );
+	std::printf( "%7s %9s %9s | %8s %10s | %8s %10s | %8s %10s\n", "", "", "", "ms", "Mvert/s", "ms", "Mvert/s", "ms", "Mvert/s" );
+
+	int result = EXIT_SUCCESS;
+
+	for ( double megabytes = std::min( 1.0 / 16.0, maxMegabytes ); megabytes <= maxMegabytes; megabytes *= 2.0 )
+	{
+		ObjGeneratorOptions options;
+		options.shape            = ObjGeneratorOptions::Shape::Triangles;
+		options.corners          = ObjGeneratorOptions::Corners::PositionTexcoordNormal;
+		options.sharedAttributes = true;
+		options.targetBytes      = static_cast<std::size_t>( megabytes * 1048576.0 );
+
+		const std::string text = GenerateObj( options );
+
+		double parserMs = 0.0;
+		std::size_t parserVertices = 0;
+		for ( int i = 0; i < repeat; ++i )
+		{
+			const ObjParser::Model model = ObjParser::parseMemory( text.data(), text.size() );
+			if ( i == 0 || model.stats.dedupMs < parserMs ) parserMs = model.stats.dedupMs;
+			parserVertices = model.mesh.vertexArray.size();
+		}
+
+		const std::vector<CornerKey> corners = ReadCorners( text );
+
+		std::size_t fullKeyVertices = 0;
+		double fullKeyMs = DedupMs<FullKeyHash>( corners, fullKeyVertices );
+		for ( int i = 1; i < repeat; ++i ) fullKeyMs = std::min( fullKeyMs, DedupMs<FullKeyHash>( corners, fullKeyVertices ) );
+
+		const double cornerMillions = corners.size() / 1e6;
+		std::printf( "%7.2f %9zu %9zu | %8.1f %10.2f | %8.1f %10.2f | ", text.size() / 1048576.0, corners.size(), parserVertices,
+					 parserMs, cornerMillions / ( parserMs / 1000.0 ), fullKeyMs, cornerMillions / ( fullKeyMs / 1000.0 ) );
+
+		if ( corners.size() <= oldLimit )
+		{
+			std::size_t oldVertices = 0;
+			const double oldMs = DedupMs<TexcoordNormalHash>( corners, oldVertices );
+			std::printf( "%8.1f %10.2f\n", oldMs, cornerMillions / ( oldMs / 1000.0 ) );
+		}
+		else
+		{
+			std::printf( "%8s %10s\n", "skipped", "" );
+		}
+
+		if ( parserVertices != fullKeyVertices )
+		{
+			std::printf( "  FAILED: ObjParser kept %zu vertices, the reference %zu\n", parserVertices, fullKeyVertices );
+			result = EXIT_FAILURE;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,207 @@
+#include "Bench.h"
+
+#include "MeshSimplifier.h"
+#include "ParametricSurfaceMesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+// MeshSimplifier::BuildLodChain on a UV sphere: the u = 0 / u = 1 column is a texture seam (same positions, other texcoords),
+// the two hemispheres are two submeshes, and the rows at the poles have only degenerate triangles.
+// Every level has to keep the closed surface closed, keep the triangles facing outwards,
+// and stay within its Lod::error of the original triangle planes.
+
+namespace
+{
+	constexpr float SPHERE_RADIUS = 2.0f;
+
+	// the seam and the poles get exactly the same positions, so they weld by position
+	struct Sphere
+	{
+		glm::vec3 GetPos( const float u, const float v ) const
+		{
+			const float phi = u < 1.0f ? glm::two_pi<float>() * u : 0.0f;
+			const float sinTheta = ( v > 0.0f && v < 1.0f ) ? std::sin( glm::pi<float>() * v ) : 0.0f;
+			const float cosTheta = v <= 0.0f ? 1.0f : ( v >= 1.0f ? -1.0f : std::cos( glm::pi<float>() * v ) );
+			return SPHERE_RADIUS * glm::vec3( sinTheta * std::cos( phi ), cosTheta, sinTheta * std::sin( phi ) );
+		}
+		glm::vec3 GetNorm( const float u, const float v ) const { return GetPos( u, v ) / SPHERE_RADIUS; }
+		glm::vec2 GetTex( const float u, const float v ) const { return glm::vec2( u, v ); }
+	};
+
+	using PositionKey = std::tuple<float, float, float>;
+
+	PositionKey KeyOf( const glm::vec3& p ) { return { p.x, p.y, p.z }; }
+
+	// The triangles of a level as position ids (new positions are added to positionIds and positions), without the ones that have no area
+	struct PositionTriangles
+	{
+		std::vector<std::array<int, 3>> triangles;
+	};
+
+	PositionTriangles TrianglesOf( const MeshObject<Vertex>& mesh, const GLuint* indices, const std::vector<ObjParser::SubMesh>& subMeshes,
+								   std::map<PositionKey, int>& positionIds, std::vector<glm::vec3>& positions )
+	{
+		PositionTriangles result;
+		for ( const ObjParser::SubMesh& subMesh : subMeshes )
+		{
+			for ( GLuint i = subMesh.indexOffset; i < subMesh.indexOffset + subMesh.indexCount; i += 3 )
+			{
+				std::array<int, 3> triangle;
+				for ( int k = 0; k < 3; ++k )
+				{
+					const glm::vec3& p = mesh.vertexArray[ indices[ i + k ] ].position;
+					const auto inserted = positionIds.emplace( KeyOf( p ), static_cast<int>( positions.size() ) );
+					if ( inserted.second ) positions.push_back( p );
+					triangle[ k ] = inserted.first->second;
+				}
+				if ( triangle[ 0 ] != triangle[ 1 ] && triangle[ 0 ] != triangle[ 2 ] && triangle[ 1 ] != triangle[ 2 ] ) result.triangles.push_back( triangle );
+			}
+		}
+		return result;
+	}
+
+	// edges with a single triangle
+	std::size_t OpenEdgeCount( const std::vector<std::array<int, 3>>& triangles )
+	{
+		std::map<std::pair<int, int>, int> edgeTriangles;
+		for ( const std::array<int, 3>& triangle : triangles )
+		{
+			for ( int k = 0; k < 3; ++k )
+				++edgeTriangles[ std::minmax( triangle[ k ], triangle[ ( k + 1 ) % 3 ] ) ];
+		}
+		return std::count_if( edgeTriangles.cbegin(), edgeTriangles.cend(), []( const auto& edge ) { return edge.second == 1; } );
+	}
+}
+
+bool CheckLodChain( std::string& failure )
+{
+	const MeshObject<Vertex> sphere = GetParamSurfMesh( Sphere(), 64, 32 );
+
+	// the index array goes row by row, so the first half of it is the upper hemisphere
+	const GLuint half = static_cast<GLuint>( sphere.indexArray.size() / 2 );
+	const std::vector<ObjParser::SubMesh> subMeshes = { { 0, half, 0 }, { half, static_cast<GLuint>( sphere.indexArray.size() ) - half, 1 } };
+
+	const MeshView<Vertex> view = { sphere.vertexArray.data(), sphere.vertexArray.size(), sphere.indexArray.data(), sphere.indexArray.size() };
+	const MeshSimplifier::LodChain chain = MeshSimplifier::BuildLodChain( view, subMeshes );
+
+	if ( chain.lods.size() < 3 )
+	{
+		failure = "only " + std::to_string( chain.lods.size() ) + " levels were built";
+		return false;
+	}
+
+	std::map<PositionKey, int> positionIds;
+	std::vector<glm::vec3> positions;
+	const PositionTriangles original = TrianglesOf( sphere, chain.indices.data(), chain.lods[ 0 ].subMeshes, positionIds, positions );
+
+	// the planes of the original triangles around each position
+	std::vector<std::vector<glm::vec4>> positionPlanes( positions.size() );
+	for ( const std::array<int, 3>& triangle : original.triangles )
+	{
+		const glm::vec3 normal = glm::normalize( glm::cross( positions[ triangle[ 1 ] ] - positions[ triangle[ 0 ] ], positions[ triangle[ 2 ] ] - positions[ triangle[ 0 ] ] ) );
+		for ( const int id : triangle ) positionPlanes[ id ].push_back( glm::vec4( normal, -glm::dot( normal, positions[ triangle[ 0 ] ] ) ) );
+	}
+
+	// GetParamSurfMesh winds the triangles inwards or outwards, the levels have to keep it
+	const std::array<int, 3>& first = original.triangles.front();
+	const float orientation = glm::dot( glm::cross( positions[ first[ 1 ] ] - positions[ first[ 0 ] ], positions[ first[ 2 ] ] - positions[ first[ 0 ] ] ), positions[ first[ 0 ] ] ) > 0.0f ? 1.0f : -1.0f;
+
+	const std::size_t originalOpenEdges = OpenEdgeCount( original.triangles );
+
+	for ( std::size_t level = 1; level < chain.lods.size(); ++level )
+	{
+		const MeshSimplifier::Lod& lod = chain.lods[ level ];
+		const std::string levelName = "level " + std::to_string( level );
+
+		if ( lod.subMeshes.size() != 2 || lod.error < chain.lods[ level - 1 ].error )
+		{
+			failure = levelName + " lost a submesh, or its error is below the one of the previous level";
+			return false;
+		}
+
+		const PositionTriangles simplified = TrianglesOf( sphere, chain.indices.data(), lod.subMeshes, positionIds, positions );
+		if ( positions.size() != positionPlanes.size() )
+		{
+			failure = levelName + " has a position that is not in the original mesh";
+			return false;
+		}
+
+		for ( const std::array<int, 3>& triangle : simplified.triangles )
+		{
+			const glm::vec3 normal = glm::cross( positions[ triangle[ 1 ] ] - positions[ triangle[ 0 ] ], positions[ triangle[ 2 ] ] - positions[ triangle[ 0 ] ] );
+			const glm::vec3 centroid = ( positions[ triangle[ 0 ] ] + positions[ triangle[ 1 ] ] + positions[ triangle[ 2 ] ] ) / 3.0f;
+			if ( glm::dot( normal, centroid ) * orientation <= 0.0f )
+			{
+				failure = levelName + " has a flipped triangle";
+				return false;
+			}
+		}
+
+		const std::size_t openEdges = OpenEdgeCount( simplified.triangles );
+		if ( openEdges > originalOpenEdges )
+		{
+			failure = levelName + " has " + std::to_string( openEdges ) + " open edges, the original has " + std::to_string( originalOpenEdges );
+			return false;
+		}
+
+		// Every removed position went to a kept one, whose distance from the planes around the removed position is at most lod.error.
+		// The chain does not tell which one it was, the kept position closest to the planes is taken, so this can only underestimate.
+		std::vector<bool> isKept( positions.size(), false );
+		for ( const std::array<int, 3>& triangle : simplified.triangles )
+			for ( const int id : triangle ) isKept[ id ] = true;
+
+		float measuredError = 0.0f;
+		for ( std::size_t removed = 0; removed < positions.size(); ++removed )
+		{
+			if ( isKept[ removed ] || positionPlanes[ removed ].empty() ) continue;
+
+			float distance = std::numeric_limits<float>::max();
+			for ( std::size_t kept = 0; kept < positions.size(); ++kept )
+			{
+				if ( !isKept[ kept ] ) continue;
+
+				float planeDistance = 0.0f;
+				for ( const glm::vec4& plane : positionPlanes[ removed ] )
+					planeDistance = std::max( planeDistance, std::abs( glm::dot( glm::vec3( plane ), positions[ kept ] ) + plane.w ) );
+				distance = std::min( distance, planeDistance );
+			}
+			measuredError = std::max( measuredError, distance );
+		}
+
+		if ( measuredError > lod.error * 1.001f + 1e-6f )
+		{
+			failure = levelName + " moved a vertex " + std::to_string( measuredError ) + " from the original planes, its error is " + std::to_string( lod.error );
+			return false;
+		}
+	}
+
+	// coming closer (larger errorToPixels) never selects a coarser level
+	std::size_t previousLod = chain.lods.size();
+	for ( float errorToPixels = 1e-3f; errorToPixels < 1e7f; errorToPixels *= 1.25f )
+	{
+		const std::size_t selected = MeshSimplifier::SelectLod( chain.lods, errorToPixels );
+		if ( selected > previousLod )
+		{
+			failure = "SelectLod picked level " + std::to_string( selected ) + " after level " + std::to_string( previousLod ) + " at " + std::to_string( errorToPixels ) + " pixels per unit";
+			return false;
+		}
+		previousLod = selected;
+	}
+	if ( previousLod != 0 || MeshSimplifier::SelectLod( chain.lods, 1e-9f ) != chain.lods.size() - 1 )
+	{
+		failure = "SelectLod does not span the whole chain";
+		return false;
+	}
+
+	return true;
+}
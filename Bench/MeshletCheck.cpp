@@ -0,0 +1,247 @@
+#include "Bench.h"
+
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// MeshletBuilder and MeshletCuller on meshes with known answers: a unit cube (one meshlet, normals in every direction)
+// and a flat grid facing +z (many meshlets, each one backface cullable).
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		MeshView<Vertex> View() const { return { vertices.data(), vertices.size(), indices.data(), indices.size() }; }
+	};
+
+	// 6 faces with their own vertices, counterclockwise seen from outside
+	TestMesh MakeCube()
+	{
+		static const glm::vec3 NORMALS[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+		TestMesh cube;
+		for ( const glm::vec3& normal : NORMALS )
+		{
+			// two axes of the face, u x v = normal
+			const glm::vec3 u = ( std::abs( normal.x ) > 0.5f ) ? glm::vec3( 0, 1, 0 ) : glm::vec3( 1, 0, 0 );
+			const glm::vec3 v = glm::cross( normal, u );
+
+			const GLuint first = static_cast<GLuint>( cube.vertices.size() );
+			for ( const glm::vec2 corner : { glm::vec2( -1, -1 ), glm::vec2( 1, -1 ), glm::vec2( 1, 1 ), glm::vec2( -1, 1 ) } )
+				cube.vertices.push_back( { 0.5f * ( normal + corner.x * u + corner.y * v ), normal, corner * 0.5f + glm::vec2( 0.5f ) } );
+
+			for ( const GLuint index : { 0u, 1u, 2u, 0u, 2u, 3u } ) cube.indices.push_back( first + index );
+		}
+		return cube;
+	}
+
+	// size x size quads in the z = 0 plane, [-1,1] x [-1,1], counterclockwise seen from +z
+	TestMesh MakeGrid( const int size )
+	{
+		TestMesh grid;
+		for ( int y = 0; y <= size; ++y )
+		{
+			for ( int x = 0; x <= size; ++x )
+			{
+				const glm::vec2 uv( static_cast<float>( x ) / size, static_cast<float>( y ) / size );
+				grid.vertices.push_back( { glm::vec3( 2.0f * uv.x - 1.0f, 2.0f * uv.y - 1.0f, 0.0f ), glm::vec3( 0, 0, 1 ), uv } );
+			}
+		}
+		for ( int y = 0; y < size; ++y )
+		{
+			for ( int x = 0; x < size; ++x )
+			{
+				const GLuint i00 = y * ( size + 1 ) + x, i01 = i00 + 1, i10 = i00 + size + 1, i11 = i10 + 1;
+				for ( const GLuint index : { i00, i01, i11, i00, i11, i10 } ) grid.indices.push_back( index );
+			}
+		}
+		return grid;
+	}
+
+	glm::mat4 ViewProj( const glm::vec3& eye, const glm::vec3& target )
+	{
+		return glm::perspective( glm::radians( 60.0f ), 1.0f, 0.1f, 100.0f ) * glm::lookAt( eye, target, glm::vec3( 0, 1, 0 ) );
+	}
+
+	bool InsideFrustum( const Meshlet& meshlet, const Frustum& frustum )
+	{
+		for ( const glm::vec4& plane : frustum.planes )
+		{
+			if ( glm::dot( glm::vec3( plane ), meshlet.center ) + plane.w < -meshlet.radius ) return false;
+		}
+		return true;
+	}
+}
+
+// The meshlets cover the triangles in index order, stay within the limits, and their bounds hold every vertex and normal
+bool CheckMeshletBuild( std::string& failure )
+{
+	for ( const TestMesh& mesh : { MakeCube(), MakeGrid( 40 ) } )
+	{
+		const MeshletMesh meshletMesh = MeshletBuilder::Build( mesh.View() );
+
+		if ( MeshletBuilder::BuildIndexBuffer( meshletMesh ) != mesh.indices )
+		{
+			failure = "BuildIndexBuffer does not give back the triangles of the mesh";
+			return false;
+		}
+
+		for ( const Meshlet& meshlet : meshletMesh.meshlets )
+		{
+			if ( meshlet.vertexCount > MeshletBuilder::MAX_VERTICES || meshlet.triangleCount > MeshletBuilder::MAX_TRIANGLES )
+			{
+				failure = "a meshlet is over the vertex or triangle limit";
+				return false;
+			}
+
+			const float minCos = std::sqrt( std::max( 0.0f, 1.0f - meshlet.coneCutoff * meshlet.coneCutoff ) );
+			for ( uint32_t t = 0; t < meshlet.triangleCount; ++t )
+			{
+				glm::vec3 p[ 3 ];
+				for ( int k = 0; k < 3; ++k )
+				{
+					const uint8_t localIndex = meshletMesh.triangles[ 3 * ( meshlet.triangleOffset + t ) + k ];
+					p[ k ] = mesh.vertices[ meshletMesh.vertices[ meshlet.vertexOffset + localIndex ] ].position;
+
+					if ( glm::distance( p[ k ], meshlet.center ) > meshlet.radius * 1.0001f + 1e-6f )
+					{
+						failure = "a vertex is outside of the bounding sphere of its meshlet";
+						return false;
+					}
+				}
+
+				const glm::vec3 normal = glm::normalize( glm::cross( p[ 1 ] - p[ 0 ], p[ 2 ] - p[ 0 ] ) );
+				if ( meshlet.coneCutoff <= 1.0f && glm::dot( normal, meshlet.coneAxis ) < minCos - 1e-5f )
+				{
+					failure = "a triangle normal is outside of the normal cone of its meshlet";
+					return false;
+				}
+			}
+		}
+	}
+
+	if ( MeshletBuilder::Build( MakeCube().View() ).meshlets.size() != 1 || MeshletBuilder::Build( MakeGrid( 40 ).View() ).meshlets.size() < 2 )
+	{
+		failure = "the cube should be one meshlet, the grid several";
+		return false;
+	}
+	return true;
+}
+
+// A camera looking at the cube sees it, the same camera turned around, or a cube moved out of the view, culls it
+bool CheckMeshletFrustum( std::string& failure )
+{
+	const MeshletMesh cube = MeshletBuilder::Build( MakeCube().View() );
+	const glm::vec3 eye( 0.0f, 0.0f, 5.0f );
+
+	if ( MeshletCuller::Cull( cube, ViewProj( eye, glm::vec3( 0.0f ) ), glm::mat4( 1.0f ), eye ).size() != cube.meshlets.size() )
+	{
+		failure = "the cube in front of the camera is culled";
+		return false;
+	}
+	if ( !MeshletCuller::Cull( cube, ViewProj( eye, glm::vec3( 0.0f, 0.0f, 10.0f ) ), glm::mat4( 1.0f ), eye ).empty() )
+	{
+		failure = "the cube behind the camera is not culled";
+		return false;
+	}
+	if ( !MeshletCuller::Cull( cube, ViewProj( eye, glm::vec3( 0.0f ) ), glm::translate( glm::mat4( 1.0f ), glm::vec3( 0.0f, 50.0f, 0.0f ) ), eye ).empty() )
+	{
+		failure = "the cube moved above the view is not culled";
+		return false;
+	}
+	return true;
+}
+
+// The grid is culled by the normal cones when seen from behind, although it is inside the frustum; the cube never is
+bool CheckMeshletCone( std::string& failure )
+{
+	const MeshletMesh grid = MeshletBuilder::Build( MakeGrid( 40 ).View() );
+	const MeshletMesh cube = MeshletBuilder::Build( MakeCube().View() );
+
+	for ( const Meshlet& meshlet : grid.meshlets )
+	{
+		if ( meshlet.coneCutoff > 1e-3f )
+		{
+			failure = "a flat meshlet has a wide normal cone";
+			return false;
+		}
+	}
+	if ( cube.meshlets.front().coneCutoff <= 1.0f )
+	{
+		failure = "the cube meshlet has a cullable normal cone";
+		return false;
+	}
+
+	const glm::vec3 front( 0.0f, 0.0f, 5.0f ), back( 0.0f, 0.0f, -5.0f );
+	const Frustum backFrustum = Frustum::FromMatrix( ViewProj( back, glm::vec3( 0.0f ) ) );
+
+	if ( MeshletCuller::Cull( grid, ViewProj( front, glm::vec3( 0.0f ) ), glm::mat4( 1.0f ), front ).size() != grid.meshlets.size() )
+	{
+		failure = "the grid seen from the front is culled";
+		return false;
+	}
+	for ( const Meshlet& meshlet : grid.meshlets )
+	{
+		if ( !InsideFrustum( meshlet, backFrustum ) )
+		{
+			failure = "the grid is not inside the frustum of the camera behind it";
+			return false;
+		}
+	}
+	if ( !MeshletCuller::Cull( grid, ViewProj( back, glm::vec3( 0.0f ) ), glm::mat4( 1.0f ), back ).empty() )
+	{
+		failure = "the back facing grid is not culled";
+		return false;
+	}
+	if ( MeshletCuller::Cull( cube, ViewProj( back, glm::vec3( 0.0f ) ), glm::mat4( 1.0f ), back ).size() != cube.meshlets.size() )
+	{
+		failure = "the cube is culled from behind";
+		return false;
+	}
+	return true;
+}
+
+// Write then Read gives the same meshlets; a file with a meshlet pointing past the arrays is refused
+bool CheckMeshletFile( std::string& failure )
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BomberApeBench";
+	std::filesystem::create_directories( directory );
+	const std::filesystem::path path = directory / "meshlets.bin";
+
+	const MeshletMesh written = MeshletBuilder::Build( MakeGrid( 40 ).View() );
+	MeshletMesh read;
+
+	bool passed = MeshletBuilder::Write( path, written ) && MeshletBuilder::Read( path, read );
+	passed = passed && read.meshlets.size() == written.meshlets.size() && read.vertices == written.vertices && read.triangles == written.triangles
+		&& std::memcmp( read.meshlets.data(), written.meshlets.data(), written.meshlets.size() * sizeof( Meshlet ) ) == 0;
+	if ( !passed )
+	{
+		failure = "Read does not give back what Write wrote";
+		std::filesystem::remove( path );
+		return false;
+	}
+
+	// the first meshlet of the file gets an offset past the vertices
+	{
+		std::fstream file( path, std::ios::in | std::ios::out | std::ios::binary );
+		const uint32_t badOffset = static_cast<uint32_t>( written.vertices.size() );
+		file.seekp( 5 * sizeof( uint32_t ) + offsetof( Meshlet, vertexOffset ) );
+		file.write( reinterpret_cast<const char*>( &badOffset ), sizeof( badOffset ) );
+	}
+	passed = !MeshletBuilder::Read( path, read );
+	std::filesystem::remove( path );
+
+	if ( !passed ) failure = "Read accepts a meshlet outside of the vertex array";
+	return passed;
+}
@@ -0,0 +1,81 @@
+#include "Bench.h"
+#include "ObjGenerator.h"
+
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Triangulation of single large polygons (CAD exports write caps with thousands of vertices),
+// convex ones and star shaped ones, from 10 to --max vertices in steps of about 3x.
+// The triangles have to cover the polygon exactly: n - 2 of them, with the area of the polygon.
+
+namespace
+{
+	// Area of the polygon the generator writes: n triangles around the center, between the radii of neighbouring vertices
+	double PolygonArea( const ObjGeneratorOptions::Shape shape, const unsigned int arity )
+	{
+		const double neighbourRadii = ( shape == ObjGeneratorOptions::Shape::StarNGons ) ? 0.5 : 1.0;
+		return arity * neighbourRadii * std::sin( 2.0 * 3.14159265358979 / arity ) / 2.0;
+	}
+
+	double TrianglesArea( const ObjParser::Mesh& mesh )
+	{
+		double area = 0.0;
+		for ( std::size_t i = 0; i + 2 < mesh.indexArray.size(); i += 3 )
+		{
+			const glm::vec3 e1 = mesh.vertexArray[ mesh.indexArray[ i + 1 ] ].position - mesh.vertexArray[ mesh.indexArray[ i ] ].position;
+			const glm::vec3 e2 = mesh.vertexArray[ mesh.indexArray[ i + 2 ] ].position - mesh.vertexArray[ mesh.indexArray[ i ] ].position;
+			area += std::abs( static_cast<double>( e1.z ) * e2.x - static_cast<double>( e1.x ) * e2.z ) / 2.0;
+		}
+		return area;
+	}
+}
+
+int RunNGonBench( const BenchArgs& args )
+{
+	const unsigned int maxArity = static_cast<unsigned int>( args.Number( "max", 100000.0 ) );
+	const int          repeat   = std::max( 1, static_cast<int>( args.Number( "repeat", 3.0 ) ) );
+
+	std::printf( "%-12s %8s %10s %12s %10s\n", "shape", "vertices", "triangles", "triangul. ms", "us/vertex" );
+
+	int result = EXIT_SUCCESS;
+
+	for ( const ObjGeneratorOptions::Shape shape : { ObjGeneratorOptions::Shape::NGons, ObjGeneratorOptions::Shape::StarNGons } )
+	{
+		for ( unsigned int arity = 10; arity <= maxArity; arity = ( arity % 3 == 1 ) ? arity * 3 : arity / 3 * 10 )
+		{
+			// a single polygon, the normals are in the file so only the triangulation is measured
+			ObjGeneratorOptions options;
+			options.shape       = shape;
+			options.corners     = ObjGeneratorOptions::Corners::PositionNormal;
+			options.ngonArity   = arity;
+			options.targetBytes = 0;
+
+			const std::string text = GenerateObj( options );
+
+			ObjParser::Model model = ObjParser::parseMemory( text.data(), text.size() );
+			for ( int i = 1; i < repeat; ++i )
+			{
+				ObjParser::Model next = ObjParser::parseMemory( text.data(), text.size() );
+				if ( next.stats.triangulateMs < model.stats.triangulateMs ) model = std::move( next );
+			}
+
+			const std::size_t triangleCount = model.mesh.indexArray.size() / 3;
+			std::printf( "%-12s %8u %10zu %12.2f %10.3f\n", ShapeName( shape ), arity, triangleCount,
+						 model.stats.triangulateMs, model.stats.triangulateMs * 1000.0 / arity );
+
+			const double polygonArea = PolygonArea( shape, arity );
+			const double trianglesArea = TrianglesArea( model.mesh );
+			if ( triangleCount != arity - 2 || std::abs( trianglesArea - polygonArea ) > 1e-3 * polygonArea )
+			{
+				std::printf( "  FAILED: %zu triangles (%u expected) with area %.6f, the polygon has %.6f\n", triangleCount, arity - 2, trianglesArea, polygonArea );
+				result = EXIT_FAILURE;
+			}
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,177 @@
+#include "ObjGenerator.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	using Shape   = ObjGeneratorOptions::Shape;
+	using Corners = ObjGeneratorOptions::Corners;
+
+	constexpr float PI = 3.14159265358979f;
+
+	// Vertices per row of the height field
+	constexpr unsigned int GRID_WIDTH = 512;
+
+	class ObjWriter
+	{
+	public:
+		ObjWriter( std::string& text, const Corners corners, const bool sharedAttributes )
+			: m_text( text ), m_corners( corners ), m_sharedAttributes( sharedAttributes )
+		{
+			if ( m_sharedAttributes )
+			{
+				if ( m_corners == Corners::PositionTexcoordNormal ) Append( "vt 0.5 0.5\n" );
+				if ( m_corners != Corners::PositionOnly ) Append( "vn 0 1 0\n" );
+			}
+		}
+
+		// v, vt and vn of one vertex, they all get the same (1 based) index, unless the vt and vn are shared
+		void Vertex( float x, float y, float z, float nx, float ny, float nz, float s, float t )
+		{
+			Append( "v %.6f %.6f %.6f\n", x, y, z );
+			if ( !m_sharedAttributes )
+			{
+				if ( m_corners == Corners::PositionTexcoordNormal ) Append( "vt %.6f %.6f\n", s, t );
+				if ( m_corners != Corners::PositionOnly ) Append( "vn %.6f %.6f %.6f\n", nx, ny, nz );
+			}
+			++m_vertexCount;
+		}
+
+		void BeginFace() { m_text += 'f'; }
+		void Corner( const std::size_t index )
+		{
+			const std::size_t attributeIndex = m_sharedAttributes ? 1 : index;
+			switch ( m_corners )
+			{
+			case Corners::PositionTexcoordNormal: Append( " %zu/%zu/%zu", index, attributeIndex, attributeIndex ); break;
+			case Corners::PositionNormal:         Append( " %zu//%zu", index, attributeIndex ); break;
+			case Corners::PositionOnly:           Append( " %zu", index ); break;
+			}
+		}
+		void EndFace() { m_text += '\n'; }
+
+		std::size_t VertexCount() const noexcept { return m_vertexCount; }
+
+	private:
+		template <typename... Args>
+		void Append( const char* format, Args... args )
+		{
+			char buffer[ 128 ];
+			const int length = std::snprintf( buffer, sizeof( buffer ), format, args... );
+			m_text.append( buffer, static_cast<std::size_t>( length ) );
+		}
+
+		std::string& m_text;
+		Corners      m_corners;
+		bool         m_sharedAttributes;
+		std::size_t  m_vertexCount = 0;
+	};
+
+	float Height( const float x, const float z )
+	{
+		return 0.1f * std::sin( 0.37f * x ) * std::cos( 0.23f * z );
+	}
+
+	// Rows of vertices are written one after the other, each one followed by the faces between it and the previous row
+	void GenerateHeightField( ObjWriter& writer, const std::string& text, const ObjGeneratorOptions& options )
+	{
+		for ( unsigned int row = 0; text.size() < options.targetBytes || row < 2; ++row )
+		{
+			for ( unsigned int column = 0; column < GRID_WIDTH; ++column )
+			{
+				const float x = static_cast<float>( column );
+				const float z = static_cast<float>( row );
+
+				// normal of the height field from the partial derivatives
+				const float dx = 0.037f * std::cos( 0.37f * x ) * std::cos( 0.23f * z );
+				const float dz = -0.023f * std::sin( 0.37f * x ) * std::sin( 0.23f * z );
+				const float length = std::sqrt( dx * dx + 1.0f + dz * dz );
+
+				writer.Vertex( x, Height( x, z ), z, -dx / length, 1.0f / length, -dz / length, x / GRID_WIDTH, z / GRID_WIDTH );
+			}
+			if ( row == 0 ) continue;
+
+			const std::size_t previousRow = writer.VertexCount() - 2 * GRID_WIDTH + 1;
+			const std::size_t currentRow  = writer.VertexCount() - GRID_WIDTH + 1;
+			for ( unsigned int column = 0; column + 1 < GRID_WIDTH; ++column )
+			{
+				const std::size_t i00 = previousRow + column, i01 = i00 + 1;
+				const std::size_t i10 = currentRow + column,  i11 = i10 + 1;
+
+				if ( options.shape == Shape::Quads )
+				{
+					writer.BeginFace(); writer.Corner( i00 ); writer.Corner( i10 ); writer.Corner( i11 ); writer.Corner( i01 ); writer.EndFace();
+				}
+				else
+				{
+					writer.BeginFace(); writer.Corner( i00 ); writer.Corner( i10 ); writer.Corner( i11 ); writer.EndFace();
+					writer.BeginFace(); writer.Corner( i00 ); writer.Corner( i11 ); writer.Corner( i01 ); writer.EndFace();
+				}
+			}
+		}
+	}
+
+	// Flat regular polygons side by side in the y = 0 plane, each one with its own vertices
+	void GenerateNGons( ObjWriter& writer, const std::string& text, const ObjGeneratorOptions& options )
+	{
+		const unsigned int arity = options.ngonArity < 3 ? 3 : options.ngonArity;
+
+		for ( unsigned int polygon = 0; text.size() < options.targetBytes || polygon == 0; ++polygon )
+		{
+			const float centerX = 2.5f * static_cast<float>( polygon % GRID_WIDTH );
+			const float centerZ = 2.5f * static_cast<float>( polygon / GRID_WIDTH );
+
+			const std::size_t first = writer.VertexCount() + 1;
+			for ( unsigned int i = 0; i < arity; ++i )
+			{
+				const float angle = 2.0f * PI * static_cast<float>( i ) / static_cast<float>( arity );
+				const float radius = ( options.shape == Shape::StarNGons && i % 2 == 1 ) ? 0.5f : 1.0f;
+				const float c = radius * std::cos( angle ), s = radius * std::sin( angle );
+				writer.Vertex( centerX + c, 0.0f, centerZ - s, 0.0f, 1.0f, 0.0f, 0.5f + 0.5f * c, 0.5f + 0.5f * s );
+			}
+
+			writer.BeginFace();
+			for ( unsigned int i = 0; i < arity; ++i ) writer.Corner( first + i );
+			writer.EndFace();
+		}
+	}
+}
+
+std::string GenerateObj( const ObjGeneratorOptions& options )
+{
+	std::string text;
+	text.reserve( options.targetBytes + ( 1 << 16 ) );
+	text += "# BomberApeBench synthetic mesh\n";
+
+	ObjWriter writer( text, options.corners, options.sharedAttributes );
+	if ( options.shape == Shape::NGons || options.shape == Shape::StarNGons )
+		GenerateNGons( writer, text, options );
+	else
+		GenerateHeightField( writer, text, options );
+
+	return text;
+}
+
+const char* ShapeName( const ObjGeneratorOptions::Shape shape )
+{
+	switch ( shape )
+	{
+	case Shape::Triangles: return "triangles";
+	case Shape::Quads:     return "quads";
+	case Shape::NGons:     return "n-gons";
+	case Shape::StarNGons: return "star n-gons";
+	}
+	return "";
+}
+
+const char* CornersName( const ObjGeneratorOptions::Corners corners )
+{
+	switch ( corners )
+	{
+	case Corners::PositionTexcoordNormal: return "v/vt/vn";
+	case Corners::PositionNormal:         return "v//vn";
+	case Corners::PositionOnly:           return "v";
+	}
+	return "";
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Synthetic OBJ text for the benchmarks: a height field of triangles or quads, or a row of flat (star) n-gons,
+// written with "f v/vt/vn", "f v//vn" or "f v" corners (in the last case the parser computes the normals).
+struct ObjGeneratorOptions
+{
+	enum class Shape
+	{
+		Triangles,
+		Quads,
+		NGons,     // regular polygons with ngonArity vertices
+		StarNGons, // the same with every other vertex at half the radius, so they are not convex
+	};
+
+	enum class Corners
+	{
+		PositionTexcoordNormal, // v/vt/vn
+		PositionNormal,         // v//vn
+		PositionOnly,           // v, no vn records at all
+	};
+
+	Shape        shape       = Shape::Quads;
+	Corners      corners     = Corners::PositionTexcoordNormal;
+	unsigned int ngonArity   = 12;
+	bool         sharedAttributes = false; // a single vt and vn for every corner (flat exports often write one normal per plane)
+	std::size_t  targetBytes = 32 << 20; // the text is at least this long, it ends after a complete row / polygon
+};
+
+std::string GenerateObj( const ObjGeneratorOptions& options );
+
+const char* ShapeName( ObjGeneratorOptions::Shape shape );
+const char* CornersName( ObjGeneratorOptions::Corners corners );
@@ -0,0 +1,112 @@
+#include "Bench.h"
+#include "ObjGenerator.h"
+
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	std::filesystem::path WriteTempFile( const std::string& fileName, const std::string& text )
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BomberApeBench";
+		std::filesystem::create_directories( directory );
+
+		const std::filesystem::path path = directory / fileName;
+		std::ofstream( path, std::ios::binary ).write( text.data(), static_cast<std::streamsize>( text.size() ) );
+		return path;
+	}
+
+	bool SameMesh( const ObjParser::Mesh& a, const ObjParser::Mesh& b )
+	{
+		return a.vertexArray.size() == b.vertexArray.size() && a.indexArray == b.indexArray &&
+			std::memcmp( a.vertexArray.data(), b.vertexArray.data(), a.vertexArray.size() * sizeof( Vertex ) ) == 0;
+	}
+
+	// The fastest of repeat runs, the first one also warms up the page cache
+	ObjParser::Model ParseBest( const std::filesystem::path& path, const unsigned int threadCount, const int repeat )
+	{
+		ObjParser::Model best = ObjParser::parseModel( path, threadCount );
+		for ( int i = 1; i < repeat; ++i )
+		{
+			ObjParser::Model model = ObjParser::parseModel( path, threadCount );
+			if ( model.stats.TotalMs() < best.stats.TotalMs() ) best = std::move( model );
+		}
+		return best;
+	}
+
+	void PrintRow( const ObjGeneratorOptions& options, const ObjParser::Model& model )
+	{
+		const ObjParser::ParseStats& stats = model.stats;
+		const double seconds = stats.TotalMs() / 1000.0;
+
+		char shape[ 32 ];
+		if ( options.shape == ObjGeneratorOptions::Shape::NGons )
+			std::snprintf( shape, sizeof( shape ), "%u-gons", options.ngonArity );
+		else
+			std::snprintf( shape, sizeof( shape ), "%s", ShapeName( options.shape ) );
+
+		std::printf( "%-12s %-8s %7.1f %3u %9.1f %7.1f %9.1f %7.1f %7.1f %9.1f %8.1f %9.2f\n",
+					 shape, CornersName( options.corners ), stats.fileBytes / 1048576.0, stats.threadCount,
+					 stats.tokenizeMs, stats.mergeMs, stats.triangulateMs, stats.dedupMs, stats.groupMs, stats.TotalMs(),
+					 stats.fileBytes / 1048576.0 / seconds, stats.faceCorners / 1e6 / seconds );
+	}
+}
+
+// Every shape with every kind of corner, parsed on one thread and on threadCount threads.
+// The two results have to be identical, the parser promises the same output for any thread count.
+int RunObjParserBench( const BenchArgs& args )
+{
+	const std::size_t  targetBytes = static_cast<std::size_t>( args.Number( "size", 32.0 ) * 1048576.0 );
+	const unsigned int arity       = static_cast<unsigned int>( args.Number( "arity", 12.0 ) );
+	const int          repeat      = std::max( 1, static_cast<int>( args.Number( "repeat", 3.0 ) ) );
+
+	unsigned int threadCount = static_cast<unsigned int>( args.Number( "threads", 0.0 ) );
+	if ( threadCount == ObjParser::HARDWARE_THREADS ) threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+
+	std::printf( "%-12s %-8s %7s %3s %9s %7s %9s %7s %7s %9s %8s %9s\n",
+				 "shape", "corners", "MB", "thr", "tokenize", "merge", "triangul.", "dedup", "group", "total ms", "MB/s", "Mvert/s" );
+
+	int result = EXIT_SUCCESS;
+
+	for ( const ObjGeneratorOptions::Shape shape : { ObjGeneratorOptions::Shape::Triangles, ObjGeneratorOptions::Shape::Quads, ObjGeneratorOptions::Shape::NGons } )
+	{
+		for ( const ObjGeneratorOptions::Corners corners : { ObjGeneratorOptions::Corners::PositionTexcoordNormal,
+															 ObjGeneratorOptions::Corners::PositionNormal,
+															 ObjGeneratorOptions::Corners::PositionOnly } )
+		{
+			ObjGeneratorOptions options;
+			options.shape       = shape;
+			options.corners     = corners;
+			options.ngonArity   = arity;
+			options.targetBytes = targetBytes;
+
+			const std::filesystem::path path = WriteTempFile( "objparser.obj", GenerateObj( options ) );
+
+			const ObjParser::Model serial = ParseBest( path, 1, repeat );
+			PrintRow( options, serial );
+
+			if ( threadCount > 1 )
+			{
+				const ObjParser::Model parallel = ParseBest( path, threadCount, repeat );
+				PrintRow( options, parallel );
+
+				if ( !SameMesh( serial.mesh, parallel.mesh ) )
+				{
+					std::printf( "  FAILED: the result depends on the thread count\n" );
+					result = EXIT_FAILURE;
+				}
+			}
+
+			std::filesystem::remove( path );
+		}
+	}
+
+	return result;
+}
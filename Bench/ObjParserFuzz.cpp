@@ -0,0 +1,268 @@
+#include "Bench.h"
+
+#include "ObjParser.h"
+#include "ObjTokenizer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+
+// Structure aware fuzzing of the OBJ reader: the inputs are made of OBJ-like lines (valid, out of range, relative
+// and malformed indices, odd numbers, NaN and infinite coordinates, stray bytes), cut at a random place.
+// Each input is checked against
+//  - InMemoryTokenizer: NextFloats has to give the same bits and stop at the same place as NextToken + std::from_chars,
+//  - ObjParser::parseMemory (ParseChunk + TriangulateChunk + deduplication): every index refers to a vertex,
+//    the sub meshes cover the triangles exactly.
+// The input is copied into a buffer of exactly its size, so an address sanitizer build (/fsanitize=address)
+// also catches reads past the end. The first failing input is written to fuzz_failure.obj.
+
+namespace
+{
+	class InputGenerator
+	{
+	public:
+		explicit InputGenerator( const std::uint32_t seed ) : m_random( seed ) {}
+
+		std::string Next( const std::size_t maxSize )
+		{
+			std::string text;
+			const int lineCount = Uniform( 1, 60 );
+			for ( int i = 0; i < lineCount && text.size() < maxSize; ++i ) Line( text );
+
+			// the end of the data can be anywhere, also inside a token
+			if ( text.size() > maxSize || Chance( 4 ) ) text.resize( Uniform( 0, static_cast<int>( std::min( text.size(), maxSize ) ) ) );
+			return text;
+		}
+
+		// Only tokens the fast path of NextFloats might take, or might wrongly refuse
+		std::string Number()
+		{
+			static const char* const SPECIAL[] = { "nan", "-nan", "inf", "-inf", "1e38", "1e39", "-1e-45", "1e-50", "0x10", "+1",
+												   "16777216", "16777217", "0.1", "-0", ".5", "-.5", "5.", ".", "-", "1e", "1.5e+2", "9999999999999999999" };
+			if ( Chance( 6 ) ) return SPECIAL[ Uniform( 0, static_cast<int>( std::size( SPECIAL ) ) - 1 ) ];
+
+			std::string number;
+			if ( Chance( 3 ) ) number += '-';
+			number += Digits( Uniform( 0, 12 ) );
+			if ( Chance( 2 ) ) number += '.' + Digits( Uniform( 0, 14 ) );
+			if ( Chance( 10 ) ) number += 'e' + std::to_string( Uniform( -50, 50 ) );
+			if ( number.empty() || Chance( 30 ) ) number += static_cast<char>( Uniform( 33, 126 ) );
+			return number;
+		}
+
+		std::string Separator()
+		{
+			static const char* const SEPARATORS[] = { " ", " ", " ", "\t", "  ", " \r", "\v", "\f" };
+			return SEPARATORS[ Uniform( 0, static_cast<int>( std::size( SEPARATORS ) ) - 1 ) ];
+		}
+
+		bool Chance( const int oneIn ) { return Uniform( 1, oneIn ) == 1; }
+		int Uniform( const int low, const int high ) { return std::uniform_int_distribution<int>( low, high )( m_random ); }
+
+	private:
+		std::string Digits( const int count )
+		{
+			std::string digits;
+			for ( int i = 0; i < count; ++i ) digits += static_cast<char>( '0' + Uniform( 0, 9 ) );
+			return digits;
+		}
+
+		std::string Index()
+		{
+			switch ( Uniform( 0, 9 ) )
+			{
+			case 0:  return "0";
+			case 1:  return std::to_string( -Uniform( 1, 10 ) );
+			case 2:  return std::to_string( Uniform( 1, 1 << 30 ) ) + ( Chance( 2 ) ? "" : "999999999" );
+			case 3:  return "";
+			default: return std::to_string( Uniform( 1, 4 ) );
+			}
+		}
+
+		void Line( std::string& text )
+		{
+			switch ( Uniform( 0, 13 ) )
+			{
+			case 0: case 1: case 2: // v x y z [w]
+			{
+				text += "v";
+				for ( int i = Uniform( 2, 4 ); i > 0; --i ) text += Separator() + Number();
+			} break;
+			case 3: text += "vn" + Separator() + Number() + Separator() + Number() + Separator() + Number(); break;
+			case 4: text += "vt" + Separator() + Number() + Separator() + Number(); break;
+			case 5: case 6: case 7: case 8: // f with 1..n corners of any form
+			{
+				text += "f";
+				const int cornerCount = Chance( 8 ) ? Uniform( 4, 40 ) : Uniform( 1, 5 );
+				const int form = Uniform( 0, 3 );
+				for ( int i = 0; i < cornerCount; ++i )
+				{
+					text += Separator() + Index();
+					if ( form == 1 || form == 3 ) text += '/' + Index();
+					if ( form == 2 ) text += "//" + Index();
+					if ( form == 3 ) text += '/' + Index();
+				}
+			} break;
+			case 9:  text += "usemtl" + Separator() + ( Chance( 3 ) ? std::string() : "mat" + std::to_string( Uniform( 0, 3 ) ) ); break;
+			case 10: text += Chance( 2 ) ? "o object" : "g group"; break;
+			case 11: text += "# comment f 1 2 3"; break;
+			case 12: text += Chance( 2 ) ? "mtllib missing.mtl" : "s 1"; break;
+			case 13: // stray bytes
+			{
+				for ( int i = Uniform( 1, 8 ); i > 0; --i ) text += static_cast<char>( Uniform( 0, 255 ) );
+			} break;
+			}
+			text += Chance( 5 ) ? "\r\n" : "\n";
+		}
+
+		std::mt19937 m_random;
+	};
+
+	// Copy with nothing readable after the last byte
+	std::unique_ptr<char[]> ExactCopy( const std::string& text )
+	{
+		std::unique_ptr<char[]> copy( new char[ std::max<std::size_t>( text.size(), 1 ) ] );
+		std::memcpy( copy.get(), text.data(), text.size() );
+		return copy;
+	}
+
+	bool SameBits( const float a, const float b )
+	{
+		return std::memcmp( &a, &b, sizeof( float ) ) == 0;
+	}
+
+	// NextFloats against NextToken + std::from_chars on the same data
+	bool CheckTokenizer( const char* data, const std::size_t size, const std::size_t count, std::string& failure )
+	{
+		InMemoryTokenizer fast, reference;
+		fast.SetData( data, size );
+		reference.SetData( data, size );
+
+		while ( fast && reference )
+		{
+			float fastValues[ 4 ] = { -7.0f, -7.0f, -7.0f, -7.0f };
+			float referenceValues[ 4 ] = { -7.0f, -7.0f, -7.0f, -7.0f };
+
+			fast.NextFloats( fastValues, count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				const std::string_view token = reference.NextToken();
+				if ( token.data() < data || token.data() + token.size() > data + size )
+				{
+					failure = "token outside of the data";
+					return false;
+				}
+				std::from_chars( token.data(), token.data() + token.size(), referenceValues[ i ] );
+			}
+
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				if ( !SameBits( fastValues[ i ], referenceValues[ i ] ) )
+				{
+					char message[ 128 ];
+					std::snprintf( message, sizeof( message ), "NextFloats gave %.9g, std::from_chars %.9g", fastValues[ i ], referenceValues[ i ] );
+					failure = message;
+					return false;
+				}
+			}
+			if ( fast.NextToken() != reference.NextToken() )
+			{
+				failure = "NextFloats stopped at a different place than NextToken";
+				return false;
+			}
+		}
+		if ( static_cast<bool>( fast ) != static_cast<bool>( reference ) )
+		{
+			failure = "NextFloats and NextToken reached the end at different places";
+			return false;
+		}
+		return true;
+	}
+
+	bool CheckModel( const ObjParser::Model& model, std::string& failure )
+	{
+		const ObjParser::Mesh& mesh = model.mesh;
+
+		if ( mesh.indexArray.size() % 3 != 0 )
+		{
+			failure = "the index count is not a multiple of 3";
+			return false;
+		}
+		if ( std::any_of( mesh.indexArray.cbegin(), mesh.indexArray.cend(), [ &mesh ]( const GLuint index ) { return index >= mesh.vertexArray.size(); } ) )
+		{
+			failure = "an index refers to a missing vertex";
+			return false;
+		}
+
+		std::size_t indexOffset = 0;
+		for ( const ObjParser::SubMesh& subMesh : model.subMeshes )
+		{
+			if ( subMesh.indexOffset != indexOffset || subMesh.materialId >= model.materials.size() )
+			{
+				failure = "the sub meshes do not cover the triangles in order";
+				return false;
+			}
+			indexOffset += subMesh.indexCount;
+		}
+		if ( indexOffset != mesh.indexArray.size() )
+		{
+			failure = "the sub meshes do not cover all triangles";
+			return false;
+		}
+		return true;
+	}
+}
+
+int RunObjParserFuzz( const BenchArgs& args )
+{
+	const long long    iterations = static_cast<long long>( args.Number( "iterations", 100000.0 ) );
+	const std::uint32_t seed      = static_cast<std::uint32_t>( args.Number( "seed", 1.0 ) );
+	const std::size_t  maxSize    = static_cast<std::size_t>( args.Number( "maxsize", 4096.0 ) );
+
+	InputGenerator generator( seed );
+	std::size_t invalidFaces = 0;
+	std::size_t triangles = 0;
+
+	for ( long long iteration = 0; iteration < iterations; ++iteration )
+	{
+		// every 4th input is a bare list of numbers for the tokenizer
+		std::string text;
+		if ( iteration % 4 == 0 )
+		{
+			for ( int i = generator.Uniform( 1, 40 ); i > 0; --i ) text += generator.Number() + ( generator.Chance( 6 ) ? "\n" : generator.Separator() );
+		}
+		else
+		{
+			text = generator.Next( maxSize );
+		}
+
+		const std::unique_ptr<char[]> data = ExactCopy( text );
+
+		std::string failure;
+		bool passed = CheckTokenizer( data.get(), text.size(), static_cast<std::size_t>( 1 + iteration % 3 ), failure );
+		if ( passed )
+		{
+			const ObjParser::Model model = ObjParser::parseMemory( data.get(), text.size() );
+			passed = CheckModel( model, failure );
+			invalidFaces += model.stats.invalidFaces;
+			triangles += model.mesh.indexArray.size() / 3;
+		}
+
+		if ( !passed )
+		{
+			std::ofstream( "fuzz_failure.obj", std::ios::binary ).write( text.data(), static_cast<std::streamsize>( text.size() ) );
+			std::printf( "FAILED at iteration %lld (seed %u): %s\nThe input is in fuzz_failure.obj\n", iteration, seed, failure.c_str() );
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::printf( "%lld inputs passed (seed %u): %zu triangles, %zu faces dropped for invalid indices\n", iterations, seed, triangles, invalidFaces );
+	return EXIT_SUCCESS;
+}
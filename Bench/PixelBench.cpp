@@ -0,0 +1,136 @@
+#include "Bench.h"
+
+#include "PixelPipeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The CPU work of loading a texture on images of the size of ours (1-2 MB of RGBA texels),
+// the current PixelPipeline against the code it replaced: a copy of the whole surface
+// (SDL_ConvertSurfaceFormat ran even for RGBA sources) followed by a flip with a XOR swap per texel.
+
+namespace
+{
+	// The flip ImageFromFile used to do, copied from the old GLUtils.cpp
+	void InvertImageRGBA( const int pitchInPixels, const int height, std::uint32_t* imagePixels )
+	{
+		const int heightDiv2 = height / 2;
+		std::uint32_t* lowerData  = imagePixels;
+		std::uint32_t* higherData = imagePixels + ( height - 1 ) * pitchInPixels;
+
+		for ( int index = 0; index < heightDiv2; index++ )
+		{
+			for ( int rowIndex = 0; rowIndex < pitchInPixels; rowIndex++ )
+			{
+				*lowerData ^= higherData[ rowIndex ];
+				higherData[ rowIndex ] ^= *lowerData;
+				*lowerData ^= higherData[ rowIndex ];
+
+				lowerData++;
+			}
+			higherData -= pitchInPixels;
+		}
+	}
+
+	// A decoded surface: smooth colors and an alpha falling off from the center, like the explosion sprite
+	std::vector<std::uint32_t> MakeSurface( const int width, const int height )
+	{
+		std::vector<std::uint32_t> pixels( static_cast<std::size_t>( width ) * height );
+		for ( int y = 0; y < height; ++y )
+		{
+			for ( int x = 0; x < width; ++x )
+			{
+				const int dx = x - width / 2, dy = y - height / 2;
+				const int distance = std::min( 255, ( dx * dx + dy * dy ) * 255 / ( width * width / 4 ) );
+				const std::uint32_t r = x * 255 / width, g = y * 255 / height, b = ( x ^ y ) & 0xFF, a = 255 - distance;
+				pixels[ static_cast<std::size_t>( y ) * width + x ] = r | ( g << 8 ) | ( b << 16 ) | ( a << 24 );
+			}
+		}
+		return pixels;
+	}
+
+	// The fastest of repeat runs of func, in ms
+	template <typename Func>
+	double BestMs( const int repeat, Func&& func )
+	{
+		double best = 0.0;
+		for ( int i = 0; i < repeat; ++i )
+		{
+			Stopwatch stopwatch;
+			func();
+			const double ms = stopwatch.ElapsedMs();
+			if ( i == 0 || ms < best ) best = ms;
+		}
+		return best;
+	}
+
+	void PrintRow( const char* name, const double ms, const double megabytes, const double baselineMs )
+	{
+		std::printf( "  %-34s %9.3f ms %9.0f MB/s", name, ms, megabytes / ( ms / 1000.0 ) );
+		if ( baselineMs > 0.0 ) std::printf( " %7.2fx", baselineMs / ms );
+		std::printf( "\n" );
+	}
+}
+
+int RunPixelBench( const BenchArgs& args )
+{
+	const int repeat = std::max( 1, static_cast<int>( args.Number( "repeat", 20.0 ) ) );
+
+	static const int SIZES[][ 2 ] = { { 512, 512 }, { 1024, 512 }, { 724, 724 } };
+
+	int result = EXIT_SUCCESS;
+
+	for ( const auto& size : SIZES )
+	{
+		const int width = size[ 0 ], height = size[ 1 ];
+		const std::vector<std::uint32_t> surface = MakeSurface( width, height );
+		const double megabytes = surface.size() * sizeof( std::uint32_t ) / 1048576.0;
+		const int pitch = width * static_cast<int>( sizeof( std::uint32_t ) );
+
+		std::printf( "%d x %d RGBA, %.2f MB\n", width, height, megabytes );
+
+		// old: converted copy, then the XOR flip in place
+		std::vector<std::uint32_t> converted;
+		const double oldMs = BestMs( repeat, [ & ]()
+		{
+			converted.assign( surface.cbegin(), surface.cend() );
+			InvertImageRGBA( width, height, converted.data() );
+		} );
+		PrintRow( "copy + XOR flip (old)", oldMs, megabytes, 0.0 );
+
+		// new: one pass, the rows are copied in reverse order
+		ImageRGBA image;
+		const double copyRowsMs = BestMs( repeat, [ & ]() { PixelPipeline::CopyRows( image, surface.data(), width, height, pitch, true ); } );
+		PrintRow( "PixelPipeline::CopyRows, flipped", copyRowsMs, megabytes, oldMs );
+
+		if ( image.pixels != converted )
+		{
+			std::printf( "  FAILED: CopyRows does not give the same image as the old flip\n" );
+			result = EXIT_FAILURE;
+		}
+
+		ImageRGBA premultiplied;
+		const double premultiplyMs = BestMs( repeat, [ & ]()
+		{
+			premultiplied = image;
+			PixelPipeline::PremultiplyAlpha( premultiplied );
+		} );
+		PrintRow( "PremultiplyAlpha (with a copy)", premultiplyMs, megabytes, 0.0 );
+
+		for ( const bool srgb : { true, false } )
+		{
+			std::size_t levelCount = 0;
+			const double mipMs = BestMs( std::max( 1, repeat / 4 ), [ & ]() { levelCount = PixelPipeline::BuildMipChain( image, srgb ).size(); } );
+
+			char name[ 64 ];
+			std::snprintf( name, sizeof( name ), "BuildMipChain, %s, %zu levels", srgb ? "sRGB" : "linear", levelCount );
+			PrintRow( name, mipMs, megabytes, 0.0 );
+		}
+	}
+
+	return result;
+}
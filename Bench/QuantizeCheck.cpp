@@ -0,0 +1,143 @@
+#include "Bench.h"
+
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// VertexQuantization against the bounds documented in VertexQuantization.h, on random vertices in an off-center box
+// with one flat axis, plus the normals that are easy to get wrong: the 6 axes, the octahedron edges and corners,
+// normals that are not unit length, and ones without a direction (zero length, NaN).
+
+namespace
+{
+	constexpr float SNORM16_MAX = 32767.0f;
+
+	// half float rounding: 11 significant bits for normal values, a fixed step of 2^-24 for subnormal ones
+	float HalfFloatBound( const float value )
+	{
+		return std::max( std::abs( value ) * std::ldexp( 1.0f, -11 ), std::ldexp( 1.0f, -25 ) );
+	}
+
+	std::vector<Vertex> MakeVertices()
+	{
+		std::mt19937 random( 1234 );
+		std::uniform_real_distribution<float> unit( -1.0f, 1.0f );
+
+		const glm::vec3 center( 100.0f, -5.0f, 0.25f );
+		const glm::vec3 halfExtent( 20.0f, 0.01f, 0.0f ); // z is flat
+
+		std::vector<Vertex> vertices;
+		auto add = [ & ]( const glm::vec3& normal )
+		{
+			const glm::vec3 position = center + halfExtent * glm::vec3( unit( random ), unit( random ), unit( random ) );
+			const glm::vec2 texcoord( 4.0f * unit( random ), std::ldexp( unit( random ), -20 ) ); // y is tiny, often subnormal as a half
+			vertices.push_back( { position, normal, texcoord } );
+		};
+
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			for ( const float sign : { 1.0f, -1.0f } )
+			{
+				glm::vec3 normal( 0.0f );
+				normal[ axis ] = sign;
+				add( normal );
+			}
+		}
+		for ( const float x : { -1.0f, 0.0f, 1.0f } )
+			for ( const float y : { -1.0f, 0.0f, 1.0f } )
+				for ( const float z : { -1.0f, 0.0f, 1.0f } )
+					if ( x != 0.0f || y != 0.0f || z != 0.0f ) add( glm::normalize( glm::vec3( x, y, z ) ) );
+
+		for ( int i = 0; i < 100000; ++i )
+		{
+			glm::vec3 normal( unit( random ), unit( random ), unit( random ) );
+			if ( glm::length( normal ) < 1e-3f ) continue;
+			// every 4th one is not unit length
+			add( ( i % 4 == 0 ) ? normal * 5.0f : glm::normalize( normal ) );
+		}
+
+		// the corners of the box, so the quantization uses exactly this box
+		for ( const float sign : { 1.0f, -1.0f } )
+			vertices.push_back( { center + sign * halfExtent, glm::vec3( 0, 0, 1 ), glm::vec2( 0.0f ) } );
+
+		return vertices;
+	}
+}
+
+bool CheckVertexQuantization( std::string& failure )
+{
+	const std::vector<Vertex> vertices = MakeVertices();
+	const MeshView<Vertex> mesh = { vertices.data(), vertices.size(), nullptr, 0 };
+	const QuantizedMesh quantized = VertexQuantization::QuantizeMesh( mesh );
+
+	// the positions: half a snorm16 step of the box per axis, plus the float rounding of the decoding
+	for ( std::size_t i = 0; i < vertices.size(); ++i )
+	{
+		const glm::vec3 decoded = VertexQuantization::DecodePosition( quantized.mesh.vertexArray[ i ].position, quantized.center, quantized.halfExtent );
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			const float rounding = 4.0f * std::numeric_limits<float>::epsilon() * ( std::abs( quantized.center[ axis ] ) + quantized.halfExtent[ axis ] );
+			const float bound = quantized.halfExtent[ axis ] / SNORM16_MAX / 2.0f + rounding;
+			if ( std::abs( decoded[ axis ] - vertices[ i ].position[ axis ] ) > bound )
+			{
+				failure = "position " + std::to_string( i ) + " axis " + std::to_string( axis ) + " is off by "
+						+ std::to_string( std::abs( decoded[ axis ] - vertices[ i ].position[ axis ] ) ) + ", bound " + std::to_string( bound );
+				return false;
+			}
+		}
+
+		const glm::vec2 texcoord = VertexQuantization::DecodeTexcoord( quantized.mesh.vertexArray[ i ].texcoord );
+		for ( int c = 0; c < 2; ++c )
+		{
+			if ( std::abs( texcoord[ c ] - vertices[ i ].texcoord[ c ] ) > HalfFloatBound( vertices[ i ].texcoord[ c ] ) )
+			{
+				failure = "texcoord " + std::to_string( i ) + " is off by " + std::to_string( std::abs( texcoord[ c ] - vertices[ i ].texcoord[ c ] ) );
+				return false;
+			}
+		}
+	}
+
+	const QuantizationError error = VertexQuantization::MeasureError( mesh, quantized );
+	const float maxNormalAngle = glm::radians( 0.005f );
+	if ( error.normalAngle > maxNormalAngle )
+	{
+		failure = "normal angle error of " + std::to_string( glm::degrees( error.normalAngle ) ) + " degrees";
+		return false;
+	}
+	if ( error.position > glm::length( quantized.halfExtent ) / SNORM16_MAX / 2.0f * 1.001f )
+	{
+		failure = "MeasureError reports a position error of " + std::to_string( error.position );
+		return false;
+	}
+
+	// the axes are corners or edge midpoints of the octahedron, they have to come back exactly
+	for ( std::size_t i = 0; i < 6; ++i )
+	{
+		if ( VertexQuantization::DecodeNormal( quantized.mesh.vertexArray[ i ].normal ) != vertices[ i ].normal )
+		{
+			failure = "the axis normal " + std::to_string( i ) + " does not decode exactly";
+			return false;
+		}
+	}
+
+	// no direction: encoded is written (it starts as garbage here) and decodes to a unit vector
+	for ( const glm::vec3 normal : { glm::vec3( 0.0f ), glm::vec3( -0.0f, 0.0f, -0.0f ), glm::vec3( std::numeric_limits<float>::quiet_NaN() ) } )
+	{
+		int16_t encoded[ 2 ] = { 12345, -12345 };
+		VertexQuantization::EncodeNormal( normal, encoded );
+		const glm::vec3 decoded = VertexQuantization::DecodeNormal( encoded );
+		if ( encoded[ 0 ] == 12345 || encoded[ 1 ] == -12345 || !( std::abs( glm::length( decoded ) - 1.0f ) < 1e-6f ) )
+		{
+			failure = "a normal without a direction is encoded as " + std::to_string( encoded[ 0 ] ) + ", " + std::to_string( encoded[ 1 ] );
+			return false;
+		}
+	}
+
+	return true;
+}
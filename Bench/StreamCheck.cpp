@@ -0,0 +1,167 @@
+#include "Bench.h"
+#include "ObjGenerator.h"
+
+#include "ObjParser.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// ObjParser::parseStream against parseModel on files of 1-2 MB with memory budgets of 64 KB to 4 MB (windows of 1 KB to 64 KB):
+// the batches, with their indices offset by baseVertex, have to give the same triangles as parseModel.
+// The vertex arrays themselves differ (parseStream only deduplicates inside a batch), so the triangles are
+// compared corner by corner. The peak memory has to stay within the budget, and with the smallest budget
+// the attributes do not fit into the cache, so they are read back from the temporary file.
+// The n-gon lines of the v-only case are longer than the smallest window, which has to throw EXC_LINETOOLONG.
+
+namespace
+{
+	bool SameVertex( const Vertex& a, const Vertex& b )
+	{
+		return std::memcmp( &a, &b, sizeof( Vertex ) ) == 0;
+	}
+
+	bool CompareStream( const std::filesystem::path& path, const ObjParser::Mesh& model, const std::size_t memoryBudget, const std::size_t maxBatchVertices,
+						ObjParser::StreamStats& stats, std::string& failure )
+	{
+		std::vector<Vertex> vertices; // the vertex arrays of the batches one after the other, like in a GPU buffer
+		std::size_t corner = 0;
+		std::size_t batchCount = 0;
+		bool passed = true;
+
+		stats = ObjParser::parseStream( path, [ & ]( const ObjParser::Mesh& batch, const GLuint baseVertex )
+		{
+			++batchCount;
+			if ( !passed ) return;
+
+			if ( baseVertex != vertices.size() || batch.vertexArray.size() > maxBatchVertices || batch.indexArray.size() % 3 != 0 )
+			{
+				failure = "batch " + std::to_string( batchCount ) + ": wrong baseVertex, size or index count";
+				passed = false;
+				return;
+			}
+			vertices.insert( vertices.end(), batch.vertexArray.cbegin(), batch.vertexArray.cend() );
+
+			for ( const GLuint index : batch.indexArray )
+			{
+				const std::size_t vertex = baseVertex + index;
+				if ( index >= batch.vertexArray.size() || corner >= model.indexArray.size() || !SameVertex( vertices[ vertex ], model.vertexArray[ model.indexArray[ corner ] ] ) )
+				{
+					failure = "triangle " + std::to_string( corner / 3 ) + " differs from parseModel";
+					passed = false;
+					return;
+				}
+				++corner;
+			}
+		}, memoryBudget, maxBatchVertices );
+
+		if ( passed && corner != model.indexArray.size() )
+		{
+			failure = std::to_string( corner / 3 ) + " triangles instead of " + std::to_string( model.indexArray.size() / 3 );
+			passed = false;
+		}
+		if ( passed && stats.peakBytes > memoryBudget )
+		{
+			failure = "peak memory of " + std::to_string( stats.peakBytes ) + " bytes";
+			passed = false;
+		}
+		if ( !passed )
+		{
+			failure += " (budget " + std::to_string( memoryBudget ) + " bytes, batches of " + std::to_string( maxBatchVertices ) + " vertices)";
+		}
+		return passed;
+	}
+}
+
+bool CheckParseStream( std::string& failure )
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BomberApeBench";
+	std::filesystem::create_directories( directory );
+	const std::filesystem::path path = directory / "stream.obj";
+
+	struct Case
+	{
+		ObjGeneratorOptions::Shape   shape;
+		ObjGeneratorOptions::Corners corners;
+		unsigned int                 ngonArity;
+	};
+	static const Case CASES[] =
+	{
+		{ ObjGeneratorOptions::Shape::Quads,     ObjGeneratorOptions::Corners::PositionTexcoordNormal, 0 },
+		{ ObjGeneratorOptions::Shape::Triangles, ObjGeneratorOptions::Corners::PositionNormal,         0 },
+		{ ObjGeneratorOptions::Shape::StarNGons, ObjGeneratorOptions::Corners::PositionOnly,           300 },
+	};
+
+	for ( const Case& testCase : CASES )
+	{
+		ObjGeneratorOptions options;
+		options.shape       = testCase.shape;
+		options.corners     = testCase.corners;
+		options.ngonArity   = testCase.ngonArity;
+		options.targetBytes = 3 << 19;
+
+		const std::string text = GenerateObj( options );
+		std::ofstream( path, std::ios::binary ).write( text.data(), static_cast<std::streamsize>( text.size() ) );
+
+		const ObjParser::Model model = ObjParser::parseModel( path );
+
+		std::size_t longestLine = 0;
+		for ( std::size_t begin = 0, end; begin < text.size(); begin = end + 1 )
+		{
+			end = std::min( text.find( '\n', begin ), text.size() );
+			longestLine = std::max( longestLine, end + 1 - begin );
+		}
+
+		bool hasSpilled = false;
+		for ( const std::size_t memoryBudget : { std::size_t( 64 ) << 10, std::size_t( 256 ) << 10, std::size_t( 4 ) << 20 } )
+		{
+			for ( const std::size_t maxBatchVertices : { std::size_t( 3 ), std::size_t( 1000 ), std::size_t( 1 ) << 16 } )
+			{
+				const std::string caseName = std::string( ShapeName( options.shape ) ) + " " + CornersName( options.corners ) + ": ";
+				ObjParser::StreamStats stats;
+
+				if ( longestLine > memoryBudget / 64 ) // the window size documented in ObjParser.h
+				{
+					bool hasThrown = false;
+					try
+					{
+						ObjParser::parseStream( path, []( const ObjParser::Mesh&, GLuint ) {}, memoryBudget, maxBatchVertices );
+					}
+					catch ( const ObjParser::Exception exception )
+					{
+						hasThrown = ( exception == ObjParser::EXC_LINETOOLONG );
+					}
+					if ( !hasThrown )
+					{
+						failure = caseName + "a line of " + std::to_string( longestLine ) + " bytes did not throw EXC_LINETOOLONG with a budget of "
+								+ std::to_string( memoryBudget ) + " bytes";
+						std::filesystem::remove( path );
+						return false;
+					}
+					continue;
+				}
+
+				if ( !CompareStream( path, model.mesh, memoryBudget, maxBatchVertices, stats, failure ) )
+				{
+					failure = caseName + failure;
+					std::filesystem::remove( path );
+					return false;
+				}
+				hasSpilled = hasSpilled || stats.spilledBytes > 0;
+			}
+		}
+
+		if ( !hasSpilled )
+		{
+			failure = std::string( ShapeName( options.shape ) ) + " " + CornersName( options.corners ) + ": the attributes were never spilled to disk";
+			std::filesystem::remove( path );
+			return false;
+		}
+	}
+
+	std::filesystem::remove( path );
+	return true;
+}
@@ -0,0 +1,66 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Benchmarks and checks of the CPU side of the loaders and the texture pipeline, no window or OpenGL context is created.
+//
+//   BomberApeBench <command> [--name value]...
+//
+// The numbers are only comparable between runs on the same machine, build the Release configuration for measuring.
+
+struct Command
+{
+	const char* name;
+	int ( *run )( const BenchArgs& args );
+	const char* description;
+};
+
+static const Command COMMANDS[] =
+{
+	{ "objparser", RunObjParserBench, "ObjParser::parseModel on synthetic files: --size <MB> --threads <n> --arity <n> --repeat <n>" },
+	{ "fuzz",      RunObjParserFuzz,  "random OBJ text through the tokenizer and the parser: --iterations <n> --seed <n> --maxsize <bytes>" },
+	{ "dedup",     RunDedupBench,     "vertex deduplication with one shared vt and vn, against std::unordered_map: --size <MB> --oldlimit <corners> --repeat <n>" },
+	{ "ngon",      RunNGonBench,      "triangulation of single convex and star n-gons of 10 to 100k vertices: --max <vertices> --repeat <n>" },
+	{ "pixels",    RunPixelBench,     "texture flip, premultiplied alpha and mip chain on 1-2 MB images, against the old copy + XOR flip: --repeat <n>" },
+	{ "check",     RunChecks,         "correctness checks of the CPU modules, exits with 1 if one fails: --only <name>" },
+};
+
+BenchArgs::BenchArgs( int argc, char* argv[] )
+	: m_args( argv + std::min( argc, 2 ), argv + argc )
+{
+}
+
+double BenchArgs::Number( std::string_view name, double defaultValue ) const
+{
+	const std::string value = Text( name, std::string_view() );
+	return value.empty() ? defaultValue : std::atof( value.c_str() );
+}
+
+std::string BenchArgs::Text( std::string_view name, std::string_view defaultValue ) const
+{
+	for ( std::size_t i = 0; i + 1 < m_args.size(); ++i )
+	{
+		if ( m_args[ i ].size() == name.size() + 2 && m_args[ i ].compare( 0, 2, "--" ) == 0 && m_args[ i ].compare( 2, std::string::npos, name ) == 0 )
+			return m_args[ i + 1 ];
+	}
+	return std::string( defaultValue );
+}
+
+int main( int argc, char* argv[] )
+{
+	if ( argc >= 2 )
+	{
+		for ( const Command& command : COMMANDS )
+		{
+			if ( std::strcmp( argv[ 1 ], command.name ) == 0 ) return command.run( BenchArgs( argc, argv ) );
+		}
+	}
+
+	std::printf( "Usage: %s <command> [--name value]...\n\n", argc > 0 ? argv[ 0 ] : "BomberApeBench" );
+	for ( const Command& command : COMMANDS ) std::printf( "  %-10s %s\n", command.name, command.description );
+
+	return argc >= 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
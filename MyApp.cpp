@@ -1,10 +1,17 @@
 #include "MyApp.h"
 #include "SDL_GLDebugMessageCallback.h"
 #include "ObjParser.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include "TextureCache.h"
 #include "ParametricSurfaceMesh.hpp"
 
 #include <imgui.h>
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
 
 CMyApp::CMyApp()
 {
@@ -27,22 +34,63 @@ void CMyApp::SetupDebugCallback()
 	}
 }
 
+// a programok shader fájljai, az InitShaders és a hot reload is ezeket használja
+static const char* const MAIN_VS_FILE   = "Shaders/Vert_PosNormTex.vert";
+static const char* const MAIN_FS_FILE   = "Shaders/Frag_ZH.frag";
+static const char* const SKYBOX_VS_FILE = "Shaders/Vert_skybox.vert";
+static const char* const SKYBOX_FS_FILE = "Shaders/Frag_skybox.frag";
+static const char* const LIGHTING_FILE  = "Shaders/Lighting.glsl"; // a MAIN_FS_FILE include-olja
+static const char* const UNIFORMS_FILE  = "Shaders/Uniforms.glsl"; // minden shader include-olja
+
+std::vector<std::string> CMyApp::LitVariantDefines( int variant )
+{
+	std::vector<std::string> defines;
+	if ( variant & LIT_POINT_LIGHT ) defines.push_back( "POINT_LIGHT" );
+	if ( variant & LIT_SPECULAR )    defines.push_back( "SPECULAR" );
+	if ( variant & LIT_ALPHA_BLEND ) defines.push_back( "ALPHA_BLEND" );
+	return defines;
+}
+
+GLuint CMyApp::LitProgram( int variant ) const
+{
+	if ( m_lightPos.w != 0.0f ) variant |= LIT_POINT_LIGHT;
+	if ( m_Ls * m_Ks == glm::vec3( 0.0f ) ) variant &= ~LIT_SPECULAR;
+	return m_programIDs[ variant ];
+}
+
 void CMyApp::InitShaders()
 {
-	m_programID = glCreateProgram();
-	AssembleProgram( m_programID, "Shaders/Vert_PosNormTex.vert", "Shaders/Frag_ZH.frag" );
+	for ( int variant = 0; variant < LIT_VARIANT_COUNT; ++variant )
+	{
+		m_programIDs[ variant ] = glCreateProgram();
+		AssembleProgram( m_programIDs[ variant ], MAIN_VS_FILE, MAIN_FS_FILE, LitVariantDefines( variant ) );
+	}
 	InitSkyboxShaders();
 }
 
 void CMyApp::InitSkyboxShaders()
 {
 	m_programSkyboxID = glCreateProgram();
-	AssembleProgram( m_programSkyboxID, "Shaders/Vert_skybox.vert", "Shaders/Frag_skybox.frag" );
+	AssembleProgram( m_programSkyboxID, SKYBOX_VS_FILE, SKYBOX_FS_FILE );
+}
+
+void CMyApp::InitShaderReloading()
+{
+	// a programok a fájljaik mentése után a háttérben fordulnak újra, a régi addig használatban marad
+	m_shaderReloader.Init();
+	for ( int variant = 0; variant < LIT_VARIANT_COUNT; ++variant )
+		m_shaderReloader.Add( m_programIDs[ variant ], MAIN_VS_FILE, MAIN_FS_FILE, LitVariantDefines( variant ), { LIGHTING_FILE, UNIFORMS_FILE } );
+	m_shaderReloader.Add( m_programSkyboxID, SKYBOX_VS_FILE, SKYBOX_FS_FILE, {}, { UNIFORMS_FILE } );
 }
 
 void CMyApp::CleanShaders()
 {
-	glDeleteProgram( m_programID );
+	m_shaderReloader.Clean();
+	for ( GLuint& programID : m_programIDs )
+	{
+		glDeleteProgram( programID );
+		programID = 0;
+	}
 	CleanSkyboxShaders();
 }
 
@@ -98,7 +146,7 @@ struct Henger
 	}
 };
 
-void CMyApp::InitGeometry()
+void CMyApp::InitGeometry( AssetLoader& assetLoader )
 {
 
 	const std::initializer_list<VertexAttributeDescriptor> vertexAttribList =
@@ -108,18 +156,28 @@ void CMyApp::InitGeometry()
 		{ 2, offsetof( Vertex, texcoord ), 2, GL_FLOAT },
 	};
 
+	// kezdő méretek a pálya geometriájához, ha egy mesh nem fér el, a puffer megnő
+	m_quantizedGeometry.Init<VertexQuantized>( VERTEX_QUANTIZED_ATTRIBUTES, 1 << 16, 1 << 18 );
+	m_vertexGeometry.Init<Vertex>( vertexAttribList, 1 << 12, 1 << 14 );
+
 	// Suzanne
 
-	MeshObject<Vertex> suzanneMeshCPU = ObjParser::parse("Assets/Suzanne.obj");
-	m_SuzanneGPU = CreateGLObjectFromMesh( suzanneMeshCPU, vertexAttribList );
+	// az OBJ fájlokat csak akkor dolgozzuk fel újra, ha a bináris cache-ük elavult;
+	// a betöltés háttérszálon fut, amíg itt a többi geometria készül
+	LoadModel( assetLoader, "Assets/Suzanne.obj", m_SuzanneGPU, m_SuzanneDequantization, m_SuzanneMaterials );
 
 	//Hardhat
-	MeshObject<Vertex> hardhatMeshCPU = ObjParser::parse("Assets/hardhat.obj");
-	m_HardhatGPU = CreateGLObjectFromMesh(hardhatMeshCPU, vertexAttribList);
+	LoadModel( assetLoader, "Assets/hardhat.obj", m_HardhatGPU, m_HardhatDequantization, m_HardhatMaterials );
 
 	// Parametrikus felület
 	MeshObject<Vertex> hengerMeshCPU = GetParamSurfMesh( Henger() );
-	m_HengerGPU = CreateGLObjectFromMesh( hengerMeshCPU, vertexAttribList );
+	// a rácsot soronként indexeljük, a vertex cache-nek jobb sorrendet keresünk
+	const MeshOptimizer::Report hengerReport = MeshOptimizer::Optimize( hengerMeshCPU );
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"Henger vertex cache ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+					hengerReport.before.acmr, hengerReport.after.acmr, hengerReport.before.atvr, hengerReport.after.atvr );
+	m_HengerGPU = m_vertexGeometry.Allocate( hengerMeshCPU );
 
 	MeshObject<Vertex> tileCPU;
 	tileCPU.vertexArray = {
@@ -133,7 +191,7 @@ void CMyApp::InitGeometry()
 		2, 1, 3,
 	};
 
-	m_TileGPU = CreateGLObjectFromMesh(tileCPU, vertexAttribList);
+	m_TileGPU = m_vertexGeometry.Allocate(tileCPU);
 
 	MeshObject<Vertex> wallCPU;
 	wallCPU.vertexArray = {
@@ -147,7 +205,7 @@ void CMyApp::InitGeometry()
 		2, 1, 3,
 	};
 
-	m_WallGPU = CreateGLObjectFromMesh(wallCPU, vertexAttribList);
+	m_WallGPU = m_vertexGeometry.Allocate(wallCPU);
 
 	// Skybox
 	InitSkyboxGeometry();
@@ -155,12 +213,14 @@ void CMyApp::InitGeometry()
 
 void CMyApp::CleanGeometry()
 {
-	CleanOGLObject( m_SuzanneGPU );
-	CleanOGLObject( m_surfaceGPU );
-	CleanOGLObject(m_HardhatGPU);
-	CleanOGLObject(m_HengerGPU);
-	CleanOGLObject(m_TileGPU);
-	CleanOGLObject(m_WallGPU);
+	// a meshek az arénák pufferjeivel együtt szűnnek meg
+	m_quantizedGeometry.Clean();
+	m_vertexGeometry.Clean();
+	m_SuzanneGPU = {};
+	m_HardhatGPU = {};
+	m_HengerGPU = {};
+	m_TileGPU = {};
+	m_WallGPU = {};
 	CleanSkyboxGeometry();
 }
 
@@ -206,75 +266,184 @@ void CMyApp::InitSkyboxGeometry()
 		}
 	};
 
-	m_SkyboxGPU = CreateGLObjectFromMesh( skyboxCPU, { { 0, offsetof( glm::vec3,x ), 3, GL_FLOAT } } );
+	m_skyboxGeometry.Init<glm::vec3>( { { 0, offsetof( glm::vec3,x ), 3, GL_FLOAT } }, skyboxCPU.vertexArray.size(), skyboxCPU.indexArray.size() * sizeof( GLushort ) );
+	m_SkyboxGPU = m_skyboxGeometry.Allocate( skyboxCPU );
 }
 
 void CMyApp::CleanSkyboxGeometry()
 {
-	CleanOGLObject( m_SkyboxGPU );
+	m_skyboxGeometry.Clean();
+	m_SkyboxGPU = {};
 }
 
-void CMyApp::InitTextures()
+// 2D textúra a TextureCache-ből: a kép betöltése és a mipmapek háttérszálon készülnek (vagy a cache-ből jönnek),
+// a GL szál csak lefoglalja a megváltoztathatatlan tárolót és feltölti a szinteket
+// premultiplyAlpha: előre szorzott alfa, GL_ONE, GL_ONE_MINUS_SRC_ALPHA keveréshez
+static void LoadTexture2D( AssetLoader& assetLoader, GLuint& textureID, const std::filesystem::path& fileName, bool premultiplyAlpha = false )
 {
-	// diffuse textures
+	glGenTextures( 1, &textureID );
+
+	TextureCache::Options options;
+	options.premultiplyAlpha = premultiplyAlpha;
+
+	assetLoader.LoadTexture( fileName, options, [ textureID ]( CachedTexture& texture )
+	{
+		const CachedTexture::Level& baseLevel = texture.levels.front();
+		TextureStorage( textureID, GL_TEXTURE_2D, static_cast<GLsizei>( texture.levels.size() ), baseLevel.width, baseLevel.height );
+
+		for ( std::size_t level = 0; level < texture.levels.size(); ++level )
+		{
+			const CachedTexture::Level& levelData = texture.levels[ level ];
+			TextureSubImage( textureID, levelData.pixels, levelData.width, levelData.height, GL_TEXTURE_2D, GL_TEXTURE_2D, static_cast<GLint>( level ) );
+		}
+		SetupTextureSampling( GL_TEXTURE_2D, textureID, MipMaps::Uploaded );
+	} );
+}
+
+// A pálya egy textúrája a textúratömb egy rétegébe, size x size méretre átméretezve (a mipmapek száma így minden rétegnél ugyanaz)
+static void LoadArenaLayer( AssetLoader& assetLoader, GLuint arrayTextureID, GLint layer, const std::filesystem::path& fileName, int size, bool premultiplyAlpha = false )
+{
+	TextureCache::Options options;
+	options.premultiplyAlpha = premultiplyAlpha;
+	options.width = size;
+	options.height = size;
+
+	assetLoader.LoadTexture( fileName, options, [ arrayTextureID, layer ]( CachedTexture& texture )
+	{
+		for ( std::size_t level = 0; level < texture.levels.size(); ++level )
+		{
+			const CachedTexture::Level& levelData = texture.levels[ level ];
+			TextureArraySubImage( arrayTextureID, levelData.pixels, levelData.width, levelData.height, layer, static_cast<GLint>( level ) );
+		}
+	} );
+}
+
+// Anyagonként egy textúra a map_Kd fájlból, 0 ha az anyagnak nincs ilyen
+static void InitMaterialTextures( AssetLoader& assetLoader, std::vector<GLuint>& textureIDs, const std::vector<ObjParser::Material>& materials )
+{
+	textureIDs.assign( materials.size(), 0 );
+	for ( std::size_t i = 0; i < materials.size(); ++i )
+	{
+		if ( materials[ i ].diffuseMap.empty() ) continue;
+
+		LoadTexture2D( assetLoader, textureIDs[ i ], materials[ i ].diffuseMap );
+	}
+}
+
+static void CleanMaterialTextures( std::vector<GLuint>& textureIDs )
+{
+	// a 0 azonosítókat a glDeleteTextures figyelmen kívül hagyja
+	glDeleteTextures( static_cast<GLsizei>( textureIDs.size() ), textureIDs.data() );
+	textureIDs.clear();
+}
+
+// a háttérszálon betöltött és kvantált OBJ modell
+struct LoadedModel
+{
+	QuantizedMesh                    quantized;
+	std::vector<MeshSimplifier::Lod> lods;
+	std::vector<ObjParser::Material> materials;
+};
 
-	glGenTextures( 1, &m_SuzanneTextureID );
-	TextureFromFile( m_SuzanneTextureID, "Assets/wood.jpg" );
-	SetupTextureSampling( GL_TEXTURE_2D, m_SuzanneTextureID );
+void CMyApp::LoadModel( AssetLoader& assetLoader, const std::filesystem::path& fileName, ArenaMesh& meshGPU, glm::mat4& dequantization, MaterialGroups& groups )
+{
+	assetLoader.Load<LoadedModel>( fileName.string(),
+		[ fileName, &pool = assetLoader.Pool() ]()
+		{
+			CachedMesh meshCPU = MeshCache::Load( fileName, &pool );
+			// a GPU-ra a fele akkora kvantált vertexek kerülnek
+			return LoadedModel{ VertexQuantization::QuantizeMesh( meshCPU.view ), std::move( meshCPU.lods ), std::move( meshCPU.materials ) };
+		},
+		[ this, &assetLoader, &meshGPU, &dequantization, &groups ]( LoadedModel& model )
+		{
+			meshGPU = m_quantizedGeometry.Allocate( model.quantized.mesh );
+			dequantization = model.quantized.dequantization;
+			groups.lods = std::move( model.lods );
+			groups.materials = std::move( model.materials );
+
+			// az anyagok textúrái csak a modell után derülnek ki
+			InitMaterialTextures( assetLoader, groups.textureIDs, groups.materials );
+		} );
+}
 
-	glGenTextures(1, &m_tileTextureID);
-	TextureFromFile(m_tileTextureID, "Assets/grid.png");
-	SetupTextureSampling(GL_TEXTURE_2D, m_tileTextureID);
+void CMyApp::InitTextures( AssetLoader& assetLoader )
+{
+	// diffuse textures: a pálya textúrái egy textúratömb rétegeiben
 
-	glGenTextures(1, &m_wallTextureID);
-	TextureFromFile(m_wallTextureID, "Assets/wall.png");
-	SetupTextureSampling(GL_TEXTURE_2D, m_wallTextureID);
+	GLsizei arenaLevelCount = 1;
+	for ( int size = ARENA_TEXTURE_SIZE; size > 1; size /= 2 ) ++arenaLevelCount;
 
-	glGenTextures(1, &m_hardhatTextureID);
-	TextureFromFile(m_hardhatTextureID, "Assets/hat.png");
-	SetupTextureSampling(GL_TEXTURE_2D, m_hardhatTextureID);
+	glGenTextures( 1, &m_arenaTexturesID );
+	TextureArrayStorage( m_arenaTexturesID, arenaLevelCount, ARENA_TEXTURE_SIZE, ARENA_TEXTURE_SIZE, ARENA_LAYER_COUNT );
+	SetupTextureSampling( GL_TEXTURE_2D_ARRAY, m_arenaTexturesID, MipMaps::Uploaded );
 
-	glGenTextures(1, &m_dynamitTextureID);
-	TextureFromFile(m_dynamitTextureID, "Assets/dynamit.png");
-	SetupTextureSampling(GL_TEXTURE_2D, m_dynamitTextureID);
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_WOOD, "Assets/wood.jpg", ARENA_TEXTURE_SIZE );
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_TILE, "Assets/grid.png", ARENA_TEXTURE_SIZE );
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_WALL, "Assets/wall.png", ARENA_TEXTURE_SIZE );
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_HARDHAT, "Assets/hat.png", ARENA_TEXTURE_SIZE );
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_DYNAMIT, "Assets/dynamit.png", ARENA_TEXTURE_SIZE );
+	// a robbanás átlátszó, az előre szorzott alfa miatt a szűrés nem hoz be sötét szegélyt az átlátszó részekről
+	LoadArenaLayer( assetLoader, m_arenaTexturesID, ARENA_LAYER_EXPLOSION, "Assets/flames.png", ARENA_TEXTURE_SIZE, true );
 
-	glGenTextures(1, &m_explosionTextureID);
-	TextureFromFile(m_explosionTextureID, "Assets/flames.png");
-	SetupTextureSampling(GL_TEXTURE_2D, m_explosionTextureID);
+	// OBJ anyagok saját textúrái: a modellek feltöltése után (LoadModel)
 
 	// skybox texture
 
-	InitSkyboxTextures();
+	InitSkyboxTextures( assetLoader );
 }
 
 void CMyApp::CleanTextures()
 {
 	// diffuse textures
 
-	glDeleteTextures( 1, &m_SuzanneTextureID );
-	glDeleteTextures(1, &m_tileTextureID);
-	glDeleteTextures(1, &m_wallTextureID);
-	glDeleteTextures(1, &m_hardhatTextureID);
-	glDeleteTextures(1, &m_dynamitTextureID);
-	glDeleteTextures(1, &m_explosionTextureID);
+	glDeleteTextures( 1, &m_arenaTexturesID );
+
+	CleanMaterialTextures( m_SuzanneMaterials.textureIDs );
+	CleanMaterialTextures( m_HardhatMaterials.textureIDs );
 
 	// skybox texture
 
 	CleanSkyboxTextures();
 }
 
-void CMyApp::InitSkyboxTextures()
+void CMyApp::InitSkyboxTextures( AssetLoader& assetLoader )
 {
 	// skybox texture
 
 	glGenTextures( 1, &m_skyboxTextureID );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_xpos.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_X );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_xneg.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_NEGATIVE_X );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_ypos.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_Y );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_yneg.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_zpos.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_Z );
-	TextureFromFile( m_skyboxTextureID, "Assets/bunker_zneg.png", GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z );
-	SetupTextureSampling( GL_TEXTURE_CUBE_MAP, m_skyboxTextureID, false );
+	SetupTextureSampling( GL_TEXTURE_CUBE_MAP, m_skyboxTextureID, MipMaps::None );
+
+	// a lapok egymástól függetlenül töltődnek be, a cube map lapjait nem kell megfordítani, mipmap sem kell
+	const std::pair<const char*, GLenum> faces[] =
+	{
+		{ "Assets/bunker_xpos.png", GL_TEXTURE_CUBE_MAP_POSITIVE_X },
+		{ "Assets/bunker_xneg.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_X },
+		{ "Assets/bunker_ypos.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Y },
+		{ "Assets/bunker_yneg.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Y },
+		{ "Assets/bunker_zpos.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Z },
+		{ "Assets/bunker_zneg.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Z },
+	};
+
+	TextureCache::Options options;
+	options.flipVertically = false;
+	options.mipMaps = false;
+
+	// a tárolót az elsőként betöltött lap méretével foglaljuk le, a lapok egyforma méretűek
+	auto storageAllocated = std::make_shared<bool>( false );
+
+	for ( const auto& [ fileName, role ] : faces )
+	{
+		assetLoader.LoadTexture( fileName, options, [ textureID = m_skyboxTextureID, role = role, storageAllocated ]( CachedTexture& texture )
+		{
+			const CachedTexture::Level& face = texture.levels.front();
+			if ( !*storageAllocated )
+			{
+				TextureStorage( textureID, GL_TEXTURE_CUBE_MAP, 1, face.width, face.height );
+				*storageAllocated = true;
+			}
+			TextureSubImage( textureID, face.pixels, face.width, face.height, GL_TEXTURE_CUBE_MAP, role );
+		} );
+	}
 
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 }
@@ -291,9 +460,16 @@ bool CMyApp::Init()
 	// törlési szín legyen kékes
 	glClearColor(0.125f, 0.25f, 0.5f, 1.0f);
 
+	// a fájlok háttérszálakon töltődnek be, a GL szál közben a shadereket fordítja és a feltöltéseket végzi
+	AssetLoader assetLoader;
+	InitGeometry( assetLoader );
+	InitTextures( assetLoader );
 	InitShaders();
-	InitGeometry();
-	InitTextures();
+	m_frameData.Init( FRAME_DATA_SIZE );
+	assetLoader.Finish();
+	assetLoader.LogTimings();
+
+	InitShaderReloading();
 
 	//
 	// egyéb inicializálás
@@ -390,6 +566,7 @@ bool CMyApp::Init()
 
 void CMyApp::Clean()
 {
+	m_frameData.Clean();
 	CleanShaders();
 	CleanGeometry();
 	CleanTextures();
@@ -397,18 +574,73 @@ void CMyApp::Clean()
 
 void CMyApp::Update( const SUpdateInfo& updateInfo )
 {
+	m_shaderReloader.Update();
+
 	m_ElapsedTimeInSec = updateInfo.ElapsedTimeInSec;
 	m_DeltaTimeInSec = updateInfo.DeltaTimeInSec;
 
 	m_cameraManipulator.Update( updateInfo.DeltaTimeInSec );
 }
 
+void CMyApp::BindFrameUniforms()
+{
+	FrameUniforms frameUniforms = {};
+
+	// view és projekciós mátrix
+	frameUniforms.viewProj  = m_camera.GetViewProj();
+	frameUniforms.cameraPos = m_camera.GetEye();
+
+	// - Fényforrások beállítása
+	frameUniforms.lightPos = m_lightPos;
+	frameUniforms.La       = m_La;
+	frameUniforms.Ld       = m_Ld;
+	frameUniforms.Ls       = m_Ls;
+
+	frameUniforms.lightConstantAttenuation  = m_lightConstantAttenuation;
+	frameUniforms.lightLinearAttenuation    = m_lightLinearAttenuation;
+	frameUniforms.lightQuadraticAttenuation = m_lightQuadraticAttenuation;
+
+	m_frameData.BindUniforms( FRAME_UNIFORMS_BINDING, frameUniforms );
+}
+
+CMyApp::DrawUniforms CMyApp::MakeDrawUniforms( const glm::mat4& world, GLint texLayer ) const
+{
+	DrawUniforms drawUniforms = {};
+
+	// Transzformációs mátrixok
+	drawUniforms.world   = world;
+	drawUniforms.worldIT = glm::transpose( glm::inverse( world ) );
+
+	// - Anyagjellemzők beállítása
+	drawUniforms.Ka        = m_Ka;
+	drawUniforms.Kd        = m_Kd;
+	drawUniforms.Ks        = m_Ks;
+	drawUniforms.Shininess = m_Shininess;
+
+	drawUniforms.texLayer   = texLayer;
+	drawUniforms.octNormals = GL_FALSE;
+
+	return drawUniforms;
+}
+
+void CMyApp::BindDrawUniforms( const DrawUniforms& drawUniforms )
+{
+	m_frameData.BindUniforms( DRAW_UNIFORMS_BINDING, drawUniforms );
+}
+
 void CMyApp::Render()
 {
 	// töröljük a frampuffert (GL_COLOR_BUFFER_BIT)...
 	// ... és a mélységi Z puffert (GL_DEPTH_BUFFER_BIT)
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	// a gyűrűpuffer ezen képkockára jutó része (ha a GPU még olvassa, megvárjuk)
+	m_frameData.BeginFrame();
+
+	// az előző képkocka óta az ImGui, a textúra feltöltések és a hot reload is állíthatott az állapoton, ezért nem bízunk a gyorsítótárban
+	m_glState.Invalidate();
+	m_glState.ResetStats();
+
 	m_currentParam += (m_DeltaTimeInSec * m_TimeScale);
 	if (m_currentParam > m_controlPoints.size() - 1) {
 		m_currentParam = 0;
@@ -423,23 +655,19 @@ void CMyApp::Render()
 		m_lightQuadraticAttenuation = 0.3f;
 	}
 
-	// Suzanne
-
-	glBindVertexArray( m_SuzanneGPU.vaoID );
-
-	// - Textúrák beállítása, minden egységre külön
-	glActiveTexture( GL_TEXTURE0 );
-	glBindTexture( GL_TEXTURE_2D, m_SuzanneTextureID );
+	// - Uniform paraméterek: a kamera és a fényforrás az egész képkockára
+	BindFrameUniforms();
 
-	glUseProgram( m_programID );
+	// Suzanne
 
-	// - Uniform paraméterek
+	// a kvantált modellek közös VAO-ja
+	m_glState.BindVertexArray( m_quantizedGeometry.VaoID() );
 
-	// view és projekciós mátrix
-	glUniformMatrix4fv( ul("viewProj"), 1, GL_FALSE, glm::value_ptr( m_camera.GetViewProj() ) );
+	// - Textúrák beállítása: a pálya textúratömbje az egész képkockára, a rajzolások csak a réteget választják
+	m_glState.BindTexture( ARENA_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_arenaTexturesID );
 
+	m_glState.UseProgram( LitProgram( LIT_SPECULAR ) );
 
-	
 
 	// Transformációs mátrixok
 	glm::vec3 suzanneForward = EvaluatePathTangent(); // Merre nézzen a Suzanne?
@@ -471,55 +699,20 @@ void CMyApp::Render()
 	// Transzformációs mátrixok
 	//matWorld = glm::translate(EvaluatePathPosition()) * glm::rotate(glm::pi<float>()/2, glm::vec3(0,1,0)) * glm::scale(glm::vec3(0.35f, 0.35f, 0.35f));
 
-	glUniformMatrix4fv( ul( "world" ),    1, GL_FALSE, glm::value_ptr( matWorld ) );
-	glUniformMatrix4fv( ul( "worldIT" ),  1, GL_FALSE, glm::value_ptr( glm::transpose( glm::inverse( matWorld ) ) ) );
-
-	// - Fényforrások beállítása
-	glUniform3fv( ul( "cameraPos" ), 1, glm::value_ptr( m_camera.GetEye() ) );
-	glUniform4fv( ul( "lightPos" ),  1, glm::value_ptr( m_lightPos ) );
-
-	glUniform3fv( ul( "La" ),		 1, glm::value_ptr( m_La ) );
-	glUniform3fv( ul( "Ld" ),		 1, glm::value_ptr( m_Ld ) );
-	glUniform3fv( ul( "Ls" ),		 1, glm::value_ptr( m_Ls ) );
-
-	glUniform1f( ul( "lightConstantAttenuation"	 ), m_lightConstantAttenuation );
-	glUniform1f( ul( "lightLinearAttenuation"	 ), m_lightLinearAttenuation   );
-	glUniform1f( ul( "lightQuadraticAttenuation" ), m_lightQuadraticAttenuation);
-
-	// - Anyagjellemzők beállítása
-	glUniform3fv( ul( "Ka" ),		 1, glm::value_ptr( m_Ka ) );
-	glUniform3fv( ul( "Kd" ),		 1, glm::value_ptr( m_Kd ) );
-	glUniform3fv( ul( "Ks" ),		 1, glm::value_ptr( m_Ks ) );
-
-	glUniform1f( ul( "Shininess" ),	m_Shininess );
-
-
-	// - textúraegységek beállítása
-	glUniform1i( ul( "texImage" ), 0 );
+	// a kvantált pozíciókat a befoglaló dobozba kell visszaskálázni, a normálisokat nem
+	DrawUniforms suzanneUniforms = MakeDrawUniforms( matWorld, ARENA_LAYER_WOOD );
+	suzanneUniforms.world      = matWorld * m_SuzanneDequantization;
+	suzanneUniforms.octNormals = GL_TRUE;
 
-
-	
-	// Rajzolási parancs kiadása
-	glDrawElements( GL_TRIANGLES,    
-					m_SuzanneGPU.count,			 
-					GL_UNSIGNED_INT,
-					nullptr );
+	// Rajzolási parancs kiadása, anyagonként egy, a távolságnak megfelelő részletességgel
+	DrawMaterialGroups( m_SuzanneGPU, m_SuzanneMaterials, SelectLod( m_SuzanneMaterials, matWorld, m_SuzanneDequantization ), suzanneUniforms );
 	
 
 	// Hardhat
 
-	glBindVertexArray(m_HardhatGPU.vaoID);
-
-	// - Textúrák beállítása, minden egységre külön
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_hardhatTextureID);
-
-	glUseProgram(m_programID);
+	// a VAO és a program ugyanaz, mint a Suzanne-é, az állapot gyorsítótár nem hívja újra
 
-	// - Uniform paraméterek
-
-	// view és projekciós mátrix
-	glUniformMatrix4fv(ul("viewProj"), 1, GL_FALSE, glm::value_ptr(m_camera.GetViewProj()));
+	m_glState.UseProgram(LitProgram(LIT_SPECULAR));
 
 
 	// Transformációs mátrixok
@@ -549,57 +742,24 @@ void CMyApp::Render()
 	// Transzformációs mátrixok
 	//matWorld = glm::translate(EvaluatePathPosition())* glm::translate(glm::vec3(-0.075f, 0.25f, 0.5f)) *  glm::rotate(-glm::pi<float>() / 2, glm::vec3(1, 0, 0)) * glm::scale(glm::vec3(0.025f, 0.025f, 0.025f));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
-
-	// - Fényforrások beállítása
-	glUniform3fv(ul("cameraPos"), 1, glm::value_ptr(m_camera.GetEye()));
-	glUniform4fv(ul("lightPos"), 1, glm::value_ptr(m_lightPos));
-
-	glUniform3fv(ul("La"), 1, glm::value_ptr(m_La));
-	glUniform3fv(ul("Ld"), 1, glm::value_ptr(m_Ld));
-	glUniform3fv(ul("Ls"), 1, glm::value_ptr(m_Ls));
+	DrawUniforms hardhatUniforms = MakeDrawUniforms(matWorld, ARENA_LAYER_HARDHAT);
+	hardhatUniforms.world = matWorld * m_HardhatDequantization;
+	hardhatUniforms.octNormals = GL_TRUE;
 
-	glUniform1f(ul("lightConstantAttenuation"), m_lightConstantAttenuation);
-	glUniform1f(ul("lightLinearAttenuation"), m_lightLinearAttenuation);
-	glUniform1f(ul("lightQuadraticAttenuation"), m_lightQuadraticAttenuation);
-
-	// - Anyagjellemzők beállítása
-	glUniform3fv(ul("Ka"), 1, glm::value_ptr(m_Ka));
-	glUniform3fv(ul("Kd"), 1, glm::value_ptr(m_Kd));
-	glUniform3fv(ul("Ks"), 1, glm::value_ptr(m_Ks));
-
-	glUniform1f(ul("Shininess"), m_Shininess);
-
-
-	// - textúraegységek beállítása
-	glUniform1i(ul("texImage"), 0);
-
-
-
-	// Rajzolási parancs kiadása
-	glDrawElements(GL_TRIANGLES,
-		m_HardhatGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	// Rajzolási parancs kiadása, anyagonként egy, a távolságnak megfelelő részletességgel
+	DrawMaterialGroups(m_HardhatGPU, m_HardhatMaterials, SelectLod(m_HardhatMaterials, matWorld, m_HardhatDequantization), hardhatUniforms);
 
 
 
 	//Tiles
-	glBindVertexArray(m_TileGPU.vaoID);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_tileTextureID);
+	// a csempe, a falak és a dinamit közös VAO-ja
+	m_glState.BindVertexArray(m_vertexGeometry.VaoID());
 
 	matWorld = glm::translate(glm::vec3(7 + 0.5f, -0.5f, 0 + 0.5f)) * glm::rotate(-glm::pi<float>() / 2, glm::vec3(1, 0, 0)) * glm::scale(glm::vec3(7, 7, 7));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_TILE);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_TileGPU.Draw();
 
 	
 
@@ -623,33 +783,25 @@ void CMyApp::Render()
 	//
 
 	// - VAO
-	glBindVertexArray( m_SkyboxGPU.vaoID );
+	m_glState.BindVertexArray( m_skyboxGeometry.VaoID() );
 
 	// - Textura
-	glActiveTexture( GL_TEXTURE1 );
-	glBindTexture( GL_TEXTURE_CUBE_MAP, m_skyboxTextureID );
+	m_glState.BindTexture( 1, GL_TEXTURE_CUBE_MAP, m_skyboxTextureID );
 
 	// - Program
-	glUseProgram( m_programSkyboxID );
+	m_glState.UseProgram( m_programSkyboxID );
 
-	// - uniform parameterek
-	glUniformMatrix4fv( ul("viewProj"), 1, GL_FALSE, glm::value_ptr( m_camera.GetViewProj() ) );
-	glUniformMatrix4fv( ul("world"),    1, GL_FALSE, glm::value_ptr( glm::translate( m_camera.GetEye() ) ) );
-
-	// - textúraegységek beállítása
-	glUniform1i( ul( "skyboxTexture" ), 1 );
-
-	// mentsük el az előző Z-test eredményt, azaz azt a relációt, ami alapján update-eljük a pixelt.
-	GLint prevDepthFnc;
-	glGetIntegerv(GL_DEPTH_FUNC, &prevDepthFnc);
+	// - uniform parameterek: a viewProj a képkocka FrameUniforms-ában
+	BindDrawUniforms( glm::translate( m_camera.GetEye() ), -1 );
 
 	// most kisebb-egyenlőt használjunk, mert mindent kitolunk a távoli vágósíkokra
-	glDepthFunc(GL_LEQUAL);
+	m_glState.DepthFunc(GL_LEQUAL);
 
 	// Rajzolási parancs kiadása
-	glDrawElements( GL_TRIANGLES, m_SkyboxGPU.count, GL_UNSIGNED_INT, nullptr );
+	m_SkyboxGPU.Draw();
 
-	glDepthFunc(prevDepthFnc);
+	// vissza az alapértelmezett relációra; lekérdezni nem kell, a glGetIntegerv megvárná a pipeline-t
+	m_glState.DepthFunc(GL_LESS);
 
 
 	//Explosion
@@ -660,18 +812,19 @@ void CMyApp::Render()
 
 
 	// shader kikapcsolasa
-	glUseProgram( 0 );
+	m_glState.UseProgram( 0 );
 
 	// - Textúrák kikapcsolása, minden egységre külön
-	glActiveTexture( GL_TEXTURE0 );
-	glBindTexture( GL_TEXTURE_2D, 0 );
-	glActiveTexture( GL_TEXTURE1 );
-	glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
+	m_glState.BindTexture( 0, GL_TEXTURE_2D, 0 );
+	m_glState.BindTexture( 1, GL_TEXTURE_CUBE_MAP, 0 );
+	m_glState.BindTexture( ARENA_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, 0 );
 
 
 	// VAO kikapcsolása
-	glBindVertexArray( 0 );
+	m_glState.BindVertexArray( 0 );
 
+	// a gyűrűpuffer ezen része akkor írható újra, ha a GPU végzett a képkocka parancsaival
+	m_frameData.EndFrame();
 }
 
 void CMyApp::RenderGUI()
@@ -685,6 +838,13 @@ void CMyApp::RenderGUI()
 		//Time Scale
 		ImGui::SliderFloat("Time Scale", &m_TimeScale, 0, 20);
 
+		// A részletességi szint (LOD) választás küszöbe, 0 esetén mindig az eredeti modell
+		ImGui::SliderFloat("LOD pixel error", &m_lodPixelError, 0, 10);
+
+		// Az előző Render állapotváltásai: kiadott és kiszűrt hívások
+		const GLStateCache::Stats& glStateStats = m_glState.GetStats();
+		ImGui::Text("GL state calls: %u issued, %u elided", glStateStats.issued, glStateStats.elided);
+
 		// A paramétert szabályozó csúszka
 		ImGui::SliderFloat("Contorl point", &m_currentParam, 0, (float)(m_controlPoints.size() - 1));
 
@@ -715,18 +875,6 @@ void CMyApp::RenderGUI()
 	
 }
 
-GLint CMyApp::ul( const char* uniformName ) noexcept
-{
-	GLuint programID = 0;
-
-	// Kérdezzük le az aktuális programot!
-	// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glGet.xhtml
-	glGetIntegerv( GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>( &programID ) );
-	// A program és a uniform név ismeretében kérdezzük le a location-t!
-	// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glGetUniformLocation.xhtml
-	return glGetUniformLocation( programID, uniformName );
-}
-
 // https://wiki.libsdl.org/SDL2/SDL_KeyboardEvent
 // https://wiki.libsdl.org/SDL2/SDL_Keysym
 // https://wiki.libsdl.org/SDL2/SDL_Keycode
@@ -738,17 +886,15 @@ void CMyApp::KeyboardDown(const SDL_KeyboardEvent& key)
 	{
 		if ( key.keysym.sym == SDLK_F5 && key.keysym.mod & KMOD_CTRL )
 		{
-			CleanShaders();
-			InitShaders();
+			// minden program újrafordul, de csak sikeres linkelés után cseréljük le a régit
+			m_shaderReloader.ReloadAll();
 		}
 		if ( key.keysym.sym == SDLK_F1 )
 		{
-			GLint polygonModeFrontAndBack[ 2 ] = {};
-			// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glGet.xhtml
-			glGetIntegerv( GL_POLYGON_MODE, polygonModeFrontAndBack ); // Kérdezzük le a jelenlegi polygon módot! Külön adja a front és back módokat.
-			GLenum polygonMode = ( polygonModeFrontAndBack[ 0 ] != GL_FILL ? GL_FILL : GL_LINE ); // Váltogassuk FILL és LINE között!
+			// a jelenlegi polygon módot magunk tartjuk nyilván, a glGetIntegerv( GL_POLYGON_MODE ) megvárná a pipeline-t
+			m_polygonMode = ( m_polygonMode != GL_FILL ? GL_FILL : GL_LINE ); // Váltogassuk FILL és LINE között!
 			// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glPolygonMode.xhtml
-			glPolygonMode( GL_FRONT_AND_BACK, polygonMode ); // Állítsuk be az újat!
+			glPolygonMode( GL_FRONT_AND_BACK, m_polygonMode ); // Állítsuk be az újat!
 		}
 	}
 	m_cameraManipulator.KeyboardDown( key );
@@ -789,6 +935,7 @@ void CMyApp::Resize(int _w, int _h)
 {
 	glViewport(0, 0, _w, _h);
 	m_camera.SetAspect( static_cast<float>(_w) / _h );
+	m_windowHeight = _h;
 }
 
 // Le nem kezelt, egzotikus esemény kezelése
@@ -800,107 +947,112 @@ void CMyApp::OtherEvent( const SDL_Event& ev )
 }
 
 
-void CMyApp::DrawWall(glm::mat4 world) {
+std::size_t CMyApp::SelectLod( const MaterialGroups& groups, const glm::mat4& world, const glm::mat4& dequantization ) const
+{
+	// A modell befoglaló doboza a világban: a dequantization a [-1,1]^3 kockát képezi a modell dobozára
+	const glm::mat4 boxToWorld = world * dequantization;
+	const glm::vec3 boxCenter = glm::vec3( boxToWorld[ 3 ] );
+	const float boxRadius = sqrtf( glm::dot( glm::vec3( boxToWorld[ 0 ] ), glm::vec3( boxToWorld[ 0 ] ) )
+								 + glm::dot( glm::vec3( boxToWorld[ 1 ] ), glm::vec3( boxToWorld[ 1 ] ) )
+								 + glm::dot( glm::vec3( boxToWorld[ 2 ] ), glm::vec3( boxToWorld[ 2 ] ) ) );
+
+	// a doboz legközelebbi pontjának távolsága, és a modell nagyítása (a leghosszabb bázisvektor)
+	const float distance = glm::max( glm::distance( boxCenter, m_camera.GetEye() ) - boxRadius, m_camera.GetZNear() );
+	const float worldScale = glm::max( glm::length( glm::vec3( world[ 0 ] ) ), glm::max( glm::length( glm::vec3( world[ 1 ] ) ), glm::length( glm::vec3( world[ 2 ] ) ) ) );
 
-	glBindVertexArray(m_WallGPU.vaoID);
+	// modell egységnyi hiba ennyi pixel a képernyőn
+	const float errorToPixels = worldScale / distance * m_windowHeight / ( 2.0f * tanf( m_camera.GetAngle() / 2.0f ) );
+
+	return MeshSimplifier::SelectLod( groups.lods, errorToPixels, m_lodPixelError );
+}
+
+void CMyApp::DrawMaterialGroups( const ArenaMesh& meshGPU, const MaterialGroups& groups, std::size_t lod, DrawUniforms drawUniforms )
+{
+	// a VAO és a program már be van állítva, a transzformáció a drawUniforms-ban, anyagonként csak az anyagjellemzők és a textúra változik
+	const GLint defaultLayer = drawUniforms.texLayer;
+
+	for ( const ObjParser::SubMesh& subMesh : groups.lods[ lod ].subMeshes )
+	{
+		const ObjParser::Material& material = groups.materials[ subMesh.materialId ];
+		const GLuint textureID = groups.textureIDs[ subMesh.materialId ];
+
+		// az anyag saját textúrája a 0-s egységen, ha nincs ilyen, a textúratömb alapértelmezett rétege
+		if ( textureID != 0 ) m_glState.BindTexture( 0, GL_TEXTURE_2D, textureID );
+		drawUniforms.texLayer = textureID != 0 ? -1 : defaultLayer;
+
+		drawUniforms.Ka        = material.Ka;
+		drawUniforms.Kd        = material.Kd;
+		drawUniforms.Ks        = material.Ks;
+		drawUniforms.Shininess = material.Ns;
+		BindDrawUniforms( drawUniforms );
+
+		meshGPU.Draw( subMesh.indexCount, subMesh.indexOffset );
+	}
+}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_wallTextureID);
+void CMyApp::DrawWall(glm::mat4 world) {
 
 	world = world * glm::translate(glm::vec3(0.f, -0.5f, 0.f));
 	
 	//felső
 	glm::mat4 matWorld = world * glm::translate(glm::vec3(0.f, 1.f, -1.f)) * glm::rotate(-glm::pi<float>() / 2, glm::vec3(1, 0, 0));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 
 	//szemben
 	matWorld = world * glm::translate(glm::vec3(0.f, 0.f, 0.f)) * glm::rotate(glm::pi<float>() / 2, glm::vec3(1, 0, 0));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 
 	//hátul
 	matWorld = world * glm::translate(glm::vec3(-1.f, 1.f, -1.f)) * glm::rotate(-glm::pi<float>(), glm::vec3(0, 1, 0));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 
 
 	//jobb
 	matWorld = world * glm::translate(glm::vec3(0.f, 1.f, -1.f)) * glm::rotate(glm::pi<float>() / 2, glm::vec3(0, 1, 0));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 
 	//bal
 	matWorld = world * glm::translate(glm::vec3(-1.f, 1.f, 0.f)) * glm::rotate(-glm::pi<float>() / 2, glm::vec3(0, 1, 0));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 
 
 	//alsó
 	matWorld = world * glm::translate(glm::vec3(0.f, 1.f, 0.f));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_WALL);
 
-	glDrawElements(GL_TRIANGLES,
-		m_TileGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_WallGPU.Draw();
 }
 
 void CMyApp::DrawDynamit(glm::mat4 world) {
 
 	glm::mat4 matWorld = glm::identity<glm::mat4>();
 
-	glBindVertexArray(m_HengerGPU.vaoID);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_dynamitTextureID);
-
-	glDisable(GL_CULL_FACE);
+	m_glState.Disable(GL_CULL_FACE);
 
 	float radius = 0.1;
 	float height = 1.f;
 	matWorld = world * glm::translate(glm::vec3(1.f / 16.f, 0, sqrtf(3) / 16.f)) * glm::scale(glm::vec3(radius, height, radius));
 
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_DYNAMIT);
 
-	glDrawElements(GL_TRIANGLES,
-		m_HengerGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_HengerGPU.Draw();
 
 
 
@@ -908,13 +1060,9 @@ void CMyApp::DrawDynamit(glm::mat4 world) {
 
 	matWorld = world * glm::translate(glm::vec3(1.f / 16.f, 0, -sqrtf(3) / 16.f)) * glm::scale(glm::vec3(radius, height, radius));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_DYNAMIT);
 
-	glDrawElements(GL_TRIANGLES,
-		m_HengerGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_HengerGPU.Draw();
 
 
 
@@ -922,44 +1070,45 @@ void CMyApp::DrawDynamit(glm::mat4 world) {
 
 	matWorld = world * glm::translate(glm::vec3(-1.f / 8.f, 0, 0))  * glm::scale(glm::vec3(radius, height, radius));
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_DYNAMIT);
 
-	glDrawElements(GL_TRIANGLES,
-		m_HengerGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_HengerGPU.Draw();
 
-	glEnable(GL_CULL_FACE);
+	m_glState.Enable(GL_CULL_FACE);
 }
 
 void CMyApp::DrawExplosion(glm::mat4 world) {
 
-	glUseProgram(m_programID);
+	// a robbanás közepén pont fényforrás, a felcsapó lángon nincs spekuláris csillanás
+	m_lightPos = glm::vec4(world[3][0], world[3][1], world[3][2], 1.0f);
+	m_Ld = glm::vec3(1.f, 0.6f, 0.f);
+	m_Ls = glm::vec3(1.f, 0.6f, 0.f);
+	m_lightLinearAttenuation = 0.3f;
+	m_lightQuadraticAttenuation = 0.3f;
 
-	glm::mat4 matWorld = glm::identity<glm::mat4>();
+	// más program és más fényforrás, mint a pálya többi részéé
+	m_glState.UseProgram(LitProgram(LIT_ALPHA_BLEND));
 
-	glBindVertexArray(m_HengerGPU.vaoID);
+	BindFrameUniforms();
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_explosionTextureID);
+	glm::mat4 matWorld = glm::identity<glm::mat4>();
+
+	// a skybox után újra a Vertex formátum jön
+	m_glState.BindVertexArray(m_vertexGeometry.VaoID());
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_CULL_FACE);
+	m_glState.Enable(GL_BLEND);
+	// a textúra alfája előre be van szorozva
+	m_glState.BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	m_glState.Disable(GL_CULL_FACE);
 
 	float radius = 0.35;
 	float height = 5.f;
 	matWorld = world * glm::rotate(glm::pi<float>()/2, glm::vec3(1,0,0)) * glm::scale(glm::vec3(radius, height, radius));
 
 
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
+	BindDrawUniforms(matWorld, ARENA_LAYER_EXPLOSION);
 
-	glDrawElements(GL_TRIANGLES,
-		m_HengerGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_HengerGPU.Draw();
 
 
 
@@ -968,29 +1117,12 @@ void CMyApp::DrawExplosion(glm::mat4 world) {
 	//Z tengely mentén kell forgarni nem y!
 	matWorld = world * glm::rotate(glm::pi<float>() / 2, glm::vec3(0, 0, 1)) * glm::scale(glm::vec3(radius, height, radius));
 
-	m_lightPos = glm::vec4(world[3][0], world[3][1], world[3][2], 1.0f);
-	glUniform4fv(ul("lightPos"), 1, glm::value_ptr(m_lightPos));
-
-	glUniformMatrix4fv(ul("world"), 1, GL_FALSE, glm::value_ptr(matWorld));
-	glUniformMatrix4fv(ul("worldIT"), 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(matWorld))));
-
-	m_Ld = glm::vec3(1.f, 0.6f, 0.f);
-	m_Ls = glm::vec3(1.f, 0.6f, 0.f);
-	glUniform3fv(ul("Ld"), 1, glm::value_ptr(m_Ld));
-	glUniform3fv(ul("Ls"), 1, glm::value_ptr(m_Ls));
-
-	m_lightLinearAttenuation = 0.3f;
-	m_lightQuadraticAttenuation = 0.3f;
-	glUniform1f(ul("lightLinearAttenuation"), m_lightLinearAttenuation);
-	glUniform1f(ul("lightQuadraticAttenuation"), m_lightQuadraticAttenuation);
+	BindDrawUniforms(matWorld, ARENA_LAYER_EXPLOSION);
 
-	glDrawElements(GL_TRIANGLES,
-		m_HengerGPU.count,
-		GL_UNSIGNED_INT,
-		nullptr);
+	m_HengerGPU.Draw();
 
-	glEnable(GL_CULL_FACE);
-	glDisable(GL_BLEND);
+	m_glState.Enable(GL_CULL_FACE);
+	m_glState.Disable(GL_BLEND);
 
 }
 
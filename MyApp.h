@@ -14,8 +14,15 @@
 
 // Utils
 #include "GLUtils.hpp"
+#include "AssetLoader.h"
+#include "ObjParser.h"
+#include "MeshSimplifier.h"
 #include "Camera.h"
 #include "CameraManipulator.h"
+#include "ShaderReloader.h"
+#include "GeometryArena.h"
+#include "FrameRingBuffer.h"
+#include "GLStateCache.h"
 
 struct SUpdateInfo
 {
@@ -45,6 +52,7 @@ public:
 	void Resize(int, int);
 
 	void OtherEvent( const SDL_Event& );
+	// a falak és a dinamit a m_vertexGeometry már bekötött VAO-jával rajzolódnak
 	void DrawWall(glm::mat4 world);
 	void DrawDynamit(glm::mat4 world);
 	void DrawExplosion(glm::mat4 world);
@@ -71,6 +79,12 @@ protected:
 
 	int m_guiCurrentItem = -1;
 
+	// az ablak magassága pixelben, a LOD választáshoz
+	int m_windowHeight = 1;
+
+	// ennyi pixel eltérés megengedett a képernyőn egy egyszerűsített (LOD) modell és az eredeti között
+	float m_lodPixelError = 1.0f;
+
 
 	// Kamera
 	Camera m_camera;
@@ -80,11 +94,71 @@ protected:
 	// OpenGL-es dolgok
 	//
 	
-	// uniform location lekérdezése
-	static GLint ul( const char* uniformName ) noexcept;
+	// A Shaders/Uniforms.glsl blokkjainak std140 elrendezésű párjai: a vec3 után álló skalár a vec3 16 bájtjának végére kerül
+	struct FrameUniforms
+	{
+		glm::mat4 viewProj;
+
+		glm::vec3 cameraPos;
+		float     lightConstantAttenuation;
+
+		glm::vec4 lightPos;
+
+		glm::vec3 La;
+		float     lightLinearAttenuation;
+		glm::vec3 Ld;
+		float     lightQuadraticAttenuation;
+		glm::vec3 Ls;
+		float     padding;
+	};
+	static_assert( sizeof( FrameUniforms ) == 144, "FrameUniforms has to match the std140 layout of the shader block" );
+
+	struct DrawUniforms
+	{
+		glm::mat4 world;
+		glm::mat4 worldIT;
+
+		glm::vec3 Ka;
+		float     Shininess;
+		glm::vec3 Kd;
+		GLint     texLayer;
+		glm::vec3 Ks;
+		GLint     octNormals;
+	};
+	static_assert( sizeof( DrawUniforms ) == 176, "DrawUniforms has to match the std140 layout of the shader block" );
+
+	static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+	static constexpr GLuint DRAW_UNIFORMS_BINDING  = 1;
+
+	// Képkockánkénti adatok: a uniform blokkok tartalma egy perzisztensen leképezett gyűrűpufferbe kerül,
+	// rajzolásonként csak egy glBindBufferRange
+	static constexpr std::size_t FRAME_DATA_SIZE = 256 * 1024;
+	FrameRingBuffer m_frameData;
+
+	// A program, VAO, textúra és blend/cull/depth állapot váltásai ezen keresztül: a felesleges hívásokat kiszűri, a drivertől nem kérdez le semmit
+	GLStateCache m_glState;
+	// a polygon mód (F1), hogy ne kelljen lekérdezni
+	GLenum m_polygonMode = GL_FILL;
+
+	// A kamera és a fényforrás (FrameUniforms) a gyűrűpufferbe, a blokk kötési pontjára
+	void BindFrameUniforms();
+
+	// Egy rajzolás DrawUniforms-a az alapértelmezett anyaggal, worldIT a world-ből
+	DrawUniforms MakeDrawUniforms( const glm::mat4& world, GLint texLayer ) const;
+	void BindDrawUniforms( const DrawUniforms& drawUniforms );
+	void BindDrawUniforms( const glm::mat4& world, GLint texLayer ) { BindDrawUniforms( MakeDrawUniforms( world, texLayer ) ); }
 
 	// shaderekhez szükséges változók
-	GLuint m_programID = 0;		  // shaderek programja
+	// A fő program változatai (Frag_ZH.frag makrói), a LIT_* bitek szerinti indexen:
+	// mind betöltéskor fordul, rajzoláskor csak a helyzethez illőt választjuk
+	enum LitVariant : int
+	{
+		LIT_POINT_LIGHT   = 1 << 0, // POINT_LIGHT: pont fényforrás, különben irány fényforrás
+		LIT_SPECULAR      = 1 << 1, // SPECULAR: spekuláris komponens
+		LIT_ALPHA_BLEND   = 1 << 2, // ALPHA_BLEND: átlátszó texelek eldobása
+		LIT_VARIANT_COUNT = 1 << 3
+	};
+	GLuint m_programIDs[ LIT_VARIANT_COUNT ] = {}; // shaderek programjai
 	GLuint m_programSkyboxID = 0; // skybox programja
 
 
@@ -106,43 +180,89 @@ protected:
 
 	float m_Shininess = 1.0;
 
+	static std::vector<std::string> LitVariantDefines( int variant );
+
+	// Az aktuális fényforráshoz illő változat: a variant bitjeihez a fény típusa adódik, a SPECULAR elmarad, ha nincs spekuláris fény
+	GLuint LitProgram( int variant ) const;
+
 	// Shaderek inicializálása, és törtlése
 	void InitShaders();
 	void CleanShaders();
 	void InitSkyboxShaders();
 	void CleanSkyboxShaders();
 
+	// A shader fájlok figyelése: a megváltozott fájlokat használó programok újrafordítása és cseréje, több képkockán át
+	ShaderReloader m_shaderReloader;
+	void InitShaderReloading();
+
 	// Geometriával kapcsolatos változók
 
-	OGLObject m_SuzanneGPU = {};
-	OGLObject m_surfaceGPU = {};
-	OGLObject m_SkyboxGPU = {};
-	OGLObject m_TileGPU = {};
-	OGLObject m_HardhatGPU = {};
-	OGLObject m_HengerGPU = {};
-	OGLObject m_WallGPU = {};
+	// vertex formátumonként egy közös vertex és index puffer (és VAO), a meshek ezek tartományai:
+	// a rajzolások között csak a formátum váltásakor kell VAO-t váltani
+	GeometryArena m_quantizedGeometry; // VertexQuantized: OBJ modellek
+	GeometryArena m_vertexGeometry;    // Vertex: parametrikus felület, csempe, fal
+	GeometryArena m_skyboxGeometry;    // glm::vec3: skybox
+
+	ArenaMesh m_SuzanneGPU = {};
+	ArenaMesh m_SkyboxGPU = {};
+	ArenaMesh m_TileGPU = {};
+	ArenaMesh m_HardhatGPU = {};
+	ArenaMesh m_HengerGPU = {};
+	ArenaMesh m_WallGPU = {};
+
+	// a kvantált (VertexQuantized) OBJ modellek befoglaló dobozai, a world mátrixot ezzel kell jobbról szorozni
+	glm::mat4 m_SuzanneDequantization = glm::mat4( 1.0f );
+	glm::mat4 m_HardhatDequantization = glm::mat4( 1.0f );
+
+	// OBJ modellek anyagonkénti tartományai: anyagonként egy rajzolási parancs
+	struct MaterialGroups
+	{
+		std::vector<MeshSimplifier::Lod> lods;       // részletességi szintenként az anyagok tartományai, lods[ 0 ] az eredeti modell
+		std::vector<ObjParser::Material> materials;
+		std::vector<GLuint>              textureIDs; // anyagonként, 0 ha nincs saját textúrája (map_Kd)
+	};
+
+	MaterialGroups m_SuzanneMaterials;
+	MaterialGroups m_HardhatMaterials;
+
+	// a legegyszerűbb részletességi szint, aminek a hibája a képernyőn legfeljebb m_lodPixelError pixel
+	std::size_t SelectLod( const MaterialGroups& groups, const glm::mat4& world, const glm::mat4& dequantization ) const;
+	void DrawMaterialGroups( const ArenaMesh& meshGPU, const MaterialGroups& groups, std::size_t lod, DrawUniforms drawUniforms );
+
+	// OBJ modell betöltése és kvantálása háttérszálon, a feltöltés után az anyagok textúrái is betöltődnek
+	void LoadModel( AssetLoader& assetLoader, const std::filesystem::path& fileName, ArenaMesh& meshGPU, glm::mat4& dequantization, MaterialGroups& groups );
 
 	// Geometria inicializálása, és törtlése
-	void InitGeometry();
+	void InitGeometry( AssetLoader& assetLoader );
 	void CleanGeometry();
 	void InitSkyboxGeometry();
 	void CleanSkyboxGeometry();
 
 	// Textúrázás, és változói
 
-	GLuint m_SuzanneTextureID = 0;
 	GLuint m_surfaceTextureID = 0;
 	GLuint m_skyboxTextureID = 0;
 
-	GLuint m_tileTextureID = 0;
-	GLuint m_wallTextureID = 0;
-	GLuint m_hardhatTextureID = 0;
-	GLuint m_dynamitTextureID = 0;
-	GLuint m_explosionTextureID = 0;
-
-	void InitTextures();
+	// A pálya textúrái egy GL_TEXTURE_2D_ARRAY rétegeiben, közös méretre átméretezve:
+	// a rajzolások között csak a texLayer uniform változik, nem kell textúrát kötni
+	enum ArenaLayer : GLint
+	{
+		ARENA_LAYER_WOOD,
+		ARENA_LAYER_HARDHAT,
+		ARENA_LAYER_TILE,
+		ARENA_LAYER_WALL,
+		ARENA_LAYER_DYNAMIT,
+		ARENA_LAYER_EXPLOSION,
+		ARENA_LAYER_COUNT
+	};
+	static constexpr int ARENA_TEXTURE_SIZE = 512;
+	static constexpr GLint ARENA_TEXTURE_UNIT = 2;
+
+	GLuint m_arenaTexturesID = 0;
+
+	void InitTextures( AssetLoader& assetLoader );
 	void CleanTextures();
-	void InitSkyboxTextures();
+	void InitSkyboxTextures( AssetLoader& assetLoader );
 	void CleanSkyboxTextures();
 };
 
@@ -50,42 +50,22 @@ in vec2 vs_out_tex;
 // kimenő érték - a fragment színe
 out vec4 fs_out_col;
 
-// textúra mintavételező objektum
-uniform sampler2D texImage;
-
-uniform vec3 cameraPos;
-
-// fenyforras tulajdonsagok
-uniform vec4 lightPos = vec4( 0.3, 0.3, 0.3, 0.0);
-
-uniform vec3 La = vec3(0.125, 0.125, 0.125 );
-uniform vec3 Ld = vec3(1.0, 1.0, 1.0 );
-uniform vec3 Ls = vec3(1.0, 1.0, 1.0 );
-
-uniform float lightConstantAttenuation    = 1.0;
-uniform float lightLinearAttenuation      = 0.0;
-uniform float lightQuadraticAttenuation   = 0.0;
-
-// anyag tulajdonsagok
+// textúra mintavételező objektumok, a textúraegységük rögzített; a réteget a DrawUniforms texLayer-e választja
+layout( binding = 0 ) uniform sampler2D      texImage;      // OBJ anyagok saját textúrái
+layout( binding = 2 ) uniform sampler2DArray arenaTextures; // a pálya textúrái rétegenként (CMyApp::ARENA_TEXTURE_UNIT)
 
-uniform vec3 Ka = vec3( 1.0 );
-uniform vec3 Kd = vec3( 1.0 );
-uniform vec3 Ks = vec3( 1.0 );
-
-uniform float Shininess = 1.0;
-
-/* segítség:
-	    - normalizálás: http://www.opengl.org/sdk/docs/manglsl/xhtml/normalize.xml
-	    - skaláris szorzat: http://www.opengl.org/sdk/docs/manglsl/xhtml/dot.xml
-	    - clamp: http://www.opengl.org/sdk/docs/manglsl/xhtml/clamp.xml
-		- reflect: http://www.opengl.org/sdk/docs/manglsl/xhtml/reflect.xml
-				reflect(beérkező_vektor, normálvektor);
-		- pow: http://www.opengl.org/sdk/docs/manglsl/xhtml/pow.xml
-				pow(alap, kitevő);
-*/
+// megvilágítás, a változatot a POINT_LIGHT és SPECULAR makrók választják
+#include "Lighting.glsl"
 
 void main()
 {
+	vec4 texColor = texLayer >= 0 ? texture( arenaTextures, vec3( vs_out_tex, texLayer ) ) : texture( texImage, vs_out_tex );
+
+#ifdef ALPHA_BLEND
+	// az átlátszó texelek nem járulnak hozzá a színhez, és a mélységi pufferbe se kerüljenek be
+	if ( texColor.a == 0.0 ) discard;
+#endif
+
 	// A fragment normálvektora
 	// MINDIG normalizáljuk!
 
@@ -94,51 +74,9 @@ void main()
 	if(!gl_FrontFacing){
 		normal = -normal;
 	}
-	
-	vec3 ToLight; // A fényforrásBA mutató vektor
-	float LightDistance=0.0; // A fényforrástól vett távolság
-	
-	if ( lightPos.w == 0.0 ) // irány fényforrás (directional light)
-	{
-		// Irányfényforrás esetén minden pont ugyan abbóla az irányból van megvilágítva
-		ToLight	= lightPos.xyz;
-		// A távolságot 0-n hagyjuk, hogy az attenuáció ne változtassa a fényt
-	}
-	else				  // pont fényforrás (point light)
-	{
-		// Pontfényforrás esetén kkiszámoljuk a fragment pontból a fényforrásba mutató vektort, ...
-		ToLight	= lightPos.xyz - vs_out_pos;
-		// ... és a távolságot a fényforrástól
-		LightDistance = length(ToLight);
-	}
-	//  Normalizáljuk a fényforrásba mutató vektort
-	ToLight = normalize(ToLight);
-	
-	// Attenuáció (fényelhalás) kiszámítása
-	float Attenuation = 1.0 / ( lightConstantAttenuation + lightLinearAttenuation * LightDistance + lightQuadraticAttenuation * LightDistance * LightDistance);
-	
-	// Ambiens komponens
-	// Ambiens fény mindenhol ugyanakkora
-	vec3 Ambient = La * Ka;
-
-	// Diffúz komponens
-	// A diffúz fényforrásból érkező fény mennyisége arányos a fényforrásba mutató vektor és a normálvektor skaláris szorzatával
-	// és az attenuációval
-	float DiffuseFactor = max(dot(ToLight,normal), 0.0) * Attenuation;
-	vec3 Diffuse = DiffuseFactor * Ld * Kd;
-	
-	// Spekuláris komponens
-	vec3 viewDir = normalize( cameraPos - vs_out_pos ); // A fragmentből a kamerába mutató vektor
-	vec3 reflectDir = reflect( -ToLight, normal ); // Tökéletes visszaverődés vektora
-	
-	// A spekuláris komponens a tökéletes visszaverődés iránya és a kamera irányától függ.
-	// A koncentráltsága cos()^s alakban számoljuk, ahol s a fényességet meghatározó paraméter.
-	// Szintén függ az attenuációtól.
-	float SpecularFactor = pow(max( dot( viewDir, reflectDir) ,0.0), Shininess) * Attenuation;
-	vec3 Specular = SpecularFactor*Ls*Ks;
 
 	// normal vector debug:
 	// fs_out_col = vec4( normal * 0.5 + 0.5, 1.0 );
-	fs_out_col = vec4( Ambient+Diffuse+Specular, 1.0 ) * texture(texImage, vs_out_tex);
+	fs_out_col = vec4( Lighting( vs_out_pos, normal ), 1.0 ) * texColor;
 	//fs_out_col.w = 0.5;
 }
\ No newline at end of file
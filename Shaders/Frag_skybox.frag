@@ -6,7 +6,7 @@ in vec3 vs_out_pos;
 out vec4 fs_out_col;
 
 // skybox textúra
-uniform samplerCube skyboxTexture;
+layout( binding = 1 ) uniform samplerCube skyboxTexture; // a CMyApp az 1-es egységre köti
 
 void main()
 {
@@ -0,0 +1,62 @@
+// Phong megvilágítás egy fényforrással, a Frag_ZH.frag változataihoz (AssembleProgram defines):
+//	POINT_LIGHT: pont fényforrás attenuációval, különben irány fényforrás
+//	SPECULAR:    spekuláris komponens, különben csak ambiens és diffúz
+
+// a fényforrás és az anyag a FrameUniforms és DrawUniforms blokkokban
+#include "Uniforms.glsl"
+
+/* segítség:
+	    - normalizálás: http://www.opengl.org/sdk/docs/manglsl/xhtml/normalize.xml
+	    - skaláris szorzat: http://www.opengl.org/sdk/docs/manglsl/xhtml/dot.xml
+	    - clamp: http://www.opengl.org/sdk/docs/manglsl/xhtml/clamp.xml
+		- reflect: http://www.opengl.org/sdk/docs/manglsl/xhtml/reflect.xml
+				reflect(beérkező_vektor, normálvektor);
+		- pow: http://www.opengl.org/sdk/docs/manglsl/xhtml/pow.xml
+				pow(alap, kitevő);
+*/
+
+// A position pontba érkező fény, normal normalizált
+vec3 Lighting( vec3 position, vec3 normal )
+{
+#ifdef POINT_LIGHT
+	// Pontfényforrás esetén kkiszámoljuk a fragment pontból a fényforrásba mutató vektort, ...
+	vec3 ToLight = lightPos.xyz - position;
+	// ... és a távolságot a fényforrástól
+	float LightDistance = length(ToLight);
+	ToLight = ToLight / LightDistance;
+
+	// Attenuáció (fényelhalás) kiszámítása
+	float Attenuation = 1.0 / ( lightConstantAttenuation + lightLinearAttenuation * LightDistance + lightQuadraticAttenuation * LightDistance * LightDistance);
+#else
+	// Irányfényforrás esetén minden pont ugyan abbóla az irányból van megvilágítva, ...
+	vec3 ToLight = normalize(lightPos.xyz);
+	// ... a távolság pedig 0, így az attenuációból csak a konstans tag marad
+	float Attenuation = 1.0 / lightConstantAttenuation;
+#endif
+
+	// Ambiens komponens
+	// Ambiens fény mindenhol ugyanakkora
+	vec3 Ambient = La * Ka;
+
+	// Diffúz komponens
+	// A diffúz fényforrásból érkező fény mennyisége arányos a fényforrásba mutató vektor és a normálvektor skaláris szorzatával
+	// és az attenuációval
+	float DiffuseFactor = max(dot(ToLight,normal), 0.0) * Attenuation;
+	vec3 Diffuse = DiffuseFactor * Ld * Kd;
+
+#ifdef SPECULAR
+	// Spekuláris komponens
+	vec3 viewDir = normalize( cameraPos - position ); // A fragmentből a kamerába mutató vektor
+	vec3 reflectDir = reflect( -ToLight, normal ); // Tökéletes visszaverődés vektora
+
+	// A spekuláris komponens a tökéletes visszaverődés iránya és a kamera irányától függ.
+	// A koncentráltsága cos()^s alakban számoljuk, ahol s a fényességet meghatározó paraméter.
+	// Szintén függ az attenuációtól.
+	float SpecularFactor = pow(max( dot( viewDir, reflectDir) ,0.0), Shininess) * Attenuation;
+	vec3 Specular = SpecularFactor*Ls*Ks;
+
+	return Ambient + Diffuse + Specular;
+#else
+	return Ambient + Diffuse;
+#endif
+}
@@ -0,0 +1,41 @@
+// A CMyApp által a FrameRingBuffer-be írt uniform blokkok (std140),
+// a C++ oldali párjuk a MyApp.h FrameUniforms és DrawUniforms struktúrája, a mezők sorrendje és mérete egyezzen!
+
+#ifndef UNIFORMS_GLSL
+#define UNIFORMS_GLSL
+
+// képkockánként (és fényforrás váltásakor) egyszer
+layout( std140, binding = 0 ) uniform FrameUniforms
+{
+	mat4  viewProj;
+
+	vec3  cameraPos;
+	float lightConstantAttenuation;
+
+	// fenyforras tulajdonsagok, lightPos.w == 0: irány fényforrás
+	vec4  lightPos;
+
+	vec3  La;
+	float lightLinearAttenuation;
+	vec3  Ld;
+	float lightQuadraticAttenuation;
+	vec3  Ls;
+};
+
+// rajzolásonként
+layout( std140, binding = 1 ) uniform DrawUniforms
+{
+	// transzformációs mátrixok
+	mat4  world;
+	mat4  worldIT;
+
+	// anyag tulajdonsagok
+	vec3  Ka;
+	float Shininess;
+	vec3  Kd;
+	int   texLayer;   // az arenaTextures rétege, -1: texImage
+	vec3  Ks;
+	bool  octNormals; // kvantált vertexeknél a normális a 3-as attribútumon érkezik
+};
+
+#endif
@@ -4,22 +4,33 @@
 layout( location = 0 ) in vec3 vs_in_pos;
 layout( location = 1 ) in vec3 vs_in_norm;
 layout( location = 2 ) in vec2 vs_in_tex;
+layout( location = 3 ) in vec2 vs_in_norm_oct; // VertexQuantized: oktaéderes kódolású normális
 
 // a pipeline-ban tovább adandó értékek
 out vec3 vs_out_pos;
 out vec3 vs_out_norm;
 out vec2 vs_out_tex;
 
-// shader külső paraméterei - most a három transzformációs mátrixot külön-külön vesszük át
-uniform mat4 world;
-uniform mat4 worldIT;
-uniform mat4 viewProj;
+// shader külső paraméterei: a transzformációs mátrixok és az octNormals a FrameUniforms és DrawUniforms blokkokban
+#include "Uniforms.glsl"
+
+// VertexQuantization::DecodeNormal párja
+vec3 OctDecode( vec2 oct )
+{
+	vec3 n = vec3( oct, 1.0 - abs( oct.x ) - abs( oct.y ) );
+	float t = max( -n.z, 0.0 );
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize( n );
+}
 
 void main()
 {
+	vec3 norm = octNormals ? OctDecode( vs_in_norm_oct ) : vs_in_norm;
+
 	gl_Position = viewProj * world * vec4( vs_in_pos, 1 );
 	vs_out_pos  = (world   * vec4(vs_in_pos,  1)).xyz;
-	vs_out_norm = (worldIT * vec4(vs_in_norm, 0)).xyz;
+	vs_out_norm = (worldIT * vec4(norm, 0)).xyz;
 
 	vs_out_tex = vs_in_tex;
 }
\ No newline at end of file
@@ -6,9 +6,8 @@ layout (location = 0 ) in vec3 vs_in_pos;
 // a pipeline-ban tovább adandó értékek
 out vec3 vs_out_pos;
 
-// shader külső paraméterei - most a három transzformációs mátrixot külön-külön vesszük át
-uniform mat4 world;
-uniform mat4 viewProj;
+// shader külső paraméterei: a viewProj és a world a FrameUniforms és DrawUniforms blokkokban
+#include "Uniforms.glsl"
 
 void main()
 {
@@ -0,0 +1,105 @@
+#include "AssetLoader.h"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+static double millisecondsSince( const std::chrono::steady_clock::time_point start )
+{
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+}
+
+AssetLoader::AssetLoader( unsigned int threadCount )
+	: m_start( std::chrono::steady_clock::now() )
+	, m_pool( threadCount )
+{
+	// SDL_image initializes the decoders on their first use, which is not thread safe
+	IMG_Init( IMG_INIT_PNG | IMG_INIT_JPG );
+}
+
+void AssetLoader::LoadMesh( const std::filesystem::path& objFileName, std::function<void( CachedMesh& )> upload )
+{
+	Load<CachedMesh>( objFileName.string(),
+					  [ this, objFileName ]() { return MeshCache::Load( objFileName, &m_pool ); },
+					  std::move( upload ) );
+}
+
+void AssetLoader::LoadTexture( const std::filesystem::path& imageFileName, const TextureCache::Options& options, std::function<void( CachedTexture& )> upload )
+{
+	Load<CachedTexture>( imageFileName.string(),
+						 [ imageFileName, options ]() { return TextureCache::Load( imageFileName, options ); },
+						 [ upload = std::move( upload ) ]( CachedTexture& texture )
+						 {
+							 if ( !texture.levels.empty() ) upload( texture );
+						 } );
+}
+
+void AssetLoader::Enqueue( std::string name, std::function<void()> decode, std::function<void()> upload )
+{
+	auto job = std::make_shared<Job>();
+	job->name = std::move( name );
+	job->upload = std::move( upload );
+	++m_pendingJobs;
+
+	// the future is not needed, the job itself carries the result and the exception
+	m_pool.Submit( [ this, job, decode = std::move( decode ) ]()
+	{
+		const auto decodeStart = std::chrono::steady_clock::now();
+		try
+		{
+			decode();
+		}
+		catch ( ... )
+		{
+			job->error = std::current_exception();
+		}
+		job->decodeMs = millisecondsSince( decodeStart );
+
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_decodedJobs.push_back( job );
+		}
+		m_jobDecoded.notify_one();
+	} );
+}
+
+void AssetLoader::Finish()
+{
+	while ( m_pendingJobs > 0 )
+	{
+		std::vector<std::shared_ptr<Job>> decodedJobs;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_jobDecoded.wait( lock, [ this ]() { return !m_decodedJobs.empty(); } );
+			decodedJobs.swap( m_decodedJobs );
+		}
+
+		for ( const std::shared_ptr<Job>& job : decodedJobs )
+		{
+			--m_pendingJobs;
+			if ( job->error ) std::rethrow_exception( job->error );
+
+			// may call Enqueue
+			const auto uploadStart = std::chrono::steady_clock::now();
+			job->upload();
+
+			m_decodeMsSum += job->decodeMs;
+			m_timings.push_back( { job->name, job->decodeMs, millisecondsSince( uploadStart ), millisecondsSince( m_start ) } );
+		}
+	}
+}
+
+void AssetLoader::LogTimings() const
+{
+	for ( const Timing& timing : m_timings )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_INFO,
+						"[AssetLoader] %s: decode %.1f ms, upload %.1f ms, ready at %.1f ms",
+						timing.name.c_str(), timing.decodeMs, timing.uploadMs, timing.readyMs );
+	}
+
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[AssetLoader] %zu assets ready in %.1f ms, decoding took %.1f ms on %u threads",
+					m_timings.size(), m_timings.empty() ? 0.0 : m_timings.back().readyMs, m_decodeMsSum, m_pool.ThreadCount() );
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "GLUtils.hpp"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
+
+// Loads assets on a ThreadPool, the GL thread only uploads them.
+//
+// Every asset has two steps: decode runs on a worker (file IO, parsing, decompression; no OpenGL calls),
+// upload runs on the GL thread in Finish, in the order the decodes complete.
+// An upload may start further loads, e.g. the textures of the materials of a mesh.
+class AssetLoader
+{
+public:
+	struct Timing
+	{
+		std::string name;
+		double decodeMs = 0.0; // on a worker
+		double uploadMs = 0.0; // on the GL thread
+		double readyMs  = 0.0; // since the loader was created, until the upload finished
+	};
+
+	explicit AssetLoader( unsigned int threadCount = ThreadPool::HARDWARE_THREADS );
+
+	AssetLoader( const AssetLoader& ) = delete;
+	AssetLoader& operator=( const AssetLoader& ) = delete;
+
+	template <typename T>
+	void Load( std::string name, std::function<T()> decode, std::function<void( T& )> upload );
+
+	// MeshCache::Load on a worker
+	void LoadMesh( const std::filesystem::path& objFileName, std::function<void( CachedMesh& )> upload );
+	// TextureCache::Load on a worker, upload is skipped if the image could not be loaded
+	void LoadTexture( const std::filesystem::path& imageFileName, const TextureCache::Options& options, std::function<void( CachedTexture& )> upload );
+
+	// Runs the uploads on the calling (GL) thread as the decodes complete, until every load is done.
+	// The exception thrown by a decode or an upload is rethrown here.
+	void Finish();
+
+	// For decodes that split their work further (ThreadPool::ParallelFor), so the loads running at once share the workers
+	ThreadPool& Pool() noexcept { return m_pool; }
+
+	const std::vector<Timing>& Timings() const noexcept { return m_timings; }
+	void LogTimings() const;
+
+private:
+	struct Job
+	{
+		std::string           name;
+		std::function<void()> upload;
+		std::exception_ptr    error;
+		double                decodeMs = 0.0;
+	};
+
+	void Enqueue( std::string name, std::function<void()> decode, std::function<void()> upload );
+
+	std::chrono::steady_clock::time_point m_start;
+
+	std::mutex                        m_mutex;
+	std::condition_variable           m_jobDecoded;
+	std::vector<std::shared_ptr<Job>> m_decodedJobs;
+
+	// only touched on the GL thread
+	std::size_t         m_pendingJobs = 0;
+	double              m_decodeMsSum = 0.0;
+	std::vector<Timing> m_timings;
+
+	// declared last, so it is destroyed first: the workers still running use the members above
+	ThreadPool m_pool;
+};
+
+template <typename T>
+void AssetLoader::Load( std::string name, std::function<T()> decode, std::function<void( T& )> upload )
+{
+	auto result = std::make_shared<std::optional<T>>();
+
+	Enqueue( std::move( name ),
+			 [ result, decode = std::move( decode ) ]() { result->emplace( decode() ); },
+			 [ result, upload = std::move( upload ) ]() { upload( **result ); } );
+}
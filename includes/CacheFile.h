@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+// The parts shared by the binary caches (MeshCache, TextureCache, ProgramCache): keying by the source file and writing the cache file.
+
+// The source file a cache was built from, stored in the cache header
+struct CacheSource
+{
+	uint64_t size = 0;
+	int64_t  time = 0; // last_write_time, in the ticks of the file clock
+	uint64_t hash = 0; // HashFileContent
+};
+
+// Whether a cache built from cached is still valid for a source of this size and time.
+// The modification time changes on e.g. checkout, then the content decides: computeHash() is only called when the times differ.
+template <typename HashFunc>
+bool IsSourceUnchanged( const CacheSource& cached, const uint64_t size, const int64_t time, HashFunc&& computeHash )
+{
+	return cached.size == size && ( cached.time == time || cached.hash == computeHash() );
+}
+
+// Writes fileName through a temporary file renamed over it, so a half written cache is never picked up.
+// writeContent( std::ostream& ) writes the whole file, false if it could not be written.
+template <typename WriteFunc>
+bool WriteFileAtomically( const std::filesystem::path& fileName, WriteFunc&& writeContent )
+{
+	std::filesystem::path tempFileName = fileName;
+	tempFileName += ".tmp";
+
+	std::error_code ec;
+	{
+		std::ofstream strm( tempFileName, std::ios::binary | std::ios::trunc );
+		if ( !strm ) return false;
+
+		writeContent( strm );
+		if ( !strm )
+		{
+			strm.close();
+			std::filesystem::remove( tempFileName, ec );
+			return false;
+		}
+	}
+
+	std::filesystem::rename( tempFileName, fileName, ec );
+	if ( ec )
+	{
+		std::filesystem::remove( tempFileName, ec );
+		return false;
+	}
+
+	return true;
+}
+
+// Overwrites the header at the start of fileName in place, the rest is left as it is (it may be mapped right now).
+// Only for storing a new CacheSource::time: a torn write is harmless, the time does not match then, and the content hash decides again.
+template <typename HeaderT>
+bool RewriteHeader( const std::filesystem::path& fileName, const HeaderT& header )
+{
+	std::fstream strm( fileName, std::ios::binary | std::ios::in | std::ios::out );
+	if ( !strm ) return false;
+
+	strm.write( reinterpret_cast<const char*>( &header ), sizeof( HeaderT ) );
+	return static_cast<bool>( strm );
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Content hash of a whole file (or any buffer), 8 bytes per step, for keying the binary caches.
+// Mixing is the same as in fasthash64 https://github.com/ztanml/fast-hash
+inline uint64_t HashFileContent( const char* data, const std::size_t size ) noexcept
+{
+	constexpr uint64_t m = 0x880355f21e6d1965ULL;
+
+	auto mix = []( uint64_t h ) -> uint64_t
+	{
+		h ^= h >> 23;
+		h *= 0x2127599bf4325c37ULL;
+		h ^= h >> 47;
+		return h;
+	};
+
+	uint64_t h = size * m;
+
+	std::size_t i = 0;
+	for ( ; i + sizeof( uint64_t ) <= size; i += sizeof( uint64_t ) )
+	{
+		uint64_t v;
+		std::memcpy( &v, data + i, sizeof( uint64_t ) );
+		h ^= mix( v );
+		h *= m;
+	}
+
+	uint64_t v = 0;
+	if ( i < size ) std::memcpy( &v, data + i, size - i );
+	h ^= mix( v );
+	h *= m;
+
+	return mix( h );
+}
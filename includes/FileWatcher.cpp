@@ -0,0 +1,97 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+
+FileWatcher::FileWatcher( std::chrono::milliseconds pollInterval )
+	: m_pollInterval( pollInterval )
+	, m_thread( &FileWatcher::PollLoop, this )
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopping = true;
+	}
+	m_stopRequested.notify_all();
+
+	m_thread.join();
+}
+
+void FileWatcher::Watch( const std::filesystem::path& fileName )
+{
+	std::error_code ec;
+	const std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time( fileName, ec );
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_files.push_back( { fileName, lastWriteTime } );
+}
+
+std::vector<std::filesystem::path> FileWatcher::TakeChangedFiles()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return std::move( m_changedFiles );
+}
+
+void FileWatcher::SetChangeHandler( ChangeHandler handler )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_changeHandler = std::move( handler );
+}
+
+void FileWatcher::ReportAll()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_reportAll = true;
+}
+
+void FileWatcher::PollLoop()
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+
+	while ( !m_stopRequested.wait_for( lock, m_pollInterval, [ this ]() { return m_stopping; } ) )
+	{
+		for ( WatchedFile& file : m_files )
+		{
+			// an editor may replace the file, then it is missing for a moment
+			std::error_code ec;
+			const std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time( file.fileName, ec );
+			if ( ec ) continue;
+
+			if ( lastWriteTime != file.lastWriteTime )
+			{
+				file.lastWriteTime = lastWriteTime;
+				file.settling = true;
+			}
+			else if ( file.settling )
+			{
+				file.settling = false;
+				if ( std::find( m_changedFiles.cbegin(), m_changedFiles.cend(), file.fileName ) == m_changedFiles.cend() )
+					m_changedFiles.push_back( file.fileName );
+			}
+		}
+
+		if ( m_reportAll )
+		{
+			m_reportAll = false;
+			for ( const WatchedFile& file : m_files )
+			{
+				if ( std::find( m_changedFiles.cbegin(), m_changedFiles.cend(), file.fileName ) == m_changedFiles.cend() )
+					m_changedFiles.push_back( file.fileName );
+			}
+		}
+
+		if ( m_changeHandler && !m_changedFiles.empty() )
+		{
+			// the handler may take a while, Watch and ReportAll must not wait for it
+			const std::vector<std::filesystem::path> changedFiles = std::move( m_changedFiles );
+			m_changedFiles.clear();
+			const ChangeHandler handler = m_changeHandler;
+
+			lock.unlock();
+			handler( changedFiles );
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Watches files for changes on a background thread by polling their modification times
+// (works the same on Windows and Linux, and a handful of files costs nothing to poll).
+// A file is reported once its time has not changed for a whole poll interval, so a save written in several steps is reported once.
+class FileWatcher
+{
+public:
+	explicit FileWatcher( std::chrono::milliseconds pollInterval = std::chrono::milliseconds( 250 ) );
+	~FileWatcher();
+
+	FileWatcher( const FileWatcher& ) = delete;
+	FileWatcher& operator=( const FileWatcher& ) = delete;
+
+	// Changes after this call are reported
+	void Watch( const std::filesystem::path& fileName );
+
+	// The files changed since the previous call, as they were given to Watch
+	std::vector<std::filesystem::path> TakeChangedFiles();
+
+	// The changed files are handed to the handler on the watcher thread instead of being collected for TakeChangedFiles,
+	// so it can do the slow part of reacting to them (e.g. reading the files) off the caller's thread.
+	using ChangeHandler = std::function<void( const std::vector<std::filesystem::path>& changedFiles )>;
+	void SetChangeHandler( ChangeHandler handler );
+
+	// Every watched file is reported as changed by the next poll
+	void ReportAll();
+
+private:
+	struct WatchedFile
+	{
+		std::filesystem::path           fileName;
+		std::filesystem::file_time_type lastWriteTime;
+		bool                            settling = false; // changed in the previous poll
+	};
+
+	void PollLoop();
+
+	const std::chrono::milliseconds    m_pollInterval;
+	std::mutex                         m_mutex;
+	std::condition_variable            m_stopRequested;
+	bool                               m_stopping = false;
+	bool                               m_reportAll = false;
+	std::vector<WatchedFile>           m_files;
+	std::vector<std::filesystem::path> m_changedFiles;
+	ChangeHandler                      m_changeHandler;
+
+	// declared last, so the members above exist while it runs
+	std::thread m_thread;
+};
@@ -0,0 +1,134 @@
+#include "FrameRingBuffer.h"
+
+#include <algorithm>
+
+#include <SDL2/SDL.h>
+
+static std::size_t alignUp( std::size_t value, std::size_t alignment ) noexcept
+{
+	return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+void FrameRingBuffer::Init( std::size_t frameSize )
+{
+	GLint alignment = 1;
+	glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+	m_alignment = static_cast<std::size_t>( std::max( alignment, 1 ) );
+	m_frameSize = alignUp( frameSize, m_alignment );
+
+	m_frame       = 0;
+	m_frameOffset = 0;
+
+	// main.cpp asks for a 4.4 context, this only matters if a driver gives less
+	if ( !GLEW_ARB_buffer_storage )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_WARN,
+						"[FrameRingBuffer] No GL_ARB_buffer_storage, the uniform blocks go through glBufferData" );
+		return;
+	}
+
+	const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr bufferSize = static_cast<GLsizeiptr>( m_frameSize * FRAMES_IN_FLIGHT );
+
+	glGenBuffers( 1, &m_bufferID );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, m_bufferID );
+	glBufferStorage( GL_COPY_WRITE_BUFFER, bufferSize, nullptr, mapFlags );
+	m_mapped = static_cast<char*>( glMapBufferRange( GL_COPY_WRITE_BUFFER, 0, bufferSize, mapFlags ) );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+	if ( m_mapped == nullptr )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_ERROR,
+						"[FrameRingBuffer] Could not map %lld bytes persistently", static_cast<long long>( bufferSize ) );
+	}
+}
+
+void FrameRingBuffer::Clean()
+{
+	for ( GLsync& fence : m_fences )
+	{
+		if ( fence != nullptr ) glDeleteSync( fence );
+		fence = nullptr;
+	}
+
+	if ( m_mapped != nullptr )
+	{
+		glBindBuffer( GL_COPY_WRITE_BUFFER, m_bufferID );
+		glUnmapBuffer( GL_COPY_WRITE_BUFFER );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+		m_mapped = nullptr;
+	}
+
+	glDeleteBuffers( 1, &m_bufferID );
+	m_bufferID = 0;
+
+	glDeleteBuffers( static_cast<GLsizei>( m_fallbackBufferIDs.size() ), m_fallbackBufferIDs.data() );
+	m_fallbackBufferIDs.clear();
+}
+
+void FrameRingBuffer::BeginFrame()
+{
+	GLsync& fence = m_fences[ m_frame ];
+	if ( fence != nullptr )
+	{
+		// usually signalled long ago; the flush makes sure the fence is submitted, otherwise the wait could last forever
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while ( glClientWaitSync( fence, waitFlags, 1000000000 ) == GL_TIMEOUT_EXPIRED ) waitFlags = 0;
+
+		glDeleteSync( fence );
+		fence = nullptr;
+	}
+
+	m_frameOffset = 0;
+}
+
+void FrameRingBuffer::EndFrame()
+{
+	m_fences[ m_frame ] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	m_frame = ( m_frame + 1 ) % FRAMES_IN_FLIGHT;
+}
+
+FrameRingBuffer::Allocation FrameRingBuffer::Allocate( std::size_t size )
+{
+	if ( m_mapped == nullptr ) return {};
+
+	const std::size_t alignedSize = alignUp( size, m_alignment );
+
+	if ( m_frameOffset + alignedSize > m_frameSize )
+	{
+		if ( !m_overflowReported )
+		{
+			SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+							SDL_LOG_PRIORITY_ERROR,
+							"[FrameRingBuffer] A frame needs more than %zu bytes, the rest of it goes through glBufferData; increase the frame size", m_frameSize );
+			m_overflowReported = true;
+		}
+		return {};
+	}
+
+	Allocation allocation;
+	allocation.offset = static_cast<GLintptr>( std::size_t( m_frame ) * m_frameSize + m_frameOffset );
+	allocation.data   = m_mapped + allocation.offset;
+	allocation.size   = static_cast<GLsizeiptr>( size );
+
+	m_frameOffset += alignedSize;
+
+	return allocation;
+}
+
+void FrameRingBuffer::BindFallback( GLuint binding, const void* data, std::size_t size )
+{
+	if ( binding >= m_fallbackBufferIDs.size() ) m_fallbackBufferIDs.resize( binding + 1, 0 );
+
+	GLuint& fallbackBufferID = m_fallbackBufferIDs[ binding ];
+	if ( fallbackBufferID == 0 ) glGenBuffers( 1, &fallbackBufferID );
+
+	// glBufferData gives the buffer new storage, the draws issued before still read the old one
+	glBindBuffer( GL_COPY_WRITE_BUFFER, fallbackBufferID );
+	glBufferData( GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>( size ), data, GL_STREAM_DRAW );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+	glBindBufferBase( GL_UNIFORM_BUFFER, binding, fallbackBufferID );
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Per frame dynamic data (uniform blocks) in one persistently mapped buffer.
+//
+// The buffer holds FRAMES_IN_FLIGHT regions of frameSize bytes, a frame bump-allocates from its own region,
+// and the data is written straight into the mapping (coherent, so no flush is needed). A region is reused
+// FRAMES_IN_FLIGHT frames later, after the fence of the frame that used it last has signalled.
+// A frame that needs more than its region does not reuse it (the GPU may not have read the earlier data yet),
+// the rest of its uniform blocks go through a small buffer per binding point, re-specified with glBufferData.
+class FrameRingBuffer
+{
+public:
+	static constexpr int FRAMES_IN_FLIGHT = 3;
+
+	struct Allocation
+	{
+		void*      data   = nullptr; // in the mapping
+		GLintptr   offset = 0;       // from the start of the buffer, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		GLsizeiptr size   = 0;
+	};
+
+	FrameRingBuffer() = default;
+	FrameRingBuffer( const FrameRingBuffer& ) = delete;
+	FrameRingBuffer& operator=( const FrameRingBuffer& ) = delete;
+
+	void Init( std::size_t frameSize );
+	void Clean();
+
+	// Waits (on the CPU) until the GPU is done with the region of this frame, the allocations start over
+	void BeginFrame();
+	// Fences the commands of the frame, the next frame uses the next region
+	void EndFrame();
+
+	// size bytes for this frame. Empty (data is null) if there is no mapped buffer (no GL_ARB_buffer_storage, or mapping failed), or the region of the frame is full;
+	// the latter is logged once, the frame size has to be raised.
+	Allocation Allocate( std::size_t size );
+
+	// Writes value to this frame's region and binds it to the uniform block binding point,
+	// or to the fallback buffer of the binding point, if the region is full
+	template <typename T>
+	void BindUniforms( GLuint binding, const T& value )
+	{
+		const Allocation allocation = Allocate( sizeof( T ) );
+		if ( allocation.data == nullptr )
+		{
+			BindFallback( binding, &value, sizeof( T ) );
+			return;
+		}
+
+		std::memcpy( allocation.data, &value, sizeof( T ) );
+		glBindBufferRange( GL_UNIFORM_BUFFER, binding, m_bufferID, allocation.offset, allocation.size );
+	}
+
+	GLuint BufferID() const noexcept { return m_bufferID; }
+
+	// bytes allocated in the current frame, to size the regions
+	std::size_t FrameBytesUsed() const noexcept { return m_frameOffset; }
+
+private:
+	void BindFallback( GLuint binding, const void* data, std::size_t size );
+
+	GLuint      m_bufferID  = 0;
+	char*       m_mapped    = nullptr;
+	std::size_t m_frameSize = 0;
+	std::size_t m_alignment = 1;
+
+	int         m_frame       = 0;
+	std::size_t m_frameOffset = 0;
+	GLsync      m_fences[ FRAMES_IN_FLIGHT ] = {};
+
+	bool m_overflowReported = false;
+
+	std::vector<GLuint> m_fallbackBufferIDs; // indexed by the binding point, 0 until first needed
+};
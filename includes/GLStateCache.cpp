@@ -0,0 +1,130 @@
+#include "GLStateCache.h"
+
+void GLStateCache::Invalidate()
+{
+	m_programID  = UNKNOWN;
+	m_vaoID      = UNKNOWN;
+	m_activeUnit = UNKNOWN;
+
+	for ( GLuint( &unitTextureIDs )[ TARGET_COUNT ] : m_textureIDs )
+	{
+		for ( GLuint& textureID : unitTextureIDs ) textureID = UNKNOWN;
+	}
+	for ( GLuint& capability : m_capabilities ) capability = UNKNOWN;
+
+	m_blendSourceFactor      = UNKNOWN;
+	m_blendDestinationFactor = UNKNOWN;
+	m_depthFunc = UNKNOWN;
+	m_cullFace  = UNKNOWN;
+}
+
+bool GLStateCache::Changes( GLuint& cached, const GLuint value ) noexcept
+{
+	if ( cached == value )
+	{
+		++m_stats.elided;
+		return false;
+	}
+
+	cached = value;
+	++m_stats.issued;
+	return true;
+}
+
+void GLStateCache::UseProgram( const GLuint programID )
+{
+	if ( Changes( m_programID, programID ) ) glUseProgram( programID );
+}
+
+void GLStateCache::BindVertexArray( const GLuint vaoID )
+{
+	if ( Changes( m_vaoID, vaoID ) ) glBindVertexArray( vaoID );
+}
+
+void GLStateCache::ActiveTexture( const GLuint unit )
+{
+	if ( Changes( m_activeUnit, unit ) ) glActiveTexture( GL_TEXTURE0 + unit );
+}
+
+void GLStateCache::BindTexture( const GLuint unit, const GLenum target, const GLuint textureID )
+{
+	const int targetIndex = TargetIndex( target );
+	if ( unit < MAX_TEXTURE_UNITS && targetIndex >= 0 )
+	{
+		if ( m_textureIDs[ unit ][ targetIndex ] == textureID )
+		{
+			++m_stats.elided;
+			return;
+		}
+		m_textureIDs[ unit ][ targetIndex ] = textureID;
+	}
+
+	// an untracked unit or target is bound every time, but the active unit is still kept up to date
+	ActiveTexture( unit );
+	glBindTexture( target, textureID );
+	++m_stats.issued;
+}
+
+void GLStateCache::SetCapability( const GLenum capability, const bool enabled )
+{
+	const int capabilityIndex = CapabilityIndex( capability );
+	if ( capabilityIndex >= 0 )
+	{
+		if ( !Changes( m_capabilities[ capabilityIndex ], enabled ? GL_TRUE : GL_FALSE ) ) return;
+	}
+	else
+	{
+		++m_stats.issued;
+	}
+
+	if ( enabled )
+		glEnable( capability );
+	else
+		glDisable( capability );
+}
+
+void GLStateCache::BlendFunc( const GLenum sourceFactor, const GLenum destinationFactor )
+{
+	if ( m_blendSourceFactor == sourceFactor && m_blendDestinationFactor == destinationFactor )
+	{
+		++m_stats.elided;
+		return;
+	}
+
+	m_blendSourceFactor      = sourceFactor;
+	m_blendDestinationFactor = destinationFactor;
+	glBlendFunc( sourceFactor, destinationFactor );
+	++m_stats.issued;
+}
+
+void GLStateCache::DepthFunc( const GLenum depthFunc )
+{
+	if ( Changes( m_depthFunc, depthFunc ) ) glDepthFunc( depthFunc );
+}
+
+void GLStateCache::CullFace( const GLenum face )
+{
+	if ( Changes( m_cullFace, face ) ) glCullFace( face );
+}
+
+int GLStateCache::TargetIndex( const GLenum target ) noexcept
+{
+	switch ( target )
+	{
+	case GL_TEXTURE_2D:       return TARGET_2D;
+	case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+	case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+	default:                  return -1;
+	}
+}
+
+int GLStateCache::CapabilityIndex( const GLenum capability ) noexcept
+{
+	switch ( capability )
+	{
+	case GL_BLEND:      return CAP_BLEND;
+	case GL_CULL_FACE:  return CAP_CULL_FACE;
+	case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+	default:            return -1;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// Shadow copy of the OpenGL state the renderer changes (program, VAO, texture bindings per unit, blend / cull / depth state),
+// a call is only issued if it changes the state. Nothing is read back from the driver (glGet* waits for the pipeline).
+//
+// Everything that changes this state outside the cache (ImGui, texture uploads, the geometry arena) makes the copy stale,
+// so the owner calls Invalidate() before it relies on it, e.g. at the start of the frame. After that the first call of each kind is issued.
+class GLStateCache
+{
+public:
+	struct Stats
+	{
+		std::uint32_t issued = 0; // calls passed on to OpenGL
+		std::uint32_t elided = 0; // calls filtered out, the state was already set
+	};
+
+	GLStateCache() { Invalidate(); }
+
+	// Forgets the whole state, the next calls are all issued
+	void Invalidate();
+
+	void UseProgram( GLuint programID );
+	void BindVertexArray( GLuint vaoID );
+	// glActiveTexture( GL_TEXTURE0 + unit ) only if needed, then glBindTexture
+	void BindTexture( GLuint unit, GLenum target, GLuint textureID );
+
+	// GL_BLEND, GL_CULL_FACE or GL_DEPTH_TEST, other capabilities are passed on every time
+	void Enable( GLenum capability ) { SetCapability( capability, true ); }
+	void Disable( GLenum capability ) { SetCapability( capability, false ); }
+	void SetCapability( GLenum capability, bool enabled );
+
+	void BlendFunc( GLenum sourceFactor, GLenum destinationFactor );
+	void DepthFunc( GLenum depthFunc );
+	void CullFace( GLenum face );
+
+	const Stats& GetStats() const noexcept { return m_stats; }
+	void ResetStats() noexcept { m_stats = {}; }
+
+	static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+
+private:
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	enum TextureTarget : int
+	{
+		TARGET_2D,
+		TARGET_2D_ARRAY,
+		TARGET_CUBE_MAP,
+		TARGET_COUNT
+	};
+	static int TargetIndex( GLenum target ) noexcept;
+
+	enum Capability : int
+	{
+		CAP_BLEND,
+		CAP_CULL_FACE,
+		CAP_DEPTH_TEST,
+		CAP_COUNT
+	};
+	static int CapabilityIndex( GLenum capability ) noexcept;
+
+	void ActiveTexture( GLuint unit );
+
+	// true (and counts it as issued) if value differs from the cached one, which is then updated
+	bool Changes( GLuint& cached, GLuint value ) noexcept;
+
+	GLuint m_programID = UNKNOWN;
+	GLuint m_vaoID     = UNKNOWN;
+
+	GLuint m_activeUnit = UNKNOWN;
+	GLuint m_textureIDs[ MAX_TEXTURE_UNITS ][ TARGET_COUNT ];
+
+	GLuint m_capabilities[ CAP_COUNT ]; // GL_TRUE, GL_FALSE or UNKNOWN
+
+	GLuint m_blendSourceFactor      = UNKNOWN;
+	GLuint m_blendDestinationFactor = UNKNOWN;
+	GLuint m_depthFunc = UNKNOWN;
+	GLuint m_cullFace  = UNKNOWN;
+
+	Stats m_stats;
+};
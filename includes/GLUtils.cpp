@@ -1,9 +1,14 @@
 #include "GLUtils.hpp"
+#include "MappedFile.h"
+#include "PixelPipeline.h"
+#include "ProgramCache.h"
 
 #include <stdio.h>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
 
 #include <SDL2/SDL_image.h>
 
@@ -23,12 +28,9 @@ void loadShader( const GLuint loadedShader, const std::filesystem::path& _fileNa
 		return;
 	}
 
-	// shaderkod betoltese _fileName fajlbol
-	std::string shaderCode = "";
-
-	// _fileName megnyitasa
-	std::ifstream shaderStream( _fileName );
-	if ( !shaderStream.is_open() )
+	// _fileName teljes tartalma egyben, soronkénti másolgatás nélkül
+	MappedFile shaderFile( _fileName, MappedFile::AccessHint::Sequential );
+	if ( !shaderFile )
 	{
 		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
 						SDL_LOG_PRIORITY_ERROR,
@@ -36,16 +38,7 @@ void loadShader( const GLuint loadedShader, const std::filesystem::path& _fileNa
 		return;
 	}
 
-	// file tartalmanak betoltese a shaderCode string-be
-	std::string line = "";
-	while ( std::getline( shaderStream, line ) )
-	{
-		shaderCode += line + "\n";
-	}
-
-	shaderStream.close();
-
-	compileShaderFromSource( loadedShader, shaderCode );
+	compileShaderFromSource( loadedShader, std::string_view( shaderFile.Data(), shaderFile.Size() ) );
 }
 
 void compileShaderFromSource( const GLuint loadedShader, std::string_view shaderCode )
@@ -80,13 +73,141 @@ void compileShaderFromSource( const GLuint loadedShader, std::string_view shader
 }
 
 
-void AssembleProgram( const GLuint programID, const std::filesystem::path& vs_filename, const std::filesystem::path& fs_filename )
+// A sor direktívájának neve (pl. "include"), a rest-be a név utáni rész kerül; üres, ha a sor nem direktíva
+static std::string_view directiveOf( std::string_view line, std::string_view& rest )
+{
+	auto skipSpaces = [ &line ]() { while ( !line.empty() && ( line.front() == ' ' || line.front() == '\t' ) ) line.remove_prefix( 1 ); };
+
+	skipSpaces();
+	if ( line.empty() || line.front() != '#' ) return {};
+	line.remove_prefix( 1 );
+	skipSpaces();
+
+	std::size_t nameLength = 0;
+	while ( nameLength < line.size() && std::isalpha( static_cast<unsigned char>( line[ nameLength ] ) ) ) ++nameLength;
+	const std::string_view name = line.substr( 0, nameLength );
+	line.remove_prefix( nameLength );
+	skipSpaces();
+
+	rest = line;
+	return name;
+}
+
+// Blokk kommentben ér-e véget a sor, ha inComment szerint abban kezdődött (a kikommentezett direktívák nem számítanak)
+static bool endsInBlockComment( std::string_view line, bool inComment )
+{
+	for ( std::size_t i = 0; i + 1 < line.size(); ++i )
+	{
+		if ( inComment )
+		{
+			if ( line[ i ] == '*' && line[ i + 1 ] == '/' ) { inComment = false; ++i; }
+		}
+		else if ( line[ i ] == '/' && line[ i + 1 ] == '/' ) break;
+		else if ( line[ i ] == '/' && line[ i + 1 ] == '*' ) { inComment = true; ++i; }
+	}
+	return inComment;
+}
+
+// fileName hozzáfűzése a source-hoz, az include-ok rekurzív beillesztésével.
+// Minden fájl saját forrás sorszámot kap a #line direktívákban, így a fordító hibaüzenetei a fájl sorára mutatnak (0: a shader maga).
+static bool appendShaderFile( std::string& source, const std::filesystem::path& fileName, const std::vector<std::string>& defines,
+							  std::vector<std::filesystem::path>& includeStack, int& sourceStringCount )
+{
+	MappedFile shaderFile( fileName, MappedFile::AccessHint::Sequential );
+	if ( !shaderFile )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
+						SDL_LOG_PRIORITY_ERROR,
+						"Error while opening shader file %s!", fileName.string().c_str() );
+		return false;
+	}
+
+	const int sourceStringNumber = sourceStringCount++;
+	includeStack.push_back( fileName.lexically_normal() );
+
+	std::string_view text( shaderFile.Data(), shaderFile.Size() );
+	int lineNumber = 0;
+	bool inComment = false;
+
+	while ( !text.empty() )
+	{
+		const std::size_t lineEnd = text.find( '\n' );
+		const std::string_view line = text.substr( 0, lineEnd );
+		text.remove_prefix( lineEnd == std::string_view::npos ? text.size() : lineEnd + 1 );
+		++lineNumber;
+
+		std::string_view rest;
+		const std::string_view directive = inComment ? std::string_view() : directiveOf( line, rest );
+
+		if ( directive == "include" )
+		{
+			const std::size_t nameEnd = rest.size() > 1 && rest.front() == '"' ? rest.find( '"', 1 ) : std::string_view::npos;
+			if ( nameEnd == std::string_view::npos )
+			{
+				SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
+								SDL_LOG_PRIORITY_ERROR,
+								"[PreprocessShader] %s(%d): #include expects \"file name\"", fileName.string().c_str(), lineNumber );
+				return false;
+			}
+
+			const std::filesystem::path includeFileName = fileName.parent_path() / std::string( rest.substr( 1, nameEnd - 1 ) );
+			if ( std::find( includeStack.cbegin(), includeStack.cend(), includeFileName.lexically_normal() ) != includeStack.cend() )
+			{
+				SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
+								SDL_LOG_PRIORITY_ERROR,
+								"[PreprocessShader] %s(%d): %s includes itself", fileName.string().c_str(), lineNumber, includeFileName.string().c_str() );
+				return false;
+			}
+
+			source += "#line 1 " + std::to_string( sourceStringCount ) + "\n";
+			if ( !appendShaderFile( source, includeFileName, defines, includeStack, sourceStringCount ) ) return false;
+			source += "#line " + std::to_string( lineNumber + 1 ) + " " + std::to_string( sourceStringNumber ) + "\n";
+			continue;
+		}
+
+		source.append( line ).push_back( '\n' );
+
+		// a makróknak a #version után kell jönniük, az pedig csak a shader fájljában lehet
+		if ( directive == "version" && includeStack.size() == 1 )
+		{
+			for ( const std::string& define : defines ) source += "#define " + define + "\n";
+			source += "#line " + std::to_string( lineNumber + 1 ) + " " + std::to_string( sourceStringNumber ) + "\n";
+		}
+
+		inComment = endsInBlockComment( line, inComment );
+	}
+
+	includeStack.pop_back();
+	return true;
+}
+
+bool PreprocessShader( std::string& source, const std::filesystem::path& fileName, const std::vector<std::string>& defines )
+{
+	source.clear();
+
+	std::vector<std::filesystem::path> includeStack;
+	int sourceStringCount = 0;
+	return appendShaderFile( source, fileName, defines, includeStack, sourceStringCount );
+}
+
+bool AssembleProgram( const GLuint programID, const std::filesystem::path& vs_filename, const std::filesystem::path& fs_filename, const std::vector<std::string>& defines )
 {
 	//
 	// shaderek betöltése
 	//
 
-	if ( programID == 0 ) return;
+	if ( programID == 0 ) return false;
+
+	std::string vsCode;
+	std::string fsCode;
+	if ( !PreprocessShader( vsCode, vs_filename, defines ) || !PreprocessShader( fsCode, fs_filename, defines ) ) return false;
+
+	// ha ugyanezekből az előfeldolgozott forrásokból ugyanez a driver már linkelt programot, elég a binárist betölteni
+	const bool binaryCacheSupported = ProgramCache::IsSupported();
+	const std::filesystem::path cacheFileName = ProgramCache::CachePathFor( vs_filename, fs_filename, defines );
+	const uint64_t cacheKey = binaryCacheSupported ? ProgramCache::KeyFor( { vsCode, fsCode } ) : 0;
+
+	if ( binaryCacheSupported && ProgramCache::Load( programID, cacheFileName, cacheKey ) ) return true;
 
 	GLuint vs_ID = glCreateShader( GL_VERTEX_SHADER   );
 	GLuint fs_ID = glCreateShader( GL_FRAGMENT_SHADER );
@@ -96,13 +217,16 @@ void AssembleProgram( const GLuint programID, const std::filesystem::path& vs_fi
 		SDL_SetError("Error while initing shaders (glCreateShader)!");
 	}
 
-	loadShader(vs_ID, vs_filename );
-	loadShader(fs_ID, fs_filename );
+	compileShaderFromSource( vs_ID, vsCode );
+	compileShaderFromSource( fs_ID, fsCode );
 
 	// adjuk hozzá a programhoz a shadereket
 	glAttachShader(programID, vs_ID);
 	glAttachShader(programID, fs_ID);
 
+	// a linkelt program binárisát el akarjuk menteni
+	if ( binaryCacheSupported ) glProgramParameteri( programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+
 	// illesszük össze a shadereket (kimenő-bemenő változók összerendelése stb.)
 	glLinkProgram(programID);
 
@@ -120,41 +244,19 @@ void AssembleProgram( const GLuint programID, const std::filesystem::path& vs_fi
 						"[glLinkProgram] Shader linking error: %s" , ErrorMessage.data() );
 	}
 
+	if ( result == GL_TRUE && binaryCacheSupported ) ProgramCache::Store( programID, cacheFileName, cacheKey );
+
 	// mar nincs ezekre szukseg
+	glDetachShader( programID, vs_ID );
+	glDetachShader( programID, fs_ID );
 	glDeleteShader( vs_ID );
 	glDeleteShader( fs_ID );
-}
-
-static void invert_image_RGBA(int pitchInPixels, int height, Uint32* image_pixels)
-{
-	int height_div_2 = height / 2;
-	Uint32* lower_data  =image_pixels;
-	Uint32* higher_data =image_pixels + ( height - 1 ) * pitchInPixels;
 
-	for ( int index = 0; index < height_div_2; index++ )
-	{
-		for ( int rowIndex = 0; rowIndex < pitchInPixels; rowIndex++ )
-		{
-			*lower_data ^= higher_data[ rowIndex ];
-			higher_data[ rowIndex ] ^= *lower_data;
-			*lower_data ^= higher_data[ rowIndex ];
-
-			lower_data++;
-		}
-		higher_data -= pitchInPixels;
-	}
+	return result == GL_TRUE;
 }
 
-void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, GLenum Type, GLenum Role )
+bool ImageFromFile( ImageRGBA& image, const std::filesystem::path& fileName, bool flipVertically )
 {
-	if ( tex == 0 )
-	{
-		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR, 
-						SDL_LOG_PRIORITY_ERROR,
-						"Texture object needs to be inited before loading %s !", fileName.string().c_str());
-		return;
-	}
-
 	// Kép betöltése
 	SDL_Surface* loaded_img = IMG_Load(fileName.string().c_str());
 
@@ -163,7 +265,7 @@ void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, G
 		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR, 
 						SDL_LOG_PRIORITY_ERROR,
 						"[TextureFromFile] Error while loading texture: %s", fileName.string().c_str());
-		return;
+		return false;
 	}
 
 	// Uint32-ben tárolja az SDL a színeket, ezért számít a bájtsorrend
@@ -173,58 +275,102 @@ void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, G
 	Uint32 format = SDL_PIXELFORMAT_RGBA8888;
 #endif
 
-	// Átalakítás 32bit RGBA formátumra, ha nem abban volt
-	SDL_Surface* formattedSurf = SDL_ConvertSurfaceFormat(loaded_img, format, 0);
-	SDL_FreeSurface(loaded_img);
-	if (formattedSurf == nullptr)
+	// Átalakítás 32bit RGBA formátumra, ha nem abban volt (a PNG-k általában már abban vannak, ilyenkor nem kell másolat)
+	SDL_Surface* formattedSurf = loaded_img;
+	if ( loaded_img->format->format != format )
 	{
-		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR, 
-						SDL_LOG_PRIORITY_ERROR,
-						"[TextureFromFile] Error while processing texture");
-		return;
+		formattedSurf = SDL_ConvertSurfaceFormat(loaded_img, format, 0);
+		SDL_FreeSurface(loaded_img);
+		if (formattedSurf == nullptr)
+		{
+			SDL_LogMessage( SDL_LOG_CATEGORY_ERROR, 
+							SDL_LOG_PRIORITY_ERROR,
+							"[TextureFromFile] Error while processing texture");
+			return false;
+		}
 	}
 
-	// Áttérés SDL koordinátarendszerről ( (0,0) balfent ) OpenGL textúra-koordinátarendszerre ( (0,0) ballent )
-	if ( Type != GL_TEXTURE_CUBE_MAP && Type != GL_TEXTURE_CUBE_MAP_ARRAY )
-		invert_image_RGBA( formattedSurf->pitch / sizeof( Uint32 ), formattedSurf->h, reinterpret_cast<Uint32*>( formattedSurf->pixels ) );
+	// A pixelek átmásolása soronként, a surface sorai ki lehetnek töltve.
+	// Áttérés SDL koordinátarendszerről ( (0,0) balfent ) OpenGL textúra-koordinátarendszerre ( (0,0) ballent ):
+	// a sorok fordított sorrendben kerülnek a képbe, így nem kell külön menet a tükrözéshez
+	PixelPipeline::CopyRows( image, formattedSurf->pixels, formattedSurf->w, formattedSurf->h, formattedSurf->pitch, flipVertically );
 
+	// Használt SDL_Surface felszabadítása
+	SDL_FreeSurface(formattedSurf);
+
+	return true;
+}
+
+void TextureFromImage( const GLuint tex, const ImageRGBA& image, GLenum Type, GLenum Role, GLint level )
+{
 	glBindTexture(Type, tex);
 	glTexImage2D(
 		Role, 						// melyik binding point-on van a textúra erőforrás, amihez tárolást rendelünk
-		0, 							// melyik részletességi szint adatait határozzuk meg
+		level, 						// melyik részletességi szint adatait határozzuk meg
 		GL_RGBA, 					// textúra belső tárolási formátuma (GPU-n)
-		formattedSurf->w, 			// szélesség
-		formattedSurf->h, 			// magasság
+		image.width, 				// szélesség
+		image.height, 				// magasság
 		0, 							// nulla kell, hogy legyen ( https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml )
 		GL_RGBA, 					// forrás (=CPU-n) formátuma
 		GL_UNSIGNED_BYTE, 			// forrás egy pixelének egy csatornáját hogyan tároljuk
-		formattedSurf->pixels);		// forráshoz pointer
+		image.pixels.data());		// forráshoz pointer
 
 	glBindTexture(Type, 0);
+}
 
-	// Használt SDL_Surface-k felszabadítása
-	SDL_FreeSurface(formattedSurf);
+void TextureStorage( const GLuint tex, GLenum Type, GLsizei levelCount, int width, int height )
+{
+	glBindTexture( Type, tex );
+	glTexStorage2D( Type, levelCount, GL_RGBA8, width, height );
+	glBindTexture( Type, 0 );
+}
+
+void TextureSubImage( const GLuint tex, const std::uint32_t* pixels, int width, int height, GLenum Type, GLenum Role, GLint level )
+{
+	glBindTexture( Type, tex );
+	glTexSubImage2D( Role, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+	glBindTexture( Type, 0 );
+}
+
+void TextureArrayStorage( const GLuint tex, GLsizei levelCount, int width, int height, int layerCount )
+{
+	glBindTexture( GL_TEXTURE_2D_ARRAY, tex );
+	glTexStorage3D( GL_TEXTURE_2D_ARRAY, levelCount, GL_RGBA8, width, height, layerCount );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+}
+
+void TextureArraySubImage( const GLuint tex, const std::uint32_t* pixels, int width, int height, int layer, GLint level )
+{
+	glBindTexture( GL_TEXTURE_2D_ARRAY, tex );
+	glTexSubImage3D( GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+}
+
+void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, GLenum Type, GLenum Role )
+{
+	if ( tex == 0 )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR, 
+						SDL_LOG_PRIORITY_ERROR,
+						"Texture object needs to be inited before loading %s !", fileName.string().c_str());
+		return;
+	}
+
+	ImageRGBA image;
+	if ( !ImageFromFile( image, fileName, Type != GL_TEXTURE_CUBE_MAP && Type != GL_TEXTURE_CUBE_MAP_ARRAY ) ) return;
+
+	TextureFromImage( tex, image, Type, Role );
 }
 
-void SetupTextureSampling( GLenum Target, GLuint textureID, bool generateMipMap )
+void SetupTextureSampling( GLenum Target, GLuint textureID, MipMaps mipMaps )
 {
 	// mintavételezés beállításai
 	glBindTexture( Target, textureID );
-	if ( generateMipMap ) glGenerateMipmap( Target ); // Mipmap generálása
+	if ( mipMaps == MipMaps::Generate ) glGenerateMipmap( Target ); // Mipmap generálása
 	glTexParameteri( Target, GL_TEXTURE_MAG_FILTER, GL_LINEAR ); // bilineáris szürés nagyításkor (ez az alapértelmezett)
-	glTexParameteri( Target, GL_TEXTURE_MIN_FILTER, generateMipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR ); // trilineáris szűrés a mipmap-ekböl kicsinyítéskor
+	glTexParameteri( Target, GL_TEXTURE_MIN_FILTER, mipMaps != MipMaps::None ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR ); // trilineáris szűrés a mipmap-ekböl kicsinyítéskor
 	// mi legyen az eredmény, ha a textúrán kívülröl próbálunk mintát venni?
 	glTexParameteri( Target, GL_TEXTURE_WRAP_S, GL_REPEAT ); // vízszintesen
 	glTexParameteri( Target, GL_TEXTURE_WRAP_T, GL_REPEAT ); // függölegesen
 	glBindTexture( Target, 0 );
 }
-
-void CleanOGLObject( OGLObject& ObjectGPU )
-{
-	glDeleteBuffers(1,      &ObjectGPU.vboID);
-	ObjectGPU.vboID = 0;
-	glDeleteBuffers(1,      &ObjectGPU.iboID);
-	ObjectGPU.iboID = 0;
-	glDeleteVertexArrays(1, &ObjectGPU.vaoID);
-	ObjectGPU.vaoID = 0;
-}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <string>
 #include <vector>
 
 #include <GL/glew.h>
@@ -38,13 +40,49 @@ struct Vertex
 void loadShader( const GLuint loadedShader, const std::filesystem::path& _fileName );
 void compileShaderFromSource( const GLuint loadedShader, std::string_view shaderCode );
 
-void AssembleProgram( const GLuint programID, const std::filesystem::path& vs_filename, const std::filesystem::path& fs_filename );
+// GLSL forrás előfeldolgozása: az #include "fájl" sorok helyére a fájl tartalma kerül (a befoglaló fájlhoz képest relatív útvonal),
+// a defines elemei pedig #define-ként a #version sor után. Hamis, ha valamelyik fájl nem nyitható meg, vagy körkörös az include.
+bool PreprocessShader( std::string& source, const std::filesystem::path& fileName, const std::vector<std::string>& defines = {} );
+
+// A két shader programmá linkelése (vagy a ProgramCache-ből betöltése), mindkettő a defines makrókkal előfeldolgozva.
+// Hamis, ha a program nem linkelődött.
+bool AssembleProgram( const GLuint programID, const std::filesystem::path& vs_filename, const std::filesystem::path& fs_filename, const std::vector<std::string>& defines = {} );
+
+// CPU oldali 32 bites RGBA kép, a sorok között nincs kitöltés
+struct ImageRGBA
+{
+	int width  = 0;
+	int height = 0;
+	std::vector<std::uint32_t> pixels;
+};
+
+// Kép betöltése és átalakítása RGBA formátumra. Nem hív OpenGL-t, így bármelyik szálon hívható.
+// flipVertically: áttérés OpenGL textúra-koordinátarendszerre ( (0,0) ballent ), cube map lapoknál nem kell
+bool ImageFromFile( ImageRGBA& image, const std::filesystem::path& fileName, bool flipVertically = true );
+
+// A betöltött kép feltöltése a textúra Role binding pointjára (pl. egy cube map lapjára), a level részletességi szintre
+void TextureFromImage( const GLuint tex, const ImageRGBA& image, GLenum Type, GLenum Role, GLint level = 0 );
+
+// Megváltoztathatatlan méretű tároló (glTexStorage2D) levelCount részletességi szinttel, 8 bites RGBA texelekkel
+void TextureStorage( const GLuint tex, GLenum Type, GLsizei levelCount, int width, int height );
+
+// RGBA pixelek feltöltése a TextureStorage-dzsel lefoglalt tároló egy szintjére (cube map esetén Role a lap)
+void TextureSubImage( const GLuint tex, const std::uint32_t* pixels, int width, int height, GLenum Type, GLenum Role, GLint level = 0 );
+
+// GL_TEXTURE_2D_ARRAY tároló (glTexStorage3D) layerCount egyforma méretű réteggel
+void TextureArrayStorage( const GLuint tex, GLsizei levelCount, int width, int height, int layerCount );
+
+// RGBA pixelek feltöltése a tömb egy rétegének egy szintjére
+void TextureArraySubImage( const GLuint tex, const std::uint32_t* pixels, int width, int height, int layer, GLint level = 0 );
 
 void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, GLenum Type, GLenum Role );
 
 inline void TextureFromFile( const GLuint tex, const std::filesystem::path& fileName, GLenum Type = GL_TEXTURE_2D ) { TextureFromFile( tex, fileName, Type, Type ); }
 
-void SetupTextureSampling( GLenum Target, GLuint textureID, bool generateMipMap = true );
+// None: nincs mipmap, Generate: glGenerateMipmap készíti, Uploaded: a szintek már fel vannak töltve (pl. PixelPipeline::BuildMipChain)
+enum class MipMaps { None, Generate, Uploaded };
+
+void SetupTextureSampling( GLenum Target, GLuint textureID, MipMaps mipMaps = MipMaps::Generate );
 
 template<typename VertexT>
 struct MeshObject
@@ -53,14 +91,22 @@ struct MeshObject
     std::vector<GLuint>  indexArray;
 };
 
-struct OGLObject
+// Nem birtokolt mesh adat, pl. egy memóriába leképezett fájlban
+template<typename VertexT>
+struct MeshView
 {
-    GLuint  vaoID = 0; // vertex array object erőforrás azonosító
-    GLuint  vboID = 0; // vertex buffer object erőforrás azonosító
-    GLuint  iboID = 0; // index buffer object erőforrás azonosító
-    GLsizei count = 0; // mennyi indexet/vertexet kell rajzolnunk
+    const VertexT* vertices    = nullptr;
+    std::size_t    vertexCount = 0;
+    const GLuint*  indices     = nullptr;
+    std::size_t    indexCount  = 0;
 };
 
+// Az index puffer egy elemének mérete bájtban, pl. a glDrawElements kezdő offsetjéhez
+inline std::size_t IndexTypeSize( GLenum indexType )
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof( GLushort ) : sizeof( GLuint );
+}
+
 
 struct VertexAttributeDescriptor
 {
@@ -68,54 +114,5 @@ struct VertexAttributeDescriptor
 	std::uintptr_t strideInBytes = 0;
 	GLint          numberOfComponents = 0;
 	GLenum         glType = GL_NONE;
+	GLboolean      normalized = GL_FALSE; // egész típusok [-1,1] ill. [0,1] tartományra képezése (snorm/unorm)
 };
-
-template <typename VertexT>
-[[nodiscard]] OGLObject CreateGLObjectFromMesh( const MeshObject<VertexT>& mesh, std::initializer_list<VertexAttributeDescriptor> vertexAttrDescList )
-{
-	OGLObject meshGPU = { 0 };
-
-	// 1 db VAO foglalasa
-	glGenVertexArrays(1, &meshGPU.vaoID);
-	// a frissen generált VAO beallitasa aktívnak
-	glBindVertexArray(meshGPU.vaoID);
-
-	// hozzunk létre egy új VBO erőforrás nevet
-	glGenBuffers(1, &meshGPU.vboID);
-	glBindBuffer(GL_ARRAY_BUFFER, meshGPU.vboID); // tegyük "aktívvá" a létrehozott VBO-t
-
-	// töltsük fel adatokkal az aktív VBO-t
-	glBufferData(GL_ARRAY_BUFFER,	// az aktív VBO-ba töltsünk adatokat
-				  mesh.vertexArray.size() * sizeof(VertexT),		// ennyi bájt nagyságban
-				  mesh.vertexArray.data(),	// erről a rendszermemóriabeli címről olvasva
-				  GL_STATIC_DRAW);	// úgy, hogy a VBO-nkba nem tervezünk ezután írni és minden kirajzoláskor felhasnzáljuk a benne lévő adatokat
-
-	// index puffer létrehozása
-	glGenBuffers(1, &meshGPU.iboID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshGPU.iboID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexArray.size() * sizeof(GLuint), mesh.indexArray.data(), GL_STATIC_DRAW);
-
-	meshGPU.count = static_cast<GLsizei>(mesh.indexArray.size());
-
-	for ( const auto& vertexAttrDesc: vertexAttrDescList )
-	{
-		glEnableVertexAttribArray(vertexAttrDesc.index); // ez lesz majd a pozíció
-		glVertexAttribPointer(
-			vertexAttrDesc.index,				  // a VB-ben található adatok közül a 0. "indexű" attribútumait állítjuk be
-			vertexAttrDesc.numberOfComponents,	  // komponens szam
-			vertexAttrDesc.glType,				  // adatok tipusa
-			GL_FALSE,							  // normalizalt legyen-e
-			sizeof(VertexT),					  // stride (0=egymas utan)
-			reinterpret_cast<const void*>(vertexAttrDesc.strideInBytes) // a 0. indexű attribútum hol kezdődik a sizeof(Vertex)-nyi területen belül
-		);
-	}
-
-	glBindVertexArray(0); // feltöltüttük a VAO-t, kapcsoljuk le
-	glBindBuffer(GL_ARRAY_BUFFER, 0); // feltöltöttük a VBO-t is, ezt is vegyük le
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	return meshGPU;
-}
-
-void CleanOGLObject( OGLObject& ObjectGPU );
-
@@ -0,0 +1,214 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include <SDL2/SDL.h>
+
+RangeAllocator::RangeAllocator( std::size_t capacity )
+{
+	Grow( capacity );
+}
+
+std::size_t RangeAllocator::Allocate( std::size_t size, std::size_t alignment )
+{
+	for ( auto range = m_freeRanges.begin(); range != m_freeRanges.end(); ++range )
+	{
+		const std::size_t rangeOffset = range->first;
+		const std::size_t rangeSize   = range->second;
+
+		const std::size_t alignedOffset = ( rangeOffset + alignment - 1 ) / alignment * alignment;
+		const std::size_t padding       = alignedOffset - rangeOffset;
+		if ( rangeSize < padding + size ) continue;
+
+		// the padding before and the rest after the allocation stay free
+		m_freeRanges.erase( range );
+		if ( padding > 0 ) m_freeRanges.emplace( rangeOffset, padding );
+		if ( rangeSize > padding + size ) m_freeRanges.emplace( alignedOffset + size, rangeSize - padding - size );
+
+		return alignedOffset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void RangeAllocator::Free( std::size_t offset, std::size_t size )
+{
+	if ( size == 0 ) return;
+
+	auto next = m_freeRanges.lower_bound( offset );
+
+	if ( next != m_freeRanges.begin() )
+	{
+		const auto previous = std::prev( next );
+		if ( previous->first + previous->second == offset )
+		{
+			offset = previous->first;
+			size  += previous->second;
+			m_freeRanges.erase( previous );
+		}
+	}
+
+	if ( next != m_freeRanges.end() && offset + size == next->first )
+	{
+		size += next->second;
+		m_freeRanges.erase( next );
+	}
+
+	m_freeRanges.emplace( offset, size );
+}
+
+void RangeAllocator::Grow( std::size_t newCapacity )
+{
+	if ( newCapacity <= m_capacity ) return;
+
+	const std::size_t oldCapacity = m_capacity;
+	m_capacity = newCapacity;
+	Free( oldCapacity, newCapacity - oldCapacity );
+}
+
+// Immutable storage, written with glBufferSubData
+static GLuint createBuffer( std::size_t size )
+{
+	GLuint bufferID = 0;
+	glGenBuffers( 1, &bufferID );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, bufferID );
+	glBufferStorage( GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>( size ), nullptr, GL_DYNAMIC_STORAGE_BIT );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+	return bufferID;
+}
+
+void GeometryArena::Init( std::size_t vertexStride, std::initializer_list<VertexAttributeDescriptor> vertexAttrDescList, std::size_t vertexCapacity, std::size_t indexCapacity )
+{
+	m_vertexStride = vertexStride;
+	m_vertexRanges = RangeAllocator( std::max<std::size_t>( vertexCapacity, 1 ) );
+	m_indexRanges  = RangeAllocator( std::max<std::size_t>( indexCapacity, 1 ) );
+
+	m_vboID = createBuffer( m_vertexRanges.Capacity() * m_vertexStride );
+	m_iboID = createBuffer( m_indexRanges.Capacity() );
+
+	// the attribute formats are separate from the buffer (binding point 0), so a grown buffer is just bound again
+	glGenVertexArrays( 1, &m_vaoID );
+	glBindVertexArray( m_vaoID );
+
+	for ( const VertexAttributeDescriptor& vertexAttrDesc : vertexAttrDescList )
+	{
+		glEnableVertexAttribArray( vertexAttrDesc.index );
+		glVertexAttribFormat( vertexAttrDesc.index,
+							  vertexAttrDesc.numberOfComponents,
+							  vertexAttrDesc.glType,
+							  vertexAttrDesc.normalized,
+							  static_cast<GLuint>( vertexAttrDesc.strideInBytes ) );
+		glVertexAttribBinding( vertexAttrDesc.index, 0 );
+	}
+
+	glBindVertexArray( 0 );
+
+	BindBuffersToVao();
+}
+
+void GeometryArena::Clean()
+{
+	glDeleteBuffers( 1, &m_vboID );
+	m_vboID = 0;
+	glDeleteBuffers( 1, &m_iboID );
+	m_iboID = 0;
+	glDeleteVertexArrays( 1, &m_vaoID );
+	m_vaoID = 0;
+
+	m_vertexStride = 0;
+	m_vertexRanges = RangeAllocator();
+	m_indexRanges  = RangeAllocator();
+}
+
+void GeometryArena::Free( ArenaMesh& mesh )
+{
+	if ( mesh.count == 0 ) return;
+
+	m_vertexRanges.Free( static_cast<std::size_t>( mesh.baseVertex ), static_cast<std::size_t>( mesh.vertexCount ) );
+	m_indexRanges.Free( mesh.indexOffset, static_cast<std::size_t>( mesh.count ) * IndexTypeSize( mesh.indexType ) );
+
+	mesh = {};
+}
+
+ArenaMesh GeometryArena::Allocate( const void* vertices, std::size_t vertexStride, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount )
+{
+	ArenaMesh mesh;
+
+	if ( vertexStride != m_vertexStride )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_ERROR,
+						"[GeometryArena] %zu byte vertices do not fit an arena of %zu byte vertices", vertexStride, m_vertexStride );
+		return mesh;
+	}
+	if ( vertexCount == 0 || indexCount == 0 ) return mesh;
+
+	// the indices are relative to the mesh, so 16 bits are enough for most meshes even in a large arena
+	const bool shortIndices = vertexCount <= std::size_t( std::numeric_limits<GLushort>::max() ) + 1;
+	mesh.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	const std::size_t indexSize = IndexTypeSize( mesh.indexType );
+
+	const std::size_t firstVertex = AllocateRange( m_vertexRanges, m_vboID, m_vertexStride, vertexCount, 1 );
+	mesh.indexOffset = AllocateRange( m_indexRanges, m_iboID, 1, indexCount * indexSize, indexSize );
+	mesh.baseVertex  = static_cast<GLint>( firstVertex );
+	mesh.vertexCount = static_cast<GLsizei>( vertexCount );
+	mesh.count       = static_cast<GLsizei>( indexCount );
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, m_vboID );
+	glBufferSubData( GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( firstVertex * m_vertexStride ), static_cast<GLsizeiptr>( vertexCount * m_vertexStride ), vertices );
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, m_iboID );
+	if ( shortIndices )
+	{
+		std::vector<GLushort> shortIndexArray( indexCount );
+		std::transform( indices, indices + indexCount, shortIndexArray.begin(), []( GLuint index ) { return static_cast<GLushort>( index ); } );
+		glBufferSubData( GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( mesh.indexOffset ), static_cast<GLsizeiptr>( indexCount * indexSize ), shortIndexArray.data() );
+	}
+	else
+	{
+		glBufferSubData( GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( mesh.indexOffset ), static_cast<GLsizeiptr>( indexCount * indexSize ), indices );
+	}
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+	return mesh;
+}
+
+std::size_t GeometryArena::AllocateRange( RangeAllocator& allocator, GLuint& bufferID, std::size_t unitSize, std::size_t size, std::size_t alignment )
+{
+	std::size_t offset = allocator.Allocate( size, alignment );
+	if ( offset != RangeAllocator::INVALID_OFFSET ) return offset;
+
+	// doubled until the request surely fits after the free space at the end
+	const std::size_t oldCapacity = allocator.Capacity();
+	std::size_t newCapacity = oldCapacity * 2;
+	while ( newCapacity < oldCapacity + size + alignment ) newCapacity *= 2;
+
+	const GLuint newBufferID = createBuffer( newCapacity * unitSize );
+	glBindBuffer( GL_COPY_READ_BUFFER, bufferID );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, newBufferID );
+	glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>( oldCapacity * unitSize ) );
+	glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+	glDeleteBuffers( 1, &bufferID );
+	bufferID = newBufferID;
+	BindBuffersToVao();
+
+	allocator.Grow( newCapacity );
+
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[GeometryArena] Buffer grown to %zu bytes", newCapacity * unitSize );
+
+	return allocator.Allocate( size, alignment );
+}
+
+void GeometryArena::BindBuffersToVao()
+{
+	glBindVertexArray( m_vaoID );
+	glBindVertexBuffer( 0, m_vboID, 0, static_cast<GLsizei>( m_vertexStride ) );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_iboID );
+	glBindVertexArray( 0 );
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <map>
+#include <vector>
+
+#include "GLUtils.hpp"
+
+// First fit free list over [ 0, capacity ), neighbouring free ranges are merged when a range is freed
+class RangeAllocator
+{
+public:
+	static constexpr std::size_t INVALID_OFFSET = ~std::size_t( 0 );
+
+	explicit RangeAllocator( std::size_t capacity = 0 );
+
+	// INVALID_OFFSET if there is no large enough free range
+	std::size_t Allocate( std::size_t size, std::size_t alignment = 1 );
+	void        Free( std::size_t offset, std::size_t size );
+
+	// the new space at the end is free
+	void        Grow( std::size_t newCapacity );
+
+	std::size_t Capacity() const noexcept { return m_capacity; }
+
+private:
+	std::size_t                        m_capacity = 0;
+	std::map<std::size_t, std::size_t> m_freeRanges; // offset -> size
+};
+
+// A mesh in a GeometryArena: its vertices and indices are ranges of the shared buffers.
+// The indices are relative to the first vertex of the mesh, glDrawElementsBaseVertex adds baseVertex.
+struct ArenaMesh
+{
+	GLint       baseVertex  = 0;
+	GLsizei     vertexCount = 0;
+	std::size_t indexOffset = 0; // in bytes, from the start of the index buffer
+	GLsizei     count       = 0; // number of indices, 0 if the mesh is not allocated
+	GLenum      indexType   = GL_UNSIGNED_SHORT;
+
+	// indexCount indices from firstIndex (e.g. a submesh), the VAO of the arena has to be bound
+	void Draw( GLsizei indexCount, std::size_t firstIndex = 0 ) const
+	{
+		glDrawElementsBaseVertex( GL_TRIANGLES, indexCount, indexType,
+								  reinterpret_cast<const void*>( indexOffset + firstIndex * IndexTypeSize( indexType ) ), baseVertex );
+	}
+	void Draw() const { Draw( count ); }
+};
+
+// One vertex buffer, one index buffer and one VAO for every mesh of a vertex format.
+//
+// Meshes are sub-allocated from the buffers, so creating or freeing one makes no GL objects,
+// and the draws of the meshes only switch the VAO when the vertex format changes.
+// The buffers grow (to a new buffer, with glCopyBufferSubData) when a mesh does not fit.
+class GeometryArena
+{
+public:
+	GeometryArena() = default;
+	GeometryArena( const GeometryArena& ) = delete;
+	GeometryArena& operator=( const GeometryArena& ) = delete;
+
+	// The buffers with room for vertexCapacity vertices and indexCapacity bytes of indices
+	template <typename VertexT>
+	void Init( std::initializer_list<VertexAttributeDescriptor> vertexAttrDescList, std::size_t vertexCapacity, std::size_t indexCapacity )
+	{
+		Init( sizeof( VertexT ), vertexAttrDescList, vertexCapacity, indexCapacity );
+	}
+	void Init( std::size_t vertexStride, std::initializer_list<VertexAttributeDescriptor> vertexAttrDescList, std::size_t vertexCapacity, std::size_t indexCapacity );
+	void Clean();
+
+	// Copies the mesh into the buffers. The indices are stored on 16 bits if the mesh has at most 65536 vertices.
+	template <typename VertexT>
+	[[nodiscard]] ArenaMesh Allocate( const MeshView<VertexT>& mesh )
+	{
+		return Allocate( mesh.vertices, sizeof( VertexT ), mesh.vertexCount, mesh.indices, mesh.indexCount );
+	}
+	template <typename VertexT>
+	[[nodiscard]] ArenaMesh Allocate( const MeshObject<VertexT>& mesh )
+	{
+		return Allocate( mesh.vertexArray.data(), sizeof( VertexT ), mesh.vertexArray.size(), mesh.indexArray.data(), mesh.indexArray.size() );
+	}
+
+	// The ranges of the mesh can be reused, mesh is reset
+	void Free( ArenaMesh& mesh );
+
+	GLuint VaoID() const noexcept { return m_vaoID; }
+
+private:
+	ArenaMesh Allocate( const void* vertices, std::size_t vertexStride, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount );
+
+	// Allocates from the allocator, grows the buffer first if needed
+	std::size_t AllocateRange( RangeAllocator& allocator, GLuint& bufferID, std::size_t unitSize, std::size_t size, std::size_t alignment );
+	void        BindBuffersToVao();
+
+	GLuint m_vaoID = 0;
+	GLuint m_vboID = 0;
+	GLuint m_iboID = 0;
+
+	std::size_t    m_vertexStride = 0;
+	RangeAllocator m_vertexRanges; // in vertices
+	RangeAllocator m_indexRanges;  // in bytes
+};
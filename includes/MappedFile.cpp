@@ -0,0 +1,163 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile( const std::filesystem::path& fileName, AccessHint hint )
+{
+	Open( fileName, hint );
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile( MappedFile&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+{
+	if ( this != &other )
+	{
+		Close();
+
+		m_data           = std::exchange( other.m_data, nullptr );
+		m_size           = std::exchange( other.m_size, 0 );
+		m_isOpen         = std::exchange( other.m_isOpen, false );
+		m_mapping        = std::exchange( other.m_mapping, nullptr );
+#ifdef _WIN32
+		m_mappingHandle  = std::exchange( other.m_mappingHandle, nullptr );
+#endif
+		// moving the vector keeps its data pointer valid
+		m_fallbackBuffer = std::move( other.m_fallbackBuffer );
+	}
+	return *this;
+}
+
+bool MappedFile::Open( const std::filesystem::path& fileName, AccessHint hint )
+{
+	Close();
+
+	std::error_code ec;
+	const std::uintmax_t fileSize = std::filesystem::file_size( fileName, ec );
+	if ( ec ) return false;
+
+	m_size = static_cast<std::size_t>( fileSize );
+
+	// An empty file cannot be mapped, but it is valid (empty) content
+	if ( m_size == 0 )
+	{
+		m_isOpen = true;
+		return true;
+	}
+
+#ifdef _WIN32
+	HANDLE fileHandle = ::CreateFileW( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+									   hint == AccessHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+									   nullptr );
+	if ( fileHandle != INVALID_HANDLE_VALUE )
+	{
+		HANDLE mappingHandle = ::CreateFileMappingW( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		// the mapping stays alive after the file handle is closed
+		::CloseHandle( fileHandle );
+
+		if ( mappingHandle != nullptr )
+		{
+			void* view = ::MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+			if ( view != nullptr )
+			{
+				m_mapping       = view;
+				m_mappingHandle = mappingHandle;
+				m_data          = static_cast<const char*>( view );
+				m_isOpen        = true;
+				return true;
+			}
+			::CloseHandle( mappingHandle );
+		}
+	}
+#else
+	const int fd = ::open( fileName.c_str(), O_RDONLY | O_CLOEXEC );
+	if ( fd != -1 )
+	{
+		void* view = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		// the mapping stays alive after the descriptor is closed
+		::close( fd );
+
+		if ( view != MAP_FAILED )
+		{
+			::madvise( view, m_size, hint == AccessHint::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM );
+			if ( hint == AccessHint::Sequential ) ::madvise( view, m_size, MADV_WILLNEED );
+
+			m_mapping = view;
+			m_data    = static_cast<const char*>( view );
+			m_isOpen  = true;
+			return true;
+		}
+	}
+#endif
+
+	// Mapping failed, fall back to reading the whole file
+	return ReadIntoBuffer( fileName );
+}
+
+bool MappedFile::ReadIntoBuffer( const std::filesystem::path& fileName )
+{
+	std::ifstream fileStrm( fileName, std::ios::binary );
+	if ( !fileStrm )
+	{
+		Close();
+		return false;
+	}
+
+	m_fallbackBuffer.resize( m_size );
+	fileStrm.read( m_fallbackBuffer.data(), static_cast<std::streamsize>( m_size ) );
+	if ( static_cast<std::size_t>( fileStrm.gcount() ) != m_size )
+	{
+		Close();
+		return false;
+	}
+
+	m_data   = m_fallbackBuffer.data();
+	m_isOpen = true;
+	return true;
+}
+
+void MappedFile::Close() noexcept
+{
+	if ( m_mapping != nullptr )
+	{
+#ifdef _WIN32
+		::UnmapViewOfFile( m_mapping );
+		::CloseHandle( m_mappingHandle );
+		m_mappingHandle = nullptr;
+#else
+		::munmap( m_mapping, m_size );
+#endif
+		m_mapping = nullptr;
+	}
+
+	m_fallbackBuffer.clear();
+	m_fallbackBuffer.shrink_to_fit();
+
+	m_data   = nullptr;
+	m_size   = 0;
+	m_isOpen = false;
+}
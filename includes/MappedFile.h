@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Read-only view of a whole file.
+// The file is memory mapped when the platform allows it (mmap / MapViewOfFile),
+// otherwise it is read into an owned buffer, so Data() is valid either way.
+class MappedFile
+{
+public:
+	enum class AccessHint { Sequential, Random };
+
+	MappedFile() = default;
+	explicit MappedFile( const std::filesystem::path& fileName, AccessHint hint = AccessHint::Sequential );
+	~MappedFile();
+
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+	MappedFile( MappedFile&& other ) noexcept;
+	MappedFile& operator=( MappedFile&& other ) noexcept;
+
+	bool Open( const std::filesystem::path& fileName, AccessHint hint = AccessHint::Sequential );
+	void Close() noexcept;
+
+	inline const char* Data() const noexcept { return m_data; }
+	inline std::size_t Size() const noexcept { return m_size; }
+	inline bool IsMapped() const noexcept { return m_mapping != nullptr; }
+	inline bool IsOpen() const noexcept { return m_isOpen; }
+	explicit operator bool() const noexcept { return m_isOpen; }
+
+private:
+	bool ReadIntoBuffer( const std::filesystem::path& fileName );
+
+	const char*       m_data = nullptr;
+	std::size_t       m_size = 0;
+	bool              m_isOpen = false;
+
+	// platform mapping (nullptr if the fallback buffer is used)
+	void*             m_mapping = nullptr;
+#ifdef _WIN32
+	void*             m_mappingHandle = nullptr;
+#endif
+	std::vector<char> m_fallbackBuffer;
+};
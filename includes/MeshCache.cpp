@@ -0,0 +1,276 @@
+#include "MeshCache.h"
+#include "CacheFile.h"
+#include "ContentHash.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL2/SDL.h>
+
+struct MeshCache::Header
+{
+	char     magic[ 4 ];
+	uint32_t version;
+	uint32_t vertexSize;
+	uint32_t indexSize;
+
+	CacheSource source;
+
+	uint64_t vertexCount;
+	uint64_t indexCount;
+
+	uint32_t subMeshCount;
+	uint32_t materialLibraryCount;
+	uint32_t materialCount;
+	uint32_t stringTableSize;
+
+	uint32_t lodCount;
+	uint32_t reserved[ 3 ];
+
+	float    boundsMin[ 3 ];
+	float    boundsMax[ 3 ];
+};
+
+static constexpr char BMESH_MAGIC[ 4 ] = { 'B', 'M', 'S', 'H' };
+
+// The material libraries and names are stored after the submeshes as '\0' terminated strings
+static std::string buildStringTable( const ObjParser::Model& model )
+{
+	std::string stringTable;
+	for ( const std::string& library : model.materialLibraries ) stringTable.append( library ).push_back( '\0' );
+	for ( const ObjParser::Material& material : model.materials ) stringTable.append( material.name ).push_back( '\0' );
+	return stringTable;
+}
+
+static bool readStringTable( const char* data, const std::size_t size, const std::size_t stringCount, std::vector<std::string>& strings )
+{
+	const char* const endPtr = data + size;
+	for ( std::size_t i = 0; i < stringCount; ++i )
+	{
+		const char* stringEnd = std::find( data, endPtr, '\0' );
+		if ( stringEnd == endPtr ) return false;
+
+		strings.emplace_back( data, stringEnd );
+		data = stringEnd + 1;
+	}
+	return data == endPtr;
+}
+
+std::filesystem::path MeshCache::CachePathFor( const std::filesystem::path& objFileName )
+{
+	std::filesystem::path cacheFileName = objFileName;
+	cacheFileName += ".bmesh";
+	return cacheFileName;
+}
+
+CachedMesh MeshCache::Load( const std::filesystem::path& objFileName, ThreadPool* pool )
+{
+	CachedMesh result;
+
+	std::error_code ec;
+	const uint64_t sourceSize = std::filesystem::file_size( objFileName, ec );
+	if ( ec ) throw( ObjParser::EXC_FILENOTFOUND );
+	const int64_t sourceTime = static_cast<int64_t>( std::filesystem::last_write_time( objFileName, ec ).time_since_epoch().count() );
+	if ( ec ) throw( ObjParser::EXC_FILENOTFOUND );
+
+	const std::filesystem::path cacheFileName = CachePathFor( objFileName );
+
+	bool sourceHashValid = false;
+	uint64_t sourceHash = 0;
+	auto computeSourceHash = [ & ]() -> uint64_t
+	{
+		if ( !sourceHashValid )
+		{
+			MappedFile sourceFile( objFileName, MappedFile::AccessHint::Sequential );
+			if ( !sourceFile ) throw( ObjParser::EXC_FILENOTFOUND );
+			sourceHash = HashFileContent( sourceFile.Data(), sourceFile.Size() );
+			sourceHashValid = true;
+		}
+		return sourceHash;
+	};
+
+	//
+	// Try the cache first
+	//
+
+	if ( result.cacheFile.Open( cacheFileName, MappedFile::AccessHint::Sequential ) && result.cacheFile.Size() >= sizeof( Header ) )
+	{
+		Header header;
+		std::memcpy( &header, result.cacheFile.Data(), sizeof( Header ) );
+
+		const bool headerValid = std::memcmp( header.magic, BMESH_MAGIC, sizeof( BMESH_MAGIC ) ) == 0
+								 && header.version == VERSION
+								 && header.vertexSize == sizeof( Vertex )
+								 && header.indexSize == sizeof( GLuint )
+								 && header.lodCount > 0
+								 && result.cacheFile.Size() == sizeof( Header ) + header.vertexCount * sizeof( Vertex ) + header.indexCount * sizeof( GLuint )
+															   + std::size_t( header.lodCount ) * ( header.subMeshCount * sizeof( ObjParser::SubMesh ) + sizeof( float ) )
+															   + header.stringTableSize;
+
+		if ( headerValid && IsSourceUnchanged( header.source, sourceSize, sourceTime, computeSourceHash ) )
+		{
+			const char* payload = result.cacheFile.Data() + sizeof( Header );
+			const char* subMeshData = payload + header.vertexCount * sizeof( Vertex ) + header.indexCount * sizeof( GLuint );
+			const char* lodErrorData = subMeshData + std::size_t( header.lodCount ) * header.subMeshCount * sizeof( ObjParser::SubMesh );
+			const char* stringTable = lodErrorData + header.lodCount * sizeof( float );
+
+			std::vector<std::string> strings;
+			if ( readStringTable( stringTable, header.stringTableSize, std::size_t( header.materialLibraryCount ) + header.materialCount, strings ) )
+			{
+				result.view.vertices    = reinterpret_cast<const Vertex*>( payload );
+				result.view.vertexCount = static_cast<std::size_t>( header.vertexCount );
+				result.view.indices     = reinterpret_cast<const GLuint*>( payload + header.vertexCount * sizeof( Vertex ) );
+				result.view.indexCount  = static_cast<std::size_t>( header.indexCount );
+				result.boundsMin        = glm::vec3( header.boundsMin[ 0 ], header.boundsMin[ 1 ], header.boundsMin[ 2 ] );
+				result.boundsMax        = glm::vec3( header.boundsMax[ 0 ], header.boundsMax[ 1 ], header.boundsMax[ 2 ] );
+				result.loadedFromCache  = true;
+
+				result.lods.resize( header.lodCount );
+				for ( uint32_t l = 0; l < header.lodCount; ++l )
+				{
+					MeshSimplifier::Lod& lod = result.lods[ l ];
+					lod.subMeshes.resize( header.subMeshCount );
+					std::memcpy( lod.subMeshes.data(), subMeshData + std::size_t( l ) * header.subMeshCount * sizeof( ObjParser::SubMesh ), header.subMeshCount * sizeof( ObjParser::SubMesh ) );
+					std::memcpy( &lod.error, lodErrorData + l * sizeof( float ), sizeof( float ) );
+				}
+				result.subMeshes = result.lods.front().subMeshes;
+
+				// the materials are read from the libraries again, the cache does not depend on the .mtl files
+				const std::vector<std::string> materialLibraries( strings.cbegin(), strings.cbegin() + header.materialLibraryCount );
+				const std::vector<std::string> materialNames( strings.cbegin() + header.materialLibraryCount, strings.cend() );
+				result.materials = ObjParser::loadMaterials( objFileName, materialLibraries, materialNames );
+
+				// only the time has changed: store the new one, so the next load does not hash the source again
+				if ( header.source.time != sourceTime )
+				{
+					header.source.time = sourceTime;
+					if ( !RewriteHeader( cacheFileName, header ) )
+					{
+						SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
+										SDL_LOG_PRIORITY_WARN,
+										"[MeshCache] Could not update the header of %s", cacheFileName.string().c_str() );
+					}
+				}
+
+				return result;
+			}
+		}
+	}
+	result.cacheFile.Close();
+
+	//
+	// Stale or missing cache: parse the source and rebuild it
+	//
+
+	ObjParser::Model model = pool != nullptr ? ObjParser::parseModel( objFileName, *pool ) : ObjParser::parseModel( objFileName );
+
+	const ObjParser::ParseStats& parseStats = model.stats;
+	const double parseSeconds = std::max( parseStats.TotalMs(), 1e-3 ) / 1000.0;
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[MeshCache] %s parsed in %.1f ms on %u threads (tokenize %.1f, merge %.1f, triangulate %.1f, dedup %.1f, group %.1f): "
+					"%.1f MB/s, %.2f M vertices/s, %zu -> %zu vertices", objFileName.string().c_str(),
+					parseStats.TotalMs(), parseStats.threadCount,
+					parseStats.tokenizeMs, parseStats.mergeMs, parseStats.triangulateMs, parseStats.dedupMs, parseStats.groupMs,
+					parseStats.fileBytes / ( 1024.0 * 1024.0 ) / parseSeconds, model.mesh.vertexArray.size() / 1e6 / parseSeconds,
+					parseStats.faceCorners, model.mesh.vertexArray.size() );
+	if ( parseStats.invalidFaces > 0 )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_WARN,
+						"[MeshCache] %s: %zu faces dropped, they refer to missing (or relative) v/vt/vn indices", objFileName.string().c_str(), parseStats.invalidFaces );
+	}
+	const std::string stringTable = buildStringTable( model );
+
+	// the optimization is paid only when the cache is rebuilt
+	const MeshOptimizer::Report optimizeReport = MeshOptimizer::Optimize( model.mesh, model.subMeshes );
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[MeshCache] %s vertex cache ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", objFileName.string().c_str(),
+					optimizeReport.before.acmr, optimizeReport.after.acmr, optimizeReport.before.atvr, optimizeReport.after.atvr );
+
+	// the levels of detail are drawn from the same vertices, their indices follow the original ones
+	const MeshView<Vertex> modelView = { model.mesh.vertexArray.data(), model.mesh.vertexArray.size(), model.mesh.indexArray.data(), model.mesh.indexArray.size() };
+	MeshSimplifier::LodChain lodChain = MeshSimplifier::BuildLodChain( modelView, model.subMeshes );
+
+	std::size_t coarsestIndexCount = 0;
+	for ( const ObjParser::SubMesh& subMesh : lodChain.lods.back().subMeshes ) coarsestIndexCount += subMesh.indexCount;
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[MeshCache] %s %zu levels of detail, the coarsest has %zu triangles (error %g)", objFileName.string().c_str(),
+					lodChain.lods.size(), coarsestIndexCount / 3, lodChain.lods.back().error );
+
+	model.mesh.indexArray = std::move( lodChain.indices );
+
+	result.ownedMesh = std::move( model.mesh );
+	result.lods      = std::move( lodChain.lods );
+	result.subMeshes = result.lods.front().subMeshes;
+	result.materials = model.materials;
+
+	const ObjParser::Mesh& mesh = result.ownedMesh;
+
+	if ( !mesh.vertexArray.empty() )
+	{
+		result.boundsMin = result.boundsMax = mesh.vertexArray.front().position;
+		for ( const Vertex& v : mesh.vertexArray )
+		{
+			result.boundsMin = glm::min( result.boundsMin, v.position );
+			result.boundsMax = glm::max( result.boundsMax, v.position );
+		}
+	}
+
+	result.view.vertices    = mesh.vertexArray.data();
+	result.view.vertexCount = mesh.vertexArray.size();
+	result.view.indices     = mesh.indexArray.data();
+	result.view.indexCount  = mesh.indexArray.size();
+
+	Header header = {};
+	std::memcpy( header.magic, BMESH_MAGIC, sizeof( BMESH_MAGIC ) );
+	header.version     = VERSION;
+	header.vertexSize  = sizeof( Vertex );
+	header.indexSize   = sizeof( GLuint );
+	header.source      = { sourceSize, sourceTime, computeSourceHash() };
+	header.vertexCount = mesh.vertexArray.size();
+	header.indexCount  = mesh.indexArray.size();
+	header.subMeshCount         = static_cast<uint32_t>( result.subMeshes.size() );
+	header.materialLibraryCount = static_cast<uint32_t>( model.materialLibraries.size() );
+	header.materialCount        = static_cast<uint32_t>( model.materials.size() );
+	header.stringTableSize      = static_cast<uint32_t>( stringTable.size() );
+	header.lodCount             = static_cast<uint32_t>( result.lods.size() );
+	for ( int i = 0; i < 3; ++i )
+	{
+		header.boundsMin[ i ] = result.boundsMin[ i ];
+		header.boundsMax[ i ] = result.boundsMax[ i ];
+	}
+
+	if ( !Write( cacheFileName, header, mesh, result.lods, stringTable ) )
+	{
+		// not fatal, we just parse again next time
+		SDL_LogMessage( SDL_LOG_CATEGORY_ERROR,
+						SDL_LOG_PRIORITY_WARN,
+						"[MeshCache] Could not write mesh cache %s", cacheFileName.string().c_str() );
+	}
+
+	return result;
+}
+
+bool MeshCache::Write( const std::filesystem::path& cacheFileName, const Header& header, const ObjParser::Mesh& mesh,
+					   const std::vector<MeshSimplifier::Lod>& lods, const std::string& stringTable )
+{
+	// the vertex data follows the header, keep it aligned in the mapped file
+	static_assert( sizeof( Header ) % 16 == 0, "MeshCache::Header must keep the payload 16 byte aligned" );
+
+	return WriteFileAtomically( cacheFileName, [ & ]( std::ostream& cacheStrm )
+	{
+		cacheStrm.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+		cacheStrm.write( reinterpret_cast<const char*>( mesh.vertexArray.data() ), mesh.vertexArray.size() * sizeof( Vertex ) );
+		cacheStrm.write( reinterpret_cast<const char*>( mesh.indexArray.data() ), mesh.indexArray.size() * sizeof( GLuint ) );
+		for ( const MeshSimplifier::Lod& lod : lods )
+			cacheStrm.write( reinterpret_cast<const char*>( lod.subMeshes.data() ), lod.subMeshes.size() * sizeof( ObjParser::SubMesh ) );
+		for ( const MeshSimplifier::Lod& lod : lods )
+			cacheStrm.write( reinterpret_cast<const char*>( &lod.error ), sizeof( float ) );
+		cacheStrm.write( stringTable.data(), stringTable.size() );
+	} );
+}
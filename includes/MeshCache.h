@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GLUtils.hpp"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+
+// A mesh loaded through the binary cache.
+// The data is either a view into the mapped .bmesh file, or owned (when the cache had to be rebuilt).
+struct CachedMesh
+{
+	MeshView<Vertex> view;
+	glm::vec3 boundsMin = glm::vec3( 0.0f );
+	glm::vec3 boundsMax = glm::vec3( 0.0f );
+
+	// faces grouped by material, see ObjParser::Model
+	std::vector<ObjParser::SubMesh>  subMeshes;
+	std::vector<ObjParser::Material> materials;
+
+	// Levels of detail (MeshSimplifier), lods[ 0 ].subMeshes are the subMeshes above.
+	// The indices of all the levels are in view, one after the other.
+	std::vector<MeshSimplifier::Lod> lods;
+
+	bool loadedFromCache = false;
+
+	MappedFile     cacheFile;
+	ObjParser::Mesh ownedMesh;
+};
+
+// Binary cache of parsed OBJ files (<asset>.bmesh next to the asset).
+//
+// The cache holds the deduplicated vertex and index arrays (optimized by MeshOptimizer), the submeshes, the levels of detail
+// and the bounds of the mesh.
+// It is keyed by the size, modification time and content hash of the source file:
+// size and time are checked first, the content is only hashed when the time differs (and if it still matches, the new time is stored).
+// Only the material names and libraries are cached, the .mtl files are always read again.
+class MeshCache
+{
+public:
+	// Loads the mesh from the cache, or parses the OBJ file and rebuilds the cache when it is stale.
+	// Throws ObjParser::EXC_FILENOTFOUND like ObjParser::parse.
+	// pool: a large file is parsed in chunks on its workers (ObjParser::parseModel), nullptr parses it on the calling thread.
+	static CachedMesh Load( const std::filesystem::path& objFileName, ThreadPool* pool = nullptr );
+
+	static std::filesystem::path CachePathFor( const std::filesystem::path& objFileName );
+
+	static constexpr uint32_t VERSION = 5;
+
+private:
+	struct Header;
+
+	static bool Write( const std::filesystem::path& cacheFileName, const Header& header, const ObjParser::Mesh& mesh,
+					   const std::vector<MeshSimplifier::Lod>& lods, const std::string& stringTable );
+};
@@ -0,0 +1,207 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Scoring of the Forsyth algorithm, the constants are the ones from the paper
+static constexpr int   FORSYTH_CACHE_SIZE  = 32;
+static constexpr float CACHE_DECAY_POWER   = 1.5f;
+static constexpr float LAST_TRI_SCORE      = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+static float forsythVertexScore( const int cachePosition, const unsigned int remainingTriangles )
+{
+	// no triangle left to draw with this vertex
+	if ( remainingTriangles == 0 ) return -1.0f;
+
+	float score = 0.0f;
+	if ( cachePosition >= 0 )
+	{
+		// the vertices of the last triangle get the same score, so the order inside it does not matter
+		if ( cachePosition < 3 )
+			score = LAST_TRI_SCORE;
+		else
+			score = std::pow( 1.0f - static_cast<float>( cachePosition - 3 ) / ( FORSYTH_CACHE_SIZE - 3 ), CACHE_DECAY_POWER );
+	}
+
+	// vertices with few triangles left are preferred, so they do not end up as lonely triangles later
+	score += VALENCE_BOOST_SCALE * std::pow( static_cast<float>( remainingTriangles ), -VALENCE_BOOST_POWER );
+
+	return score;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache( const GLuint* indices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize )
+{
+	VertexCacheStats stats;
+	if ( indexCount < 3 ) return stats;
+
+	// a vertex is in the FIFO cache if it was (re)loaded less than cacheSize misses ago
+	std::vector<std::size_t> loadTimes( vertexCount, 0 );
+	std::size_t time = cacheSize + 1;
+	std::size_t misses = 0;
+	std::size_t uniqueVertices = 0;
+
+	for ( std::size_t i = 0; i < indexCount; ++i )
+	{
+		std::size_t& loadTime = loadTimes[ indices[ i ] ];
+		if ( time - loadTime > cacheSize )
+		{
+			if ( loadTime == 0 ) ++uniqueVertices;
+
+			loadTime = time++;
+			++misses;
+		}
+	}
+
+	stats.acmr = static_cast<float>( misses ) / static_cast<float>( indexCount / 3 );
+	stats.atvr = static_cast<float>( misses ) / static_cast<float>( uniqueVertices );
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache( GLuint* indices, std::size_t indexCount, std::size_t vertexCount )
+{
+	const std::size_t triCount = indexCount / 3;
+	if ( triCount < 2 ) return;
+
+	constexpr std::size_t NO_TRIANGLE = std::numeric_limits<std::size_t>::max();
+
+	//
+	// Triangles of the vertices, the not yet added ones are at the front of each list
+	//
+
+	std::vector<unsigned int> vertexTriOffsets( vertexCount + 1, 0 );
+	for ( std::size_t i = 0; i < triCount * 3; ++i ) ++vertexTriOffsets[ indices[ i ] + 1 ];
+	for ( std::size_t v = 0; v < vertexCount; ++v ) vertexTriOffsets[ v + 1 ] += vertexTriOffsets[ v ];
+
+	std::vector<unsigned int> remainingTriCounts( vertexCount, 0 );
+	std::vector<unsigned int> vertexTris( triCount * 3 );
+	for ( std::size_t i = 0; i < triCount * 3; ++i )
+	{
+		const GLuint v = indices[ i ];
+		vertexTris[ vertexTriOffsets[ v ] + remainingTriCounts[ v ]++ ] = static_cast<unsigned int>( i / 3 );
+	}
+
+	//
+	// Initial scores
+	//
+
+	std::vector<int>   cachePositions( vertexCount, -1 );
+	std::vector<float> vertexScores( vertexCount );
+	for ( std::size_t v = 0; v < vertexCount; ++v ) vertexScores[ v ] = forsythVertexScore( -1, remainingTriCounts[ v ] );
+
+	std::vector<float> triScores( triCount );
+	std::vector<bool>  triAdded( triCount, false );
+
+	std::size_t bestTri = 0;
+	for ( std::size_t t = 0; t < triCount; ++t )
+	{
+		triScores[ t ] = vertexScores[ indices[ 3 * t ] ] + vertexScores[ indices[ 3 * t + 1 ] ] + vertexScores[ indices[ 3 * t + 2 ] ];
+		if ( triScores[ t ] > triScores[ bestTri ] ) bestTri = t;
+	}
+
+	//
+	// Add the best triangle, update the simulated LRU cache and the scores around it
+	//
+
+	std::vector<GLuint> outputIndices;
+	outputIndices.reserve( triCount * 3 );
+
+	GLuint cache[ FORSYTH_CACHE_SIZE + 3 ];
+	int cacheCount = 0;
+	std::size_t nextUnaddedTri = 0;
+
+	for ( std::size_t addedCount = 0; addedCount < triCount; ++addedCount )
+	{
+		if ( bestTri == NO_TRIANGLE )
+		{
+			// dead end, none of the cached vertices has a triangle left: continue in input order
+			while ( triAdded[ nextUnaddedTri ] ) ++nextUnaddedTri;
+			bestTri = nextUnaddedTri;
+		}
+
+		const GLuint triVerts[ 3 ] = { indices[ 3 * bestTri ], indices[ 3 * bestTri + 1 ], indices[ 3 * bestTri + 2 ] };
+		outputIndices.insert( outputIndices.end(), triVerts, triVerts + 3 );
+		triAdded[ bestTri ] = true;
+
+		for ( const GLuint v : triVerts )
+		{
+			unsigned int* tris = vertexTris.data() + vertexTriOffsets[ v ];
+			unsigned int& remaining = remainingTriCounts[ v ];
+
+			std::swap( *std::find( tris, tris + remaining, static_cast<unsigned int>( bestTri ) ), tris[ remaining - 1 ] );
+			--remaining;
+		}
+
+		// the vertices of the new triangle go to the front, the others are shifted back
+		GLuint newCache[ FORSYTH_CACHE_SIZE + 3 ];
+		int newCacheCount = 0;
+		for ( const GLuint v : triVerts )
+		{
+			if ( std::find( newCache, newCache + newCacheCount, v ) == newCache + newCacheCount ) newCache[ newCacheCount++ ] = v;
+		}
+		for ( int i = 0; i < cacheCount; ++i )
+		{
+			if ( std::find( triVerts, triVerts + 3, cache[ i ] ) == triVerts + 3 ) newCache[ newCacheCount++ ] = cache[ i ];
+		}
+
+		for ( int i = 0; i < newCacheCount; ++i )
+		{
+			const GLuint v = newCache[ i ];
+			cachePositions[ v ] = i < FORSYTH_CACHE_SIZE ? i : -1; // the ones after the end are evicted
+
+			const float newScore = forsythVertexScore( cachePositions[ v ], remainingTriCounts[ v ] );
+			const float scoreDiff = newScore - vertexScores[ v ];
+			vertexScores[ v ] = newScore;
+
+			const unsigned int* tris = vertexTris.data() + vertexTriOffsets[ v ];
+			for ( unsigned int k = 0; k < remainingTriCounts[ v ]; ++k ) triScores[ tris[ k ] ] += scoreDiff;
+		}
+
+		cacheCount = std::min( newCacheCount, FORSYTH_CACHE_SIZE );
+		std::copy_n( newCache, cacheCount, cache );
+
+		// the next triangle is searched only among the ones using a cached vertex
+		bestTri = NO_TRIANGLE;
+		float bestScore = -1.0f;
+		for ( int i = 0; i < cacheCount; ++i )
+		{
+			const GLuint v = cache[ i ];
+			const unsigned int* tris = vertexTris.data() + vertexTriOffsets[ v ];
+			for ( unsigned int k = 0; k < remainingTriCounts[ v ]; ++k )
+			{
+				if ( triScores[ tris[ k ] ] > bestScore )
+				{
+					bestScore = triScores[ tris[ k ] ];
+					bestTri = tris[ k ];
+				}
+			}
+		}
+	}
+
+	std::copy( outputIndices.cbegin(), outputIndices.cend(), indices );
+}
+
+std::vector<GLuint> MeshOptimizer::OptimizeVertexFetch( GLuint* indices, std::size_t indexCount, std::size_t vertexCount )
+{
+	constexpr GLuint NOT_USED = std::numeric_limits<GLuint>::max();
+
+	std::vector<GLuint> remap( vertexCount, NOT_USED );
+	GLuint nextVertex = 0;
+
+	for ( std::size_t i = 0; i < indexCount; ++i )
+	{
+		GLuint& newIndex = remap[ indices[ i ] ];
+		if ( newIndex == NOT_USED ) newIndex = nextVertex++;
+
+		indices[ i ] = newIndex;
+	}
+
+	for ( GLuint& newIndex : remap )
+	{
+		if ( newIndex == NOT_USED ) newIndex = nextVertex++;
+	}
+
+	return remap;
+}
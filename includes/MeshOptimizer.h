@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "GLUtils.hpp"
+#include "ObjParser.h"
+
+// Reordering of indexed triangle lists for the GPU vertex caches.
+//
+// OptimizeVertexCache reorders the triangles for the post-transform cache
+// (Tom Forsyth: Linear-Speed Vertex Cache Optimisation, https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html),
+// OptimizeVertexFetch then renumbers the vertices in the order of their first use for the pre-transform (fetch) cache.
+// The result does not depend on the GPU, the gain can be checked with AnalyzeVertexCache.
+class MeshOptimizer
+{
+public:
+	// ACMR: average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large regular grids, 3 is the worst)
+	// ATVR: average transformed vertex ratio, transformed vertices per vertex (1 is ideal)
+	struct VertexCacheStats
+	{
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+
+	struct Report
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	// Size of the simulated FIFO cache in AnalyzeVertexCache
+	static constexpr unsigned int FIFO_CACHE_SIZE = 16;
+
+	static VertexCacheStats AnalyzeVertexCache( const GLuint* indices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize = FIFO_CACHE_SIZE );
+
+	// Reorders the triangles of indices[0, indexCount) in place
+	static void OptimizeVertexCache( GLuint* indices, std::size_t indexCount, std::size_t vertexCount );
+
+	// Renumbers the vertices in the order of their first use, returns the new index of each old vertex.
+	// Vertices not referenced by any triangle are moved to the end.
+	static std::vector<GLuint> OptimizeVertexFetch( GLuint* indices, std::size_t indexCount, std::size_t vertexCount );
+
+	// Both passes on a whole mesh. The triangles are only reordered inside their submesh,
+	// so the index ranges of ObjParser::Model stay valid (no submeshes = one range).
+	template <typename VertexT>
+	static Report Optimize( MeshObject<VertexT>& mesh, const std::vector<ObjParser::SubMesh>& subMeshes = {} );
+};
+
+template <typename VertexT>
+MeshOptimizer::Report MeshOptimizer::Optimize( MeshObject<VertexT>& mesh, const std::vector<ObjParser::SubMesh>& subMeshes )
+{
+	Report report;
+	report.before = AnalyzeVertexCache( mesh.indexArray.data(), mesh.indexArray.size(), mesh.vertexArray.size() );
+
+	if ( subMeshes.empty() )
+	{
+		OptimizeVertexCache( mesh.indexArray.data(), mesh.indexArray.size(), mesh.vertexArray.size() );
+	}
+	else
+	{
+		for ( const ObjParser::SubMesh& subMesh : subMeshes )
+			OptimizeVertexCache( mesh.indexArray.data() + subMesh.indexOffset, subMesh.indexCount, mesh.vertexArray.size() );
+	}
+
+	const std::vector<GLuint> remap = OptimizeVertexFetch( mesh.indexArray.data(), mesh.indexArray.size(), mesh.vertexArray.size() );
+
+	std::vector<VertexT> remappedVertices( mesh.vertexArray.size() );
+	for ( std::size_t i = 0; i < mesh.vertexArray.size(); ++i )
+		remappedVertices[ remap[ i ] ] = mesh.vertexArray[ i ];
+	mesh.vertexArray = std::move( remappedVertices );
+
+	report.after = AnalyzeVertexCache( mesh.indexArray.data(), mesh.indexArray.size(), mesh.vertexArray.size() );
+	return report;
+}
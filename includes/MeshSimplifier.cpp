@@ -0,0 +1,566 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Border and seam edges get a plane perpendicular to the surface, weighted much more than the surface itself,
+// so collapsing along them is cheap only while they stay straight
+static constexpr double BORDER_WEIGHT = 10.0;
+
+// A level is only kept if it has at most this fraction of the triangles of the previous one
+static constexpr float LOD_MIN_REDUCTION = 0.9f;
+
+// A collapse may turn the triangles around the moved vertex by less than about 75 degrees.
+// Only rejecting the ones that turn over (90 degrees or more) lets slivers standing on edge through.
+static constexpr float MAX_TURN_COS = 0.25f;
+
+static constexpr uint8_t CLASS_LOCKED = 1;
+static constexpr uint8_t CLASS_BORDER = 2;
+
+// Sum of squared distances from planes: p^T A p + 2 b^T p + c, weighted by the area of the planes
+struct Quadric
+{
+	double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+
+	Quadric& operator+=( const Quadric& other )
+	{
+		a00 += other.a00; a11 += other.a11; a22 += other.a22;
+		a01 += other.a01; a02 += other.a02; a12 += other.a12;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+};
+
+// Quadric of the plane n.p + d = 0, n is unit length
+static Quadric planeQuadric( const glm::vec3& n, const float d, const double weight )
+{
+	Quadric q;
+	q.a00 = weight * n.x * n.x; q.a11 = weight * n.y * n.y; q.a22 = weight * n.z * n.z;
+	q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a12 = weight * n.y * n.z;
+	q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+	q.c = weight * d * d;
+	q.weight = weight;
+	return q;
+}
+
+// Weighted sum of the squared distances of p from the planes of the quadric
+static double quadricErrorSum( const Quadric& q, const glm::vec3& p )
+{
+	const double x = p.x, y = p.y, z = p.z;
+	const double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+					   + 2.0 * ( q.a01 * x * y + q.a02 * x * z + q.a12 * y * z )
+					   + 2.0 * ( q.b0 * x + q.b1 * y + q.b2 * z )
+					   + q.c;
+	return std::fabs( error );
+}
+
+// Mean squared distance of p from the planes of the quadric
+static double quadricError( const Quadric& q, const glm::vec3& p )
+{
+	return q.weight > 0.0 ? quadricErrorSum( q, p ) / q.weight : 0.0;
+}
+
+static uint64_t edgeKey( const GLuint a, const GLuint b )
+{
+	return ( static_cast<uint64_t>( a ) << 32 ) | b;
+}
+
+// The vertices at the same position get the same class, numbered in the order of the positions
+static std::vector<GLuint> positionClasses( const MeshView<Vertex>& mesh, GLuint& classCount )
+{
+	std::vector<GLuint> order( mesh.vertexCount );
+	std::iota( order.begin(), order.end(), 0 );
+
+	auto less = [ & ]( const GLuint a, const GLuint b )
+	{
+		const glm::vec3& pa = mesh.vertices[ a ].position;
+		const glm::vec3& pb = mesh.vertices[ b ].position;
+		if ( pa.x != pb.x ) return pa.x < pb.x;
+		if ( pa.y != pb.y ) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort( order.begin(), order.end(), less );
+
+	std::vector<GLuint> classes( mesh.vertexCount );
+	classCount = 0;
+	for ( std::size_t i = 0; i < order.size(); ++i )
+	{
+		if ( i > 0 && less( order[ i - 1 ], order[ i ] ) ) ++classCount;
+		classes[ order[ i ] ] = classCount;
+	}
+	if ( !order.empty() ) ++classCount;
+
+	return classes;
+}
+
+std::vector<GLuint> MeshSimplifier::Simplify( const MeshView<Vertex>& mesh,
+											  std::size_t targetIndexCount,
+											  float targetError,
+											  const std::vector<bool>& lockedVertices,
+											  float* resultError )
+{
+	if ( resultError ) *resultError = 0.0f;
+
+	GLuint classCount = 0;
+	const std::vector<GLuint> posClass = positionClasses( mesh, classCount );
+
+	// the triangles with two corners at the same position are dropped right away
+	std::vector<GLuint> indices;
+	indices.reserve( mesh.indexCount );
+	for ( std::size_t i = 0; i + 2 < mesh.indexCount; i += 3 )
+	{
+		const GLuint a = mesh.indices[ i ], b = mesh.indices[ i + 1 ], c = mesh.indices[ i + 2 ];
+		if ( posClass[ a ] != posClass[ b ] && posClass[ a ] != posClass[ c ] && posClass[ b ] != posClass[ c ] )
+			indices.insert( indices.end(), { a, b, c } );
+	}
+
+	if ( indices.size() <= targetIndexCount ) return indices;
+
+	//
+	// Vertices (wedges) of each position class
+	//
+
+	std::vector<GLuint> classWedgeOffsets( classCount + 1, 0 );
+	for ( std::size_t v = 0; v < mesh.vertexCount; ++v ) ++classWedgeOffsets[ posClass[ v ] + 1 ];
+	for ( GLuint c = 0; c < classCount; ++c ) classWedgeOffsets[ c + 1 ] += classWedgeOffsets[ c ];
+
+	std::vector<GLuint> classWedges( mesh.vertexCount );
+	{
+		std::vector<GLuint> fill( classWedgeOffsets.cbegin(), classWedgeOffsets.cend() - 1 );
+		for ( std::size_t v = 0; v < mesh.vertexCount; ++v ) classWedges[ fill[ posClass[ v ] ]++ ] = static_cast<GLuint>( v );
+	}
+
+	auto classPosition = [ & ]( const GLuint c ) -> const glm::vec3&
+	{
+		return mesh.vertices[ classWedges[ classWedgeOffsets[ c ] ] ].position;
+	};
+
+	std::vector<uint8_t> classFlags( classCount, 0 );
+	for ( std::size_t v = 0; v < lockedVertices.size() && v < mesh.vertexCount; ++v )
+	{
+		if ( lockedVertices[ v ] ) classFlags[ posClass[ v ] ] |= CLASS_LOCKED;
+	}
+
+	// unit normal of a triangle, zero if it has no area
+	auto triangleNormal = [ & ]( const std::size_t tri, float* area = nullptr ) -> glm::vec3
+	{
+		const glm::vec3& p0 = classPosition( posClass[ indices[ 3 * tri ] ] );
+		const glm::vec3 normal = glm::cross( classPosition( posClass[ indices[ 3 * tri + 1 ] ] ) - p0, classPosition( posClass[ indices[ 3 * tri + 2 ] ] ) - p0 );
+		const float length = glm::length( normal );
+		if ( area ) *area = 0.5f * length;
+		return length > 0.0f ? normal / length : glm::vec3( 0.0f );
+	};
+
+	//
+	// Quadrics of the triangles
+	//
+
+	// The area weighted quadrics order the collapses.
+	// The error bound uses the same planes with unit weight: the sum of the squared distances is at least the square of the largest one,
+	// so it bounds the distance of the moved vertices from every original plane around them (the mean would underestimate it).
+	std::vector<Quadric> quadrics( classCount );
+	std::vector<Quadric> boundQuadrics( classCount );
+
+	for ( std::size_t tri = 0; tri < indices.size() / 3; ++tri )
+	{
+		float area = 0.0f;
+		const glm::vec3 normal = triangleNormal( tri, &area );
+		if ( area <= 0.0f ) continue;
+
+		const float d = -glm::dot( normal, classPosition( posClass[ indices[ 3 * tri ] ] ) );
+		const Quadric q = planeQuadric( normal, d, area );
+		const Quadric boundQ = planeQuadric( normal, d, 1.0 );
+		for ( int corner = 0; corner < 3; ++corner )
+		{
+			quadrics[ posClass[ indices[ 3 * tri + corner ] ] ] += q;
+			boundQuadrics[ posClass[ indices[ 3 * tri + corner ] ] ] += boundQ;
+		}
+	}
+
+	//
+	// Topology of the input: borders, seams and non-manifold edges
+	//
+
+	// The half edges sorted by their undirected edge between classes, so the sides of an edge are next to each other.
+	// corner is the index of the starting vertex in indices, the half edge goes to the next corner of the triangle.
+	struct HalfEdge
+	{
+		uint64_t edge;
+		GLuint   corner;
+	};
+
+	auto nextCorner = []( const GLuint corner ) -> GLuint { return corner - corner % 3 + ( corner + 1 ) % 3; };
+
+	std::vector<HalfEdge> halfEdges( indices.size() );
+	for ( GLuint corner = 0; corner < indices.size(); ++corner )
+	{
+		const GLuint ca = posClass[ indices[ corner ] ], cb = posClass[ indices[ nextCorner( corner ) ] ];
+		halfEdges[ corner ] = { edgeKey( std::min( ca, cb ), std::max( ca, cb ) ), corner };
+	}
+	std::sort( halfEdges.begin(), halfEdges.end(), []( const HalfEdge& a, const HalfEdge& b ) { return a.edge < b.edge; } );
+
+	// a plane through the edge, perpendicular to the triangle of the half edge
+	auto addEdgeQuadric = [ & ]( const GLuint corner )
+	{
+		const GLuint ca = posClass[ indices[ corner ] ], cb = posClass[ indices[ nextCorner( corner ) ] ];
+		const glm::vec3 edge = classPosition( cb ) - classPosition( ca );
+		const glm::vec3 edgeNormal = glm::cross( edge, triangleNormal( corner / 3 ) );
+		const float length = glm::length( edgeNormal );
+		if ( length <= 0.0f ) return;
+
+		const glm::vec3 n = edgeNormal / length;
+		const Quadric q = planeQuadric( n, -glm::dot( n, classPosition( ca ) ), BORDER_WEIGHT * glm::dot( edge, edge ) );
+		quadrics[ ca ] += q;
+		quadrics[ cb ] += q;
+
+		const Quadric boundQ = planeQuadric( n, -glm::dot( n, classPosition( ca ) ), 1.0 );
+		boundQuadrics[ ca ] += boundQ;
+		boundQuadrics[ cb ] += boundQ;
+	};
+
+	for ( std::size_t first = 0, last = 0; first < halfEdges.size(); first = last )
+	{
+		while ( last < halfEdges.size() && halfEdges[ last ].edge == halfEdges[ first ].edge ) ++last;
+
+		const GLuint corner0 = halfEdges[ first ].corner;
+		const GLuint ca = posClass[ indices[ corner0 ] ], cb = posClass[ indices[ nextCorner( corner0 ) ] ];
+
+		if ( last - first == 1 )
+		{
+			classFlags[ ca ] |= CLASS_BORDER;
+			classFlags[ cb ] |= CLASS_BORDER;
+			addEdgeQuadric( corner0 );
+			continue;
+		}
+
+		const GLuint corner1 = halfEdges[ first + 1 ].corner;
+		if ( last - first > 2 || posClass[ indices[ corner1 ] ] != cb )
+		{
+			// more than two triangles on the edge, or the two are oriented differently
+			classFlags[ ca ] |= CLASS_LOCKED;
+			classFlags[ cb ] |= CLASS_LOCKED;
+			continue;
+		}
+
+		// seam: the two sides use different vertices
+		if ( indices[ corner0 ] != indices[ nextCorner( corner1 ) ] || indices[ nextCorner( corner0 ) ] != indices[ corner1 ] )
+		{
+			addEdgeQuadric( corner0 );
+			addEdgeQuadric( corner1 );
+		}
+	}
+
+	//
+	// Collapse passes: the cheapest collapses not touching each other, until the target is reached
+	//
+
+	struct Collapse
+	{
+		GLuint from;
+		GLuint to;
+		double cost;
+		double reverseCost; // of to -> from, negative if the flags do not allow it
+	};
+
+	const double maxBound = static_cast<double>( targetError ) * targetError;
+	double resultBound = 0.0;
+
+	std::vector<GLuint> vertexTriOffsets( mesh.vertexCount + 1 );
+	std::vector<GLuint> vertexTris;
+	std::vector<GLuint> wedgeRemap( mesh.vertexCount );
+	std::vector<bool>   classTouched( classCount );
+
+	auto forEachTriangleOfClass = [ & ]( const GLuint c, auto&& func )
+	{
+		for ( GLuint w = classWedgeOffsets[ c ]; w < classWedgeOffsets[ c + 1 ]; ++w )
+		{
+			const GLuint wedge = classWedges[ w ];
+			for ( GLuint k = vertexTriOffsets[ wedge ]; k < vertexTriOffsets[ wedge + 1 ]; ++k ) func( wedge, vertexTris[ k ] );
+		}
+	};
+
+	// Every wedge of 'from' has to go to the one wedge of 'to' it shares a triangle with, so the attributes on both sides of a seam stay.
+	// The remap is only written when writeRemap is set.
+	auto mapWedges = [ & ]( const GLuint from, const GLuint to, const bool writeRemap ) -> bool
+	{
+		for ( GLuint w = classWedgeOffsets[ from ]; w < classWedgeOffsets[ from + 1 ]; ++w )
+		{
+			const GLuint wedge = classWedges[ w ];
+			if ( vertexTriOffsets[ wedge ] == vertexTriOffsets[ wedge + 1 ] ) continue; // not used any more
+
+			GLuint target = wedge;
+			for ( GLuint k = vertexTriOffsets[ wedge ]; k < vertexTriOffsets[ wedge + 1 ]; ++k )
+			{
+				const GLuint* tri = indices.data() + 3 * vertexTris[ k ];
+				for ( int corner = 0; corner < 3; ++corner )
+				{
+					if ( posClass[ tri[ corner ] ] != to ) continue;
+					if ( target != wedge && target != tri[ corner ] ) return false;
+					target = tri[ corner ];
+				}
+			}
+			if ( target == wedge ) return false;
+
+			if ( writeRemap ) wedgeRemap[ wedge ] = target;
+		}
+		return true;
+	};
+
+	// the part of canCollapse that depends only on the classes
+	auto flagsAllowCollapse = [ & ]( const GLuint from, const GLuint to ) -> bool
+	{
+		if ( classFlags[ from ] & CLASS_LOCKED ) return false;
+		return !( classFlags[ from ] & CLASS_BORDER ) || ( classFlags[ to ] & CLASS_BORDER );
+	};
+
+	auto canCollapse = [ & ]( const GLuint from, const GLuint to ) -> bool
+	{
+		if ( !flagsAllowCollapse( from, to ) ) return false;
+
+		if ( classFlags[ from ] & CLASS_BORDER )
+		{
+			// only along a border edge, that has a single triangle
+			unsigned int edgeTriangles = 0;
+			forEachTriangleOfClass( from, [ & ]( GLuint, const GLuint tri )
+			{
+				for ( int corner = 0; corner < 3; ++corner ) edgeTriangles += posClass[ indices[ 3 * tri + corner ] ] == to;
+			} );
+			if ( edgeTriangles != 1 ) return false;
+		}
+
+		return mapWedges( from, to, false );
+	};
+
+	// none of the remaining triangles around 'from' may turn over (or nearly) when it moves to 'to'
+	auto keepsOrientation = [ & ]( const GLuint from, const GLuint to ) -> bool
+	{
+		bool flips = false;
+		forEachTriangleOfClass( from, [ & ]( GLuint, const GLuint tri )
+		{
+			glm::vec3 before[ 3 ], after[ 3 ];
+			for ( int corner = 0; corner < 3; ++corner )
+			{
+				const GLuint c = posClass[ indices[ 3 * tri + corner ] ];
+				if ( c == to ) return; // collapses
+				before[ corner ] = classPosition( c );
+				after[ corner ] = c == from ? classPosition( to ) : before[ corner ];
+			}
+
+			const glm::vec3 normalBefore = glm::cross( before[ 1 ] - before[ 0 ], before[ 2 ] - before[ 0 ] );
+			const glm::vec3 normalAfter = glm::cross( after[ 1 ] - after[ 0 ], after[ 2 ] - after[ 0 ] );
+			if ( glm::dot( normalBefore, normalAfter ) <= MAX_TURN_COS * glm::length( normalBefore ) * glm::length( normalAfter ) ) flips = true;
+		} );
+		return !flips;
+	};
+
+	std::vector<uint64_t> edges;
+	std::vector<Collapse> collapses;
+
+	while ( indices.size() > targetIndexCount )
+	{
+		const std::size_t triCount = indices.size() / 3;
+
+		// triangles of each vertex
+		std::fill( vertexTriOffsets.begin(), vertexTriOffsets.end(), 0 );
+		for ( const GLuint v : indices ) ++vertexTriOffsets[ v + 1 ];
+		for ( std::size_t v = 0; v < mesh.vertexCount; ++v ) vertexTriOffsets[ v + 1 ] += vertexTriOffsets[ v ];
+
+		vertexTris.resize( indices.size() );
+		{
+			std::vector<GLuint> fill( vertexTriOffsets.cbegin(), vertexTriOffsets.cend() - 1 );
+			for ( std::size_t i = 0; i < indices.size(); ++i ) vertexTris[ fill[ indices[ i ] ]++ ] = static_cast<GLuint>( i / 3 );
+		}
+
+		// Every edge once: an interior edge has a half edge in both directions, the one going to the larger class is taken.
+		// The edges between border classes are taken from both sides, a duplicate is skipped by the touched check later.
+		edges.clear();
+		for ( std::size_t i = 0; i < indices.size(); i += 3 )
+		{
+			for ( int k = 0; k < 3; ++k )
+			{
+				const GLuint ca = posClass[ indices[ i + k ] ], cb = posClass[ indices[ i + ( k + 1 ) % 3 ] ];
+				if ( ca < cb ) edges.push_back( edgeKey( ca, cb ) );
+				else if ( ( classFlags[ ca ] & CLASS_BORDER ) && ( classFlags[ cb ] & CLASS_BORDER ) ) edges.push_back( edgeKey( cb, ca ) );
+			}
+		}
+
+		// The cheaper direction of every edge the flags allow. The topology is only checked for the collapses actually tried,
+		// the other direction is the fallback.
+		collapses.clear();
+		collapses.reserve( edges.size() );
+		for ( const uint64_t edge : edges )
+		{
+			const GLuint ca = static_cast<GLuint>( edge >> 32 ), cb = static_cast<GLuint>( edge );
+
+			const bool aToB = flagsAllowCollapse( ca, cb );
+			const bool bToA = flagsAllowCollapse( cb, ca );
+			if ( !aToB && !bToA ) continue;
+
+			Quadric q = quadrics[ ca ];
+			q += quadrics[ cb ];
+
+			const double costAToB = aToB ? quadricError( q, classPosition( cb ) ) : -1.0;
+			const double costBToA = bToA ? quadricError( q, classPosition( ca ) ) : -1.0;
+
+			if ( aToB && ( !bToA || costAToB <= costBToA ) )
+				collapses.push_back( { ca, cb, costAToB, costBToA } );
+			else
+				collapses.push_back( { cb, ca, costBToA, costAToB } );
+		}
+
+		std::sort( collapses.begin(), collapses.end(), []( const Collapse& a, const Collapse& b ) { return a.cost < b.cost; } );
+
+		std::iota( wedgeRemap.begin(), wedgeRemap.end(), 0 );
+		std::fill( classTouched.begin(), classTouched.end(), false );
+
+		// an interior collapse removes two triangles, a border collapse one
+		const std::size_t trianglesToRemove = triCount - targetIndexCount / 3;
+		std::size_t removedTriangles = 0;
+		bool collapsed = false;
+
+		for ( const Collapse& collapse : collapses )
+		{
+			if ( removedTriangles >= trianglesToRemove ) break;
+			if ( classTouched[ collapse.from ] || classTouched[ collapse.to ] ) continue;
+
+			GLuint from = collapse.from, to = collapse.to;
+			if ( !canCollapse( from, to ) )
+			{
+				if ( collapse.reverseCost < 0.0 || !canCollapse( to, from ) ) continue;
+
+				std::swap( from, to );
+			}
+			if ( !keepsOrientation( from, to ) ) continue;
+
+			// the vertices merged into either class end up at 'to'
+			Quadric boundQ = boundQuadrics[ from ];
+			boundQ += boundQuadrics[ to ];
+			const double bound = quadricErrorSum( boundQ, classPosition( to ) );
+			if ( bound > maxBound ) continue;
+
+			mapWedges( from, to, true );
+
+			// the triangles around 'from' change, their corners wait for the next pass
+			forEachTriangleOfClass( from, [ & ]( GLuint, const GLuint tri )
+			{
+				for ( int corner = 0; corner < 3; ++corner ) classTouched[ posClass[ indices[ 3 * tri + corner ] ] ] = true;
+			} );
+			classTouched[ to ] = true;
+
+			quadrics[ to ] += quadrics[ from ];
+			boundQuadrics[ to ] += boundQuadrics[ from ];
+			resultBound = std::max( resultBound, bound );
+			removedTriangles += ( classFlags[ from ] & CLASS_BORDER ) ? 1 : 2;
+			collapsed = true;
+		}
+
+		if ( !collapsed ) break;
+
+		std::size_t writeIndex = 0;
+		for ( std::size_t i = 0; i < indices.size(); i += 3 )
+		{
+			const GLuint a = wedgeRemap[ indices[ i ] ], b = wedgeRemap[ indices[ i + 1 ] ], c = wedgeRemap[ indices[ i + 2 ] ];
+			if ( posClass[ a ] == posClass[ b ] || posClass[ a ] == posClass[ c ] || posClass[ b ] == posClass[ c ] ) continue;
+
+			indices[ writeIndex++ ] = a;
+			indices[ writeIndex++ ] = b;
+			indices[ writeIndex++ ] = c;
+		}
+		indices.resize( writeIndex );
+	}
+
+	if ( resultError ) *resultError = static_cast<float>( std::sqrt( resultBound ) );
+	return indices;
+}
+
+MeshSimplifier::LodChain MeshSimplifier::BuildLodChain( const MeshView<Vertex>& mesh,
+														const std::vector<ObjParser::SubMesh>& subMeshes,
+														const std::vector<float>& triangleRatios )
+{
+	LodChain chain;
+	chain.indices.assign( mesh.indices, mesh.indices + mesh.indexCount );
+
+	Lod original;
+	original.subMeshes = subMeshes;
+	if ( original.subMeshes.empty() ) original.subMeshes.push_back( { 0, static_cast<GLuint>( mesh.indexCount ), 0 } );
+	chain.lods.push_back( original );
+
+	// the positions used by more than one submesh stay in place
+	std::vector<bool> lockedVertices;
+	if ( original.subMeshes.size() > 1 )
+	{
+		constexpr unsigned int NO_SUBMESH = ~0u, SHARED = ~0u - 1;
+
+		GLuint classCount = 0;
+		const std::vector<GLuint> posClass = positionClasses( mesh, classCount );
+
+		std::vector<unsigned int> classSubMesh( classCount, NO_SUBMESH );
+		for ( unsigned int s = 0; s < original.subMeshes.size(); ++s )
+		{
+			const ObjParser::SubMesh& subMesh = original.subMeshes[ s ];
+			for ( GLuint i = subMesh.indexOffset; i < subMesh.indexOffset + subMesh.indexCount; ++i )
+			{
+				unsigned int& owner = classSubMesh[ posClass[ mesh.indices[ i ] ] ];
+				owner = ( owner == NO_SUBMESH || owner == s ) ? s : SHARED;
+			}
+		}
+
+		lockedVertices.resize( mesh.vertexCount );
+		for ( std::size_t v = 0; v < mesh.vertexCount; ++v ) lockedVertices[ v ] = classSubMesh[ posClass[ v ] ] == SHARED;
+	}
+
+	for ( const float ratio : triangleRatios )
+	{
+		const Lod previous = chain.lods.back();
+		const std::size_t chainSize = chain.indices.size();
+
+		Lod lod;
+		lod.error = previous.error;
+
+		std::size_t previousIndexCount = 0, indexCount = 0;
+		for ( std::size_t s = 0; s < previous.subMeshes.size(); ++s )
+		{
+			const ObjParser::SubMesh& subMesh = previous.subMeshes[ s ];
+			const MeshView<Vertex> subMeshView = { mesh.vertices, mesh.vertexCount, chain.indices.data() + subMesh.indexOffset, subMesh.indexCount };
+			const std::size_t targetIndexCount = static_cast<std::size_t>( original.subMeshes[ s ].indexCount / 3 * ratio ) * 3;
+
+			float error = 0.0f;
+			std::vector<GLuint> simplified = Simplify( subMeshView, targetIndexCount, std::numeric_limits<float>::max(), lockedVertices, &error );
+			MeshOptimizer::OptimizeVertexCache( simplified.data(), simplified.size(), mesh.vertexCount );
+
+			// simplified from the previous level, the errors add up
+			lod.error = std::max( lod.error, previous.error + error );
+			lod.subMeshes.push_back( { static_cast<GLuint>( chain.indices.size() ), static_cast<GLuint>( simplified.size() ), subMesh.materialId } );
+			chain.indices.insert( chain.indices.end(), simplified.cbegin(), simplified.cend() );
+
+			previousIndexCount += subMesh.indexCount;
+			indexCount += simplified.size();
+		}
+
+		if ( indexCount > previousIndexCount * LOD_MIN_REDUCTION )
+		{
+			chain.indices.resize( chainSize );
+			break;
+		}
+
+		chain.lods.push_back( std::move( lod ) );
+	}
+
+	return chain;
+}
+
+std::size_t MeshSimplifier::SelectLod( const std::vector<Lod>& lods, const float errorToPixels, const float maxPixelError )
+{
+	// the errors grow with the levels
+	std::size_t selected = 0;
+	while ( selected + 1 < lods.size() && lods[ selected + 1 ].error * errorToPixels <= maxPixelError ) ++selected;
+	return selected;
+}
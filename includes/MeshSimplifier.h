@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "GLUtils.hpp"
+#include "ObjParser.h"
+
+// Mesh simplification with the quadric error metric
+// (Garland, Heckbert: Surface Simplification Using Quadric Error Metrics, https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf).
+//
+// Only half edge collapses are done: a vertex is moved onto one of its neighbours, so no new vertex is created
+// and every level of detail can be drawn from the vertex buffer of the original mesh with its own index range.
+//
+// The vertices ObjParser split at attribute discontinuities (same position, different normal or texcoord) are
+// collapsed together: a seam may only collapse along itself, and each side keeps its own attributes.
+// Open borders may only collapse along the border, vertices on a non-manifold edge are not moved at all.
+class MeshSimplifier
+{
+public:
+	// One level of detail: the index ranges of the submeshes, and an upper bound of the distance of its surface from the original one:
+	// no vertex moved further than error from the planes of the original triangles around it (summed over the levels it was simplified through)
+	struct Lod
+	{
+		std::vector<ObjParser::SubMesh> subMeshes;
+		float error = 0.0f; // in the units of the mesh
+	};
+
+	// Index array of all the levels one after the other, lods[ 0 ] is the original mesh
+	struct LodChain
+	{
+		std::vector<GLuint> indices;
+		std::vector<Lod>    lods;
+	};
+
+	// Simplifies the triangles of mesh.indices until at most targetIndexCount indices are left,
+	// or every remaining collapse could move the surface further than targetError.
+	// Vertices with lockedVertices[ v ] set (and the ones at the same position) are not moved.
+	// resultError is the bound of the result, like Lod::error.
+	static std::vector<GLuint> Simplify( const MeshView<Vertex>& mesh,
+										 std::size_t targetIndexCount,
+										 float targetError = std::numeric_limits<float>::max(),
+										 const std::vector<bool>& lockedVertices = {},
+										 float* resultError = nullptr );
+
+	// Builds a level for each ratio (fraction of the original triangles), each level is simplified from the previous one.
+	// The submeshes are simplified separately, the positions shared by several submeshes are locked, so no cracks open between them.
+	// A level that could not be simplified further ends the chain.
+	static LodChain BuildLodChain( const MeshView<Vertex>& mesh,
+								   const std::vector<ObjParser::SubMesh>& subMeshes,
+								   const std::vector<float>& triangleRatios = { 0.5f, 0.25f, 0.1f } );
+
+	// The coarsest level whose error is at most maxPixelError pixels on the screen.
+	// errorToPixels converts the mesh units to pixels: world scale / distance * viewport height / ( 2 tan( fovy / 2 ) )
+	static std::size_t SelectLod( const std::vector<Lod>& lods, float errorToPixels, float maxPixelError = 1.0f );
+};
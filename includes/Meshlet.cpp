@@ -0,0 +1,273 @@
+#include "Meshlet.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static constexpr uint8_t NOT_IN_MESHLET = 0xff;
+
+static_assert( MeshletBuilder::MAX_VERTICES < NOT_IN_MESHLET, "local vertex indices have to fit in uint8_t" );
+
+// Bounding sphere and normal cone of the last meshlet
+static void computeMeshletBounds( Meshlet& meshlet, const MeshletMesh& meshletMesh, const MeshView<Vertex>& mesh )
+{
+	auto position = [ & ]( const uint32_t localIndex ) -> const glm::vec3&
+	{
+		return mesh.vertices[ meshletMesh.vertices[ meshlet.vertexOffset + localIndex ] ].position;
+	};
+
+	// sphere around the center of the bounding box
+	glm::vec3 boundsMin = position( 0 ), boundsMax = position( 0 );
+	for ( uint32_t i = 1; i < meshlet.vertexCount; ++i )
+	{
+		boundsMin = glm::min( boundsMin, position( i ) );
+		boundsMax = glm::max( boundsMax, position( i ) );
+	}
+
+	meshlet.center = ( boundsMin + boundsMax ) * 0.5f;
+	meshlet.radius = 0.0f;
+	for ( uint32_t i = 0; i < meshlet.vertexCount; ++i )
+		meshlet.radius = std::max( meshlet.radius, glm::distance( meshlet.center, position( i ) ) );
+
+	// the cone axis is the average of the triangle normals, degenerate triangles do not count
+	std::vector<glm::vec3> normals;
+	normals.reserve( meshlet.triangleCount );
+	glm::vec3 normalSum( 0.0f );
+
+	const uint8_t* triangles = meshletMesh.triangles.data() + 3 * meshlet.triangleOffset;
+	for ( uint32_t t = 0; t < meshlet.triangleCount; ++t )
+	{
+		const glm::vec3& p0 = position( triangles[ 3 * t ] );
+		const glm::vec3& p1 = position( triangles[ 3 * t + 1 ] );
+		const glm::vec3& p2 = position( triangles[ 3 * t + 2 ] );
+
+		const glm::vec3 normal = glm::cross( p1 - p0, p2 - p0 );
+		const float length = glm::length( normal );
+		if ( length <= 0.0f ) continue;
+
+		normals.push_back( normal / length );
+		normalSum += normals.back();
+	}
+
+	meshlet.coneAxis = glm::vec3( 0.0f, 0.0f, 1.0f );
+	meshlet.coneCutoff = 2.0f;
+
+	const float normalSumLength = glm::length( normalSum );
+	if ( normals.empty() || normalSumLength <= 1e-6f ) return;
+
+	meshlet.coneAxis = normalSum / normalSumLength;
+
+	float minCos = 1.0f;
+	for ( const glm::vec3& normal : normals ) minCos = std::min( minCos, glm::dot( meshlet.coneAxis, normal ) );
+
+	// a cone wider than a half space can not be backface culled
+	if ( minCos <= 0.0f ) return;
+
+	meshlet.coneCutoff = std::sqrt( 1.0f - minCos * minCos );
+}
+
+MeshletMesh MeshletBuilder::Build( const MeshView<Vertex>& mesh )
+{
+	MeshletMesh result;
+
+	std::vector<uint8_t> localIndices( mesh.vertexCount, NOT_IN_MESHLET );
+	Meshlet meshlet;
+
+	auto finishMeshlet = [ & ]()
+	{
+		if ( meshlet.triangleCount == 0 ) return;
+
+		computeMeshletBounds( meshlet, result, mesh );
+
+		for ( uint32_t i = 0; i < meshlet.vertexCount; ++i ) localIndices[ result.vertices[ meshlet.vertexOffset + i ] ] = NOT_IN_MESHLET;
+
+		result.meshlets.push_back( meshlet );
+
+		meshlet = Meshlet();
+		meshlet.vertexOffset = static_cast<uint32_t>( result.vertices.size() );
+		meshlet.triangleOffset = static_cast<uint32_t>( result.triangles.size() / 3 );
+	};
+
+	for ( std::size_t i = 0; i + 2 < mesh.indexCount; i += 3 )
+	{
+		const GLuint a = mesh.indices[ i ], b = mesh.indices[ i + 1 ], c = mesh.indices[ i + 2 ];
+
+		const uint32_t newVertexCount = ( localIndices[ a ] == NOT_IN_MESHLET )
+									  + ( localIndices[ b ] == NOT_IN_MESHLET && b != a )
+									  + ( localIndices[ c ] == NOT_IN_MESHLET && c != a && c != b );
+
+		if ( meshlet.vertexCount + newVertexCount > MAX_VERTICES || meshlet.triangleCount + 1 > MAX_TRIANGLES ) finishMeshlet();
+
+		for ( const GLuint v : { a, b, c } )
+		{
+			if ( localIndices[ v ] == NOT_IN_MESHLET )
+			{
+				localIndices[ v ] = static_cast<uint8_t>( meshlet.vertexCount++ );
+				result.vertices.push_back( v );
+			}
+			result.triangles.push_back( localIndices[ v ] );
+		}
+		++meshlet.triangleCount;
+	}
+
+	finishMeshlet();
+
+	return result;
+}
+
+std::vector<GLuint> MeshletBuilder::BuildIndexBuffer( const MeshletMesh& meshletMesh )
+{
+	std::vector<GLuint> indices( meshletMesh.triangles.size() );
+
+	for ( const Meshlet& meshlet : meshletMesh.meshlets )
+	{
+		for ( uint32_t i = 3 * meshlet.triangleOffset; i < 3 * ( meshlet.triangleOffset + meshlet.triangleCount ); ++i )
+			indices[ i ] = meshletMesh.vertices[ meshlet.vertexOffset + meshletMesh.triangles[ i ] ];
+	}
+
+	return indices;
+}
+
+struct MeshletFileHeader
+{
+	char     magic[ 4 ];
+	uint32_t version;
+	uint32_t meshletCount;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+static constexpr char MESHLET_MAGIC[ 4 ] = { 'M', 'S', 'H', 'L' };
+
+bool MeshletBuilder::Write( const std::filesystem::path& fileName, const MeshletMesh& meshletMesh )
+{
+	MeshletFileHeader header = {};
+	std::memcpy( header.magic, MESHLET_MAGIC, sizeof( MESHLET_MAGIC ) );
+	header.version       = VERSION;
+	header.meshletCount  = static_cast<uint32_t>( meshletMesh.meshlets.size() );
+	header.vertexCount   = static_cast<uint32_t>( meshletMesh.vertices.size() );
+	header.triangleCount = static_cast<uint32_t>( meshletMesh.triangles.size() / 3 );
+
+	std::ofstream fileStrm( fileName, std::ios::binary | std::ios::trunc );
+	if ( !fileStrm ) return false;
+
+	fileStrm.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	fileStrm.write( reinterpret_cast<const char*>( meshletMesh.meshlets.data() ), meshletMesh.meshlets.size() * sizeof( Meshlet ) );
+	fileStrm.write( reinterpret_cast<const char*>( meshletMesh.vertices.data() ), meshletMesh.vertices.size() * sizeof( GLuint ) );
+	fileStrm.write( reinterpret_cast<const char*>( meshletMesh.triangles.data() ), meshletMesh.triangles.size() );
+
+	return static_cast<bool>( fileStrm );
+}
+
+bool MeshletBuilder::Read( const std::filesystem::path& fileName, MeshletMesh& meshletMesh )
+{
+	MappedFile file( fileName, MappedFile::AccessHint::Sequential );
+	if ( !file || file.Size() < sizeof( MeshletFileHeader ) ) return false;
+
+	MeshletFileHeader header;
+	std::memcpy( &header, file.Data(), sizeof( header ) );
+
+	if ( std::memcmp( header.magic, MESHLET_MAGIC, sizeof( MESHLET_MAGIC ) ) != 0
+		 || header.version != VERSION
+		 || file.Size() != sizeof( header ) + std::size_t( header.meshletCount ) * sizeof( Meshlet )
+						   + std::size_t( header.vertexCount ) * sizeof( GLuint ) + std::size_t( header.triangleCount ) * 3 )
+	{
+		return false;
+	}
+
+	const char* data = file.Data() + sizeof( header );
+
+	meshletMesh.meshlets.resize( header.meshletCount );
+	std::memcpy( meshletMesh.meshlets.data(), data, header.meshletCount * sizeof( Meshlet ) );
+	data += header.meshletCount * sizeof( Meshlet );
+
+	meshletMesh.vertices.resize( header.vertexCount );
+	std::memcpy( meshletMesh.vertices.data(), data, header.vertexCount * sizeof( GLuint ) );
+	data += header.vertexCount * sizeof( GLuint );
+
+	meshletMesh.triangles.assign( data, data + std::size_t( header.triangleCount ) * 3 );
+
+	// a damaged file must not make BuildIndexBuffer read outside of the arrays
+	for ( const Meshlet& meshlet : meshletMesh.meshlets )
+	{
+		if ( meshlet.vertexCount > MAX_VERTICES || meshlet.triangleCount > MAX_TRIANGLES
+			 || std::size_t( meshlet.vertexOffset ) + meshlet.vertexCount > header.vertexCount
+			 || std::size_t( meshlet.triangleOffset ) + meshlet.triangleCount > header.triangleCount )
+		{
+			meshletMesh = MeshletMesh();
+			return false;
+		}
+
+		const uint8_t* triangles = meshletMesh.triangles.data() + 3 * std::size_t( meshlet.triangleOffset );
+		if ( std::any_of( triangles, triangles + 3 * std::size_t( meshlet.triangleCount ), [ &meshlet ]( const uint8_t localIndex ) { return localIndex >= meshlet.vertexCount; } ) )
+		{
+			meshletMesh = MeshletMesh();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Frustum Frustum::FromMatrix( const glm::mat4& matrix )
+{
+	// rows of the (column major) matrix
+	glm::vec4 rows[ 4 ];
+	for ( int i = 0; i < 4; ++i ) rows[ i ] = glm::vec4( matrix[ 0 ][ i ], matrix[ 1 ][ i ], matrix[ 2 ][ i ], matrix[ 3 ][ i ] );
+
+	// -w <= x,y,z <= w in clip space
+	Frustum frustum;
+	for ( int axis = 0; axis < 3; ++axis )
+	{
+		frustum.planes[ 2 * axis ]     = rows[ 3 ] + rows[ axis ];
+		frustum.planes[ 2 * axis + 1 ] = rows[ 3 ] - rows[ axis ];
+	}
+
+	for ( glm::vec4& plane : frustum.planes )
+		plane = plane / glm::length( glm::vec3( plane.x, plane.y, plane.z ) );
+
+	return frustum;
+}
+
+bool MeshletCuller::IsVisible( const Meshlet& meshlet, const Frustum& modelFrustum, const glm::vec3& modelCameraPos )
+{
+	for ( const glm::vec4& plane : modelFrustum.planes )
+	{
+		if ( glm::dot( glm::vec3( plane.x, plane.y, plane.z ), meshlet.center ) + plane.w < -meshlet.radius ) return false;
+	}
+
+	if ( meshlet.coneCutoff > 1.0f ) return true;
+
+	// Backfacing if every point of the sphere sees every normal of the cone from behind:
+	// the angle of the view direction and the axis plus the half angle of the cone must keep the sphere behind the triangles
+	const glm::vec3 viewDir = meshlet.center - modelCameraPos;
+	const float distance = glm::length( viewDir );
+	if ( distance <= meshlet.radius ) return true; // the camera is inside the sphere
+
+	const float cosView = glm::dot( viewDir, meshlet.coneAxis ) / distance;
+	const float sinView = std::sqrt( std::max( 0.0f, 1.0f - cosView * cosView ) );
+	const float sinCone = meshlet.coneCutoff;
+	const float cosCone = std::sqrt( 1.0f - sinCone * sinCone );
+
+	// cos( view angle + cone half angle ) >= radius / distance
+	return cosView * cosCone - sinView * sinCone < meshlet.radius / distance;
+}
+
+std::vector<uint32_t> MeshletCuller::Cull( const MeshletMesh& meshletMesh, const glm::mat4& viewProj, const glm::mat4& world, const glm::vec3& cameraPos )
+{
+	// The test is done in model space: the frustum planes of viewProj * world are the model space planes,
+	// and whether a triangle faces the camera does not change with an orientation preserving affine transformation.
+	const Frustum modelFrustum = Frustum::FromMatrix( viewProj * world );
+	const glm::vec4 modelCameraPos = glm::inverse( world ) * glm::vec4( cameraPos, 1.0f );
+
+	std::vector<uint32_t> visibleMeshlets;
+	for ( uint32_t i = 0; i < meshletMesh.meshlets.size(); ++i )
+	{
+		if ( IsVisible( meshletMesh.meshlets[ i ], modelFrustum, glm::vec3( modelCameraPos.x, modelCameraPos.y, modelCameraPos.z ) ) )
+			visibleMeshlets.push_back( i );
+	}
+
+	return visibleMeshlets;
+}
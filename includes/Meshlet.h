@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "GLUtils.hpp"
+
+// A small cluster of triangles with its own culling bounds.
+// The triangles refer to local vertices (uint8), the local vertices to the vertices of the mesh.
+struct Meshlet
+{
+	uint32_t vertexOffset = 0;   // into MeshletMesh::vertices
+	uint32_t triangleOffset = 0; // into MeshletMesh::triangles, in triangles
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+
+	// bounding sphere
+	glm::vec3 center = glm::vec3( 0.0f );
+	float     radius = 0.0f;
+
+	// Normal cone: every triangle normal is within the cone around coneAxis.
+	// coneCutoff is the sine of its half angle, > 1 if the cluster can not be backface culled.
+	glm::vec3 coneAxis = glm::vec3( 0.0f, 0.0f, 1.0f );
+	float     coneCutoff = 2.0f;
+};
+
+struct MeshletMesh
+{
+	std::vector<Meshlet>  meshlets;
+	std::vector<GLuint>   vertices;  // mesh vertex index of each local vertex
+	std::vector<uint8_t>  triangles; // 3 local vertex indices per triangle
+};
+
+// Planes of a view frustum, ax + by + cz + d >= 0 inside
+struct Frustum
+{
+	glm::vec4 planes[ 6 ];
+
+	// The planes of the clip space volume of the matrix (Gribb-Hartmann).
+	// With viewProj * world the planes are in the model space of the mesh.
+	static Frustum FromMatrix( const glm::mat4& matrix );
+};
+
+class MeshletBuilder
+{
+public:
+	static constexpr uint32_t MAX_VERTICES = 64;
+	static constexpr uint32_t MAX_TRIANGLES = 124;
+
+	// Splits the triangles of the mesh into meshlets in index order,
+	// so a vertex cache optimized mesh (MeshOptimizer) gives compact clusters.
+	static MeshletMesh Build( const MeshView<Vertex>& mesh );
+
+	// Index buffer of the meshlets one after the other with mesh vertex indices:
+	// meshlet i is drawn from triangleOffset * 3 with triangleCount * 3 indices.
+	static std::vector<GLuint> BuildIndexBuffer( const MeshletMesh& meshletMesh );
+
+	static bool Write( const std::filesystem::path& fileName, const MeshletMesh& meshletMesh );
+	// false if the file is missing, of another VERSION or damaged (e.g. a meshlet refers past the arrays)
+	static bool Read( const std::filesystem::path& fileName, MeshletMesh& meshletMesh );
+
+	static constexpr uint32_t VERSION = 1;
+};
+
+class MeshletCuller
+{
+public:
+	// modelFrustum and modelCameraPos are in the model space of the mesh,
+	// so the test is exact for any world matrix (see Cull).
+	static bool IsVisible( const Meshlet& meshlet, const Frustum& modelFrustum, const glm::vec3& modelCameraPos );
+
+	// Indices of the meshlets not culled by the frustum or by their normal cone.
+	static std::vector<uint32_t> Cull( const MeshletMesh& meshletMesh, const glm::mat4& viewProj, const glm::mat4& world, const glm::vec3& cameraPos );
+};
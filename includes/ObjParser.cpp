@@ -1,27 +1,146 @@
 #include "ObjParser.h"
+#include "ObjTokenizer.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
 #include <array>
-#include <list>
+#include <deque>
+#include <queue>
 #include <string>
 #include <charconv>
+#include <cmath>
+#include <chrono>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <iterator>
 
 #include <glm/gtx/norm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 using namespace std;
 
-class InMemoryTokenizer
+// Character classification of the tokenizer, same as std::isspace in the "C" locale:
+// ' ', '\t', '\n', '\v', '\f', '\r'
+static inline bool isSpace( const char ch ) noexcept
 {
-public:
-	InMemoryTokenizer() = default;
-	void SetData( const char* ptr, size_t Length ) noexcept;
-	std::string_view NextToken( bool onlySameLine = false ) noexcept;
-	void ToNextLine() noexcept;
-	operator bool() const noexcept;
-private:
-	const char* currentPtr = nullptr;
-	const char* endPtr = nullptr;
-};
+	return ch == ' ' || static_cast<unsigned char>( ch - '\t' ) <= '\r' - '\t';
+}
+
+// Vectorized scans for whitespace boundaries, 32 (AVX2) or 16 (SSE2) bytes at a time.
+// The tail of the buffer (and every other platform) is handled by the scalar loop.
+#if defined( __AVX2__ )
+	#include <immintrin.h>
+	#define OBJPARSER_SIMD_WIDTH 32
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#include <emmintrin.h>
+	#define OBJPARSER_SIMD_WIDTH 16
+#endif
+
+#ifdef OBJPARSER_SIMD_WIDTH
+static inline int countTrailingZeros( const uint32_t mask ) noexcept
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return static_cast<int>( index );
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+
+// bit i of the result is set if ptr[ i ] is whitespace
+static inline uint32_t whitespaceMask( const char* ptr ) noexcept
+{
+#if OBJPARSER_SIMD_WIDTH == 32
+	const __m256i chars   = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( ptr ) );
+	const __m256i isBlank = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ' ' ) );
+	const __m256i ctrl    = _mm256_sub_epi8( chars, _mm256_set1_epi8( '\t' ) );
+	const __m256i isCtrl  = _mm256_cmpeq_epi8( _mm256_min_epu8( ctrl, _mm256_set1_epi8( '\r' - '\t' ) ), ctrl );
+	return static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_or_si256( isBlank, isCtrl ) ) );
+#else
+	const __m128i chars   = _mm_loadu_si128( reinterpret_cast<const __m128i*>( ptr ) );
+	const __m128i isBlank = _mm_cmpeq_epi8( chars, _mm_set1_epi8( ' ' ) );
+	const __m128i ctrl    = _mm_sub_epi8( chars, _mm_set1_epi8( '\t' ) );
+	const __m128i isCtrl  = _mm_cmpeq_epi8( _mm_min_epu8( ctrl, _mm_set1_epi8( '\r' - '\t' ) ), ctrl );
+	return static_cast<uint32_t>( _mm_movemask_epi8( _mm_or_si128( isBlank, isCtrl ) ) );
+#endif
+}
+#endif
+
+// first whitespace in [ptr, endPtr), or endPtr
+static inline const char* findSpace( const char* ptr, const char* endPtr ) noexcept
+{
+#ifdef OBJPARSER_SIMD_WIDTH
+	for ( ; endPtr - ptr >= OBJPARSER_SIMD_WIDTH; ptr += OBJPARSER_SIMD_WIDTH )
+	{
+		const uint32_t mask = whitespaceMask( ptr );
+		if ( mask != 0 ) return ptr + countTrailingZeros( mask );
+	}
+#endif
+	while ( ptr < endPtr && !isSpace( *ptr ) ) ++ptr;
+	return ptr;
+}
+
+// first non-whitespace in [ptr, endPtr), or endPtr
+static inline const char* skipSpace( const char* ptr, const char* endPtr ) noexcept
+{
+	// usually there is only a single separator, do not start up the vector unit for that
+	if ( ptr < endPtr && !isSpace( *ptr ) ) return ptr;
+	if ( ptr + 1 < endPtr && !isSpace( ptr[ 1 ] ) ) return ptr + 1;
+
+#ifdef OBJPARSER_SIMD_WIDTH
+	constexpr uint32_t fullMask = OBJPARSER_SIMD_WIDTH == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+	for ( ; endPtr - ptr >= OBJPARSER_SIMD_WIDTH; ptr += OBJPARSER_SIMD_WIDTH )
+	{
+		const uint32_t mask = whitespaceMask( ptr ) ^ fullMask;
+		if ( mask != 0 ) return ptr + countTrailingZeros( mask );
+	}
+#endif
+	while ( ptr < endPtr && isSpace( *ptr ) ) ++ptr;
+	return ptr;
+}
+
+// Fast path for plain decimal numbers ([-]digits[.digits]), as most exporters write them.
+// If the mantissa fits into the 24 bit float significand and the divisor is an exactly representable
+// power of 10, a single float division is correctly rounded, so the result is bit for bit the same as std::from_chars.
+// ( W. D. Clinger: How to read floating point numbers accurately, 1990 )
+// Returns false (leaving ptr untouched) if the number is not of this form.
+static inline bool parseSimpleFloat( const char*& ptr, const char* endPtr, float& value ) noexcept
+{
+	static constexpr float exactPowersOf10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+	const char* p = ptr;
+	const bool negative = ( p < endPtr && *p == '-' );
+	if ( negative ) ++p;
+
+	uint64_t mantissa = 0;
+	int digitCount = 0;
+	int fractionDigits = 0;
+
+	for ( ; p < endPtr && static_cast<unsigned char>( *p - '0' ) <= 9; ++p, ++digitCount )
+	{
+		mantissa = mantissa * 10 + static_cast<unsigned char>( *p - '0' );
+	}
+	if ( p < endPtr && *p == '.' )
+	{
+		++p;
+		for ( ; p < endPtr && static_cast<unsigned char>( *p - '0' ) <= 9; ++p, ++digitCount, ++fractionDigits )
+		{
+			mantissa = mantissa * 10 + static_cast<unsigned char>( *p - '0' );
+		}
+	}
+
+	if ( digitCount == 0 || digitCount > 18 ) return false; // no number or the mantissa might have overflown
+	if ( p < endPtr && !isSpace( *p ) ) return false;        // exponent, or anything else std::from_chars should decide
+	if ( mantissa > ( 1u << 24 ) || fractionDigits >= static_cast<int>( std::size( exactPowersOf10 ) ) ) return false;
+
+	const float magnitude = static_cast<float>( mantissa ) / exactPowersOf10[ fractionDigits ];
+	value = negative ? -magnitude : magnitude;
+	ptr = p;
+	return true;
+}
 
 void InMemoryTokenizer::SetData( const char* ptr, size_t Length ) noexcept
 {
@@ -31,32 +150,42 @@ void InMemoryTokenizer::SetData( const char* ptr, size_t Length ) noexcept
 
 std::string_view InMemoryTokenizer::NextToken( bool onlySameLine ) noexcept
 {
-	for ( ;currentPtr < endPtr 
-			&& std::isspace(static_cast<unsigned char>(*currentPtr) ); ++currentPtr )
+	const char* tPtr = skipSpace( currentPtr, endPtr );
+
+	if ( onlySameLine )
 	{
-		if ( onlySameLine && *currentPtr == '\n' )
+		const void* newLine = std::memchr( currentPtr, '\n', static_cast<std::size_t>( tPtr - currentPtr ) );
+		if ( newLine != nullptr )
 		{
+			currentPtr = static_cast<const char*>( newLine );
 			return std::string_view();
 		}
 	}
-	const char* tPtr = currentPtr;
-	std::size_t tLength = 0;
 
-	while ( currentPtr < endPtr 
-			&& !std::isspace(static_cast<unsigned char>(*currentPtr) ) )
+	currentPtr = findSpace( tPtr, endPtr );
+
+	return std::string_view( tPtr, static_cast<std::size_t>( currentPtr - tPtr ) );
+}
+
+// Reads count whitespace separated numbers, the same way as NextToken() + std::from_chars would.
+void InMemoryTokenizer::NextFloats( float* values, std::size_t count ) noexcept
+{
+	for ( std::size_t i = 0; i < count; ++i )
 	{
-		currentPtr++;
-		tLength++;
-	}
+		currentPtr = skipSpace( currentPtr, endPtr );
 
-	return std::string_view( tPtr, tLength );
+		if ( !parseSimpleFloat( currentPtr, endPtr, values[ i ] ) )
+		{
+			std::string_view coordT = NextToken();
+			std::from_chars( coordT.data(), coordT.data() + coordT.size(), values[ i ] );
+		}
+	}
 }
 
 void InMemoryTokenizer::ToNextLine() noexcept
 {
-	while ( currentPtr < endPtr && *currentPtr != '\n' )
-		currentPtr++;
-	currentPtr++;
+	const void* newLine = std::memchr( currentPtr, '\n', static_cast<std::size_t>( std::max( endPtr - currentPtr, std::ptrdiff_t( 0 ) ) ) );
+	currentPtr = ( newLine != nullptr ) ? static_cast<const char*>( newLine ) + 1 : endPtr;
 }
 
 InMemoryTokenizer::operator bool() const noexcept
@@ -73,58 +202,860 @@ constexpr unsigned short From2Char( const char ch1, const char ch2)
 
 static std::vector<unsigned int> triangulatePolygon( const std::vector<glm::vec2>& );
 
-ObjParser::Mesh ObjParser::parse(const std::filesystem::path& fileName)
+// Faces before the first usemtl of a chunk use the material that was active at the end of the previous chunk
+static constexpr uint32_t INHERITED_MATERIAL_SLOT = ~0u;
+
+// Raw face as it was read from the file: a range of corners in ParsedChunk::faceVerts
+struct ObjParser::FaceRecord
 {
-	Mesh resultMesh;
+	std::size_t  firstVert = 0;
+	unsigned int vertCount = 0;
+	bool         needsNormalComputation = false;
+	uint32_t     materialSlot = INHERITED_MATERIAL_SLOT; // index into ParsedChunk::materialNames
+};
+
+// Everything parsed from a line-aligned part of the file.
+// Attribute indices in the faces are global (file) indices, so chunks can be parsed independently.
+struct ObjParser::ParsedChunk
+{
+	const char* dataBegin = nullptr;
+	const char* dataEnd = nullptr;
 
 	std::vector<glm::vec3> positions;
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec2> texcoords;
 
-	std::vector<IndexedVert> face_vertIds;
-	face_vertIds.reserve( 4 );
-	bool needsNormalComputation = false;
-	std::unordered_map<IndexedVert, unsigned int, IndexedVertHash> vertexIndices;
+	std::vector<FaceRecord>  faces;
+	std::vector<IndexedVert> faceVerts;
+
+	std::vector<std::string> materialLibraries; // mtllib
+	std::vector<std::string> materialNames;     // usemtl, in the order of the switches
+
+	// Output of the triangulation: 3 corners per triangle.
+	// Corners with computed normals refer to computedNormals, marked with COMPUTED_NORMAL_FLAG.
+	std::vector<IndexedVert> triVerts;
+	std::vector<glm::vec3>   computedNormals;
+	std::vector<uint32_t>    triMaterialSlots; // one per triangle
+	std::size_t              invalidFaces = 0;
+};
+
+// Normals computed for faces without normal indices live in a separate index space,
+// so they do not shift the indices of the normals read from the file.
+static constexpr uint32_t COMPUTED_NORMAL_FLAG = 0x80000000u;
+
+// Chunks smaller than this are not worth a thread of their own
+static constexpr std::size_t MIN_PARALLEL_CHUNK_SIZE = 1 << 20;
+
+static std::size_t parallelChunkCount( const std::size_t size, const std::size_t threadCount )
+{
+	return std::max<std::size_t>( 1, std::min<std::size_t>( threadCount, size / MIN_PARALLEL_CHUNK_SIZE ) );
+}
+
+template <typename Func>
+static void runParallel( ThreadPool* pool, const std::size_t count, Func&& func )
+{
+	if ( pool == nullptr || count == 1 )
+	{
+		for ( std::size_t i = 0; i < count; ++i ) func( i );
+		return;
+	}
+
+	pool->ParallelFor( count, std::forward<Func>( func ) );
+}
+
+template <typename T>
+static void appendAll( std::vector<T>& dst, std::vector<T>& src )
+{
+	if ( dst.empty() )
+	{
+		dst = std::move( src );
+	}
+	else
+	{
+		dst.insert( dst.end(), src.cbegin(), src.cend() );
+		src = std::vector<T>();
+	}
+}
+
+// Open addressing (linear probing) map from a vertex key to its 1 based index, 0 means "not inserted yet".
+// Keys and values are stored inline in one array, so a lookup is usually a single cache miss.
+template <typename KeyT, typename HashT>
+class FlatIndexMap
+{
+public:
+	explicit FlatIndexMap( const std::size_t expectedCount )
+	{
+		Rehash( expectedCount );
+	}
+
+	unsigned int& operator[]( const KeyT& key )
+	{
+		if ( ( count + 1 ) * 4 > slots.size() * 3 ) Rehash( slots.size() );
+
+		for ( std::size_t i = HashT()( key ) & mask; ; i = ( i + 1 ) & mask )
+		{
+			Slot& slot = slots[ i ];
+			if ( slot.value == 0 )
+			{
+				slot.key = key;
+				++count;
+				return slot.value;
+			}
+			if ( slot.key == key ) return slot.value;
+		}
+	}
+
+	// 1 based index of the key, 0 if it is not inserted
+	unsigned int Find( const KeyT& key ) const
+	{
+		for ( std::size_t i = HashT()( key ) & mask; ; i = ( i + 1 ) & mask )
+		{
+			const Slot& slot = slots[ i ];
+			if ( slot.value == 0 ) return 0;
+			if ( slot.key == key ) return slot.value;
+		}
+	}
+
+	// forget all keys, keep the capacity
+	void Clear()
+	{
+		std::fill( slots.begin(), slots.end(), Slot() );
+		count = 0;
+	}
+
+	std::size_t MemoryBytes() const noexcept
+	{
+		return slots.capacity() * sizeof( Slot );
+	}
+
+private:
+	struct Slot
+	{
+		KeyT         key;
+		unsigned int value = 0;
+	};
+
+	// resize to hold expectedCount keys at most 75% full
+	void Rehash( const std::size_t expectedCount )
+	{
+		std::size_t capacity = 16;
+		while ( capacity * 3 < expectedCount * 4 + 4 ) capacity *= 2;
+
+		std::vector<Slot> oldSlots( capacity );
+		oldSlots.swap( slots );
+		mask = capacity - 1;
+
+		for ( const Slot& oldSlot : oldSlots )
+		{
+			if ( oldSlot.value == 0 ) continue;
+
+			std::size_t i = HashT()( oldSlot.key ) & mask;
+			while ( slots[ i ].value != 0 ) i = ( i + 1 ) & mask;
+			slots[ i ] = oldSlot;
+		}
+	}
+
+	std::vector<Slot> slots;
+	std::size_t mask = 0;
+	std::size_t count = 0;
+};
+
+// Position index of the streaming import, multiplicative (Fibonacci) hashing is enough for these keys
+struct PositionIndexHash
+{
+	std::size_t operator()( const uint32_t index ) const noexcept
+	{
+		return static_cast<std::size_t>( ( index * 0x9E3779B97F4A7C15ull ) >> 29 );
+	}
+};
+
+template <typename T>
+static std::size_t capacityBytes( const std::vector<T>& values ) noexcept
+{
+	return values.capacity() * sizeof( T );
+}
+
+// Append-only attribute array of the streaming import that takes a fixed amount of memory.
+// The records are stored in pages: the page being filled and a direct mapped cache of full pages
+// (page i can only be in slot i % slotCount) stay in memory, the rest goes to a temporary file and is read back
+// when a face refers to it. Faces mostly use recent attributes, which are still cached,
+// and a file whose attributes fit into the cache never touches the disk.
+template <typename T>
+class SpilledArray
+{
+public:
+	// memoryBytes is split into at least 16 pages of 1-64 KB, one of them is the page being filled
+	explicit SpilledArray( const std::size_t memoryBytes )
+	{
+		const std::size_t pageBytes = std::clamp<std::size_t>( memoryBytes / 16, 1 << 10, 64 << 10 );
+		pageRecords = pageBytes / sizeof( T );
+		slots.resize( std::max<std::size_t>( memoryBytes / ( pageRecords * sizeof( T ) ), 2 ) - 1 );
+
+		tail.reserve( pageRecords );
+		for ( Slot& slot : slots ) slot.records.reserve( pageRecords );
+	}
+
+	~SpilledArray()
+	{
+		if ( !file.is_open() ) return;
+
+		file.close();
+		std::error_code ec;
+		std::filesystem::remove( filePath, ec );
+	}
+
+	SpilledArray( const SpilledArray& ) = delete;
+	SpilledArray& operator=( const SpilledArray& ) = delete;
+
+	std::size_t Size() const noexcept { return fullPages * pageRecords + tail.size(); }
+
+	void PushBack( const T& value )
+	{
+		tail.push_back( value );
+		if ( tail.size() < pageRecords ) return;
+
+		// the full page is cached right away, the next faces will likely refer to it
+		Slot& slot = slots[ fullPages % slots.size() ];
+		Evict( slot );
+		slot.records.swap( tail );
+		slot.page = fullPages;
+		slot.isWritten = false;
+
+		tail.clear();
+		++fullPages;
+	}
+
+	// Throws ObjParser::EXC_TEMPFILE if the temporary file cannot be read or written.
+	T At( const std::size_t index )
+	{
+		const std::size_t page = index / pageRecords;
+		if ( page == fullPages ) return tail[ index % pageRecords ];
+
+		Slot& slot = slots[ page % slots.size() ];
+		if ( slot.page != page )
+		{
+			Evict( slot );
+
+			slot.records.resize( pageRecords );
+			file.seekg( static_cast<std::streamoff>( page * PageBytes() ) );
+			file.read( reinterpret_cast<char*>( slot.records.data() ), static_cast<std::streamsize>( PageBytes() ) );
+			if ( !file ) throw( ObjParser::EXC_TEMPFILE );
+
+			slot.page = page;
+			slot.isWritten = true;
+		}
+		return slot.records[ index % pageRecords ];
+	}
+
+	std::size_t MemoryBytes() const noexcept { return ( slots.size() + 1 ) * PageBytes(); }
+	std::size_t SpilledBytes() const noexcept { return spilledBytes; }
+
+private:
+	struct Slot
+	{
+		std::vector<T> records;
+		std::size_t    page = ~std::size_t( 0 );
+		bool           isWritten = true; // an empty slot needs no writing either
+	};
+
+	std::size_t PageBytes() const noexcept { return pageRecords * sizeof( T ); }
+
+	// a page only goes to the file when it leaves the cache for the first time
+	void Evict( Slot& slot )
+	{
+		if ( slot.isWritten ) return;
+
+		if ( !file.is_open() ) OpenFile();
+
+		file.seekp( static_cast<std::streamoff>( slot.page * PageBytes() ) );
+		file.write( reinterpret_cast<const char*>( slot.records.data() ), static_cast<std::streamsize>( PageBytes() ) );
+		if ( !file ) throw( ObjParser::EXC_TEMPFILE );
+
+		spilledBytes += PageBytes();
+		slot.isWritten = true;
+	}
+
+	void OpenFile()
+	{
+		static std::atomic<unsigned int> fileCounter{ 0 };
+
+		std::error_code ec;
+		const std::filesystem::path directory = std::filesystem::temp_directory_path( ec );
+		if ( ec ) throw( ObjParser::EXC_TEMPFILE );
+
+		filePath = directory / ( "objstream_" + std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() )
+								 + "_" + std::to_string( fileCounter++ ) + ".tmp" );
+		file.open( filePath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( !file ) throw( ObjParser::EXC_TEMPFILE );
+	}
+
+	std::size_t       pageRecords = 0;
+	std::size_t       fullPages = 0;
+	std::vector<T>    tail; // the page being filled
+	std::vector<Slot> slots;
+
+	std::filesystem::path filePath;
+	std::fstream          file;
+	std::size_t           spilledBytes = 0;
+};
+
+ObjParser::Mesh ObjParser::parse( const std::filesystem::path& fileName, unsigned int threadCount )
+{
+	return std::move( parseModel( fileName, threadCount ).mesh );
+}
+
+// Milliseconds since phaseStart, which is moved to now
+static double finishPhase( std::chrono::steady_clock::time_point& phaseStart )
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double milliseconds = std::chrono::duration<double, std::milli>( now - phaseStart ).count();
+	phaseStart = now;
+	return milliseconds;
+}
+
+ObjParser::Model ObjParser::parseModel( const std::filesystem::path& fileName, unsigned int threadCount )
+{
+	// The tokenizer works directly on the mapped file, no intermediate copy is made.
+	MappedFile objFile( fileName, MappedFile::AccessHint::Sequential );
+
+	if ( !objFile ) throw(EXC_FILENOTFOUND);
+
+	Model resultModel = parseMemory( objFile.Data(), objFile.Size(), threadCount );
+	LoadMaterialsOf( fileName, resultModel );
+	return resultModel;
+}
+
+ObjParser::Model ObjParser::parseModel( const std::filesystem::path& fileName, ThreadPool& pool )
+{
+	MappedFile objFile( fileName, MappedFile::AccessHint::Sequential );
+
+	if ( !objFile ) throw(EXC_FILENOTFOUND);
+
+	Model resultModel = parseMemory( objFile.Data(), objFile.Size(), pool );
+	LoadMaterialsOf( fileName, resultModel );
+	return resultModel;
+}
+
+void ObjParser::LoadMaterialsOf( const std::filesystem::path& fileName, Model& model )
+{
+	// parseMemory only knows the names of the materials, their properties are in the libraries
+	auto phaseStart = std::chrono::steady_clock::now();
+
+	std::vector<std::string> materialNames( model.materials.size() );
+	std::transform( model.materials.cbegin(), model.materials.cend(), materialNames.begin(), []( const Material& material ) { return material.name; } );
+	model.materials = loadMaterials( fileName, model.materialLibraries, materialNames );
+
+	model.stats.groupMs += finishPhase( phaseStart );
+}
+
+ObjParser::Model ObjParser::parseMemory( const char* data, std::size_t size, unsigned int threadCount )
+{
+	if ( threadCount == HARDWARE_THREADS ) threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+
+	if ( parallelChunkCount( size, threadCount ) == 1 ) return ParseOnPool( data, size, nullptr );
+
+	// the calling thread parses a chunk too
+	ThreadPool pool( threadCount - 1 );
+	return ParseOnPool( data, size, &pool );
+}
+
+ObjParser::Model ObjParser::parseMemory( const char* data, std::size_t size, ThreadPool& pool )
+{
+	return ParseOnPool( data, size, &pool );
+}
+
+ObjParser::Model ObjParser::ParseOnPool( const char* data, std::size_t size, ThreadPool* pool )
+{
+	Model resultModel;
+	Mesh& resultMesh = resultModel.mesh;
+
+	ParseStats& stats = resultModel.stats;
+	stats.fileBytes = size;
+	auto phaseStart = std::chrono::steady_clock::now();
+
+	//
+	// 1. Split the file at line boundaries and parse the parts independently
+	//
+
+	// a chunk per worker and one for the calling thread
+	const std::size_t chunkCount = parallelChunkCount( size, pool != nullptr ? pool->ThreadCount() + 1 : 1 );
+
+	std::vector<ParsedChunk> chunks( chunkCount );
+	{
+		const char* const fileBegin = data;
+		const char* const fileEnd = fileBegin + size;
+
+		const char* chunkBegin = fileBegin;
+		for ( std::size_t i = 0; i < chunkCount; ++i )
+		{
+			const char* chunkEnd = fileEnd;
+			if ( i + 1 < chunkCount )
+			{
+				chunkEnd = std::max( chunkBegin, fileBegin + size / chunkCount * ( i + 1 ) );
+				chunkEnd = std::find( chunkEnd, fileEnd, '\n' );
+				if ( chunkEnd != fileEnd ) ++chunkEnd;
+			}
+			chunks[ i ].dataBegin = chunkBegin;
+			chunks[ i ].dataEnd = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+	}
+
+	runParallel( pool, chunkCount, [ &chunks ]( const std::size_t i ) { ParseChunk( chunks[ i ] ); } );
+
+	stats.threadCount = static_cast<unsigned int>( chunkCount );
+	stats.tokenizeMs = finishPhase( phaseStart );
+
+	//
+	// 2. Merge the vertex attributes in file order
+	//
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+
+	for ( ParsedChunk& chunk : chunks )
+	{
+		appendAll( positions, chunk.positions );
+		appendAll( normals, chunk.normals );
+		appendAll( texcoords, chunk.texcoords );
+
+		for ( const std::string& library : chunk.materialLibraries )
+		{
+			if ( std::find( resultModel.materialLibraries.cbegin(), resultModel.materialLibraries.cend(), library ) == resultModel.materialLibraries.cend() )
+				resultModel.materialLibraries.push_back( library );
+		}
+	}
+
+	// faces without texture coordinates refer to the 0th one
+	if ( texcoords.empty() ) texcoords.emplace_back( glm::vec2( 0.0 ) );
+
+	stats.mergeMs = finishPhase( phaseStart );
+
+	//
+	// 3. Triangulate the faces, compute the missing normals
+	//
+
+	runParallel( pool, chunkCount, [ &chunks, &positions, &normals, &texcoords ]( const std::size_t i )
+	{
+		TriangulateChunk( chunks[ i ], positions, normals.size(), texcoords.size() );
+	} );
+
+	for ( const ParsedChunk& chunk : chunks ) stats.invalidFaces += chunk.invalidFaces;
+	stats.triangulateMs = finishPhase( phaseStart );
+
+	//
+	// 4. Deduplicate the vertices in file order
+	//
+
+	std::size_t triVertCount = 0;
+	for ( const ParsedChunk& chunk : chunks ) triVertCount += chunk.triVerts.size();
+	resultMesh.indexArray.reserve( triVertCount );
+	stats.faceCorners = triVertCount;
+
+	// there cannot be more distinct vertices than face corners, so the map never grows
+	FlatIndexMap<IndexedVert, IndexedVertHash> vertexIndices( triVertCount );
+
+	unsigned int nIndexedVerts = 0;
+	uint32_t computedNormalOffset = 0;
+
+	// material ids are given in the order of the first use
+	std::vector<std::string> materialNames;
+	auto materialIdOf = [ &materialNames ]( const std::string& name ) -> unsigned int
+	{
+		auto it = std::find( materialNames.cbegin(), materialNames.cend(), name );
+		if ( it == materialNames.cend() ) it = materialNames.insert( materialNames.cend(), name );
+		return static_cast<unsigned int>( it - materialNames.cbegin() );
+	};
+
+	std::vector<unsigned int> triMaterialIds;
+	triMaterialIds.reserve( triVertCount / 3 );
+	std::vector<unsigned int> slotMaterialIds;
+	bool hasActiveMaterial = false;
+	unsigned int activeMaterialId = 0;
+
+	for ( ParsedChunk& chunk : chunks )
+	{
+		slotMaterialIds.resize( chunk.materialNames.size() );
+		for ( std::size_t slot = 0; slot < chunk.materialNames.size(); ++slot )
+			slotMaterialIds[ slot ] = materialIdOf( chunk.materialNames[ slot ] );
+
+		for ( const uint32_t slot : chunk.triMaterialSlots )
+		{
+			if ( slot == INHERITED_MATERIAL_SLOT && !hasActiveMaterial ) // no usemtl so far
+			{
+				activeMaterialId = materialIdOf( std::string() );
+				hasActiveMaterial = true;
+			}
+			triMaterialIds.push_back( slot == INHERITED_MATERIAL_SLOT ? activeMaterialId : slotMaterialIds[ slot ] );
+		}
+		if ( !chunk.materialNames.empty() )
+		{
+			activeMaterialId = slotMaterialIds.back();
+			hasActiveMaterial = true;
+		}
+
+		for ( IndexedVert vertex : chunk.triVerts )
+		{
+			const bool hasComputedNormal = ( vertex.vn & COMPUTED_NORMAL_FLAG ) != 0;
+			const uint32_t localNormalIdx = vertex.vn & ~COMPUTED_NORMAL_FLAG;
+			if ( hasComputedNormal ) vertex.vn = COMPUTED_NORMAL_FLAG | ( computedNormalOffset + localNormalIdx );
+
+			unsigned int& vIndex = vertexIndices[ vertex ];
+			if (vIndex == 0) // new vertex
+			{
+				Vertex v;
+				v.position = positions[vertex.v];
+				v.texcoord = texcoords[vertex.vt];
+				v.normal = hasComputedNormal ? chunk.computedNormals[ localNormalIdx ] : normals[vertex.vn];
+
+				resultMesh.vertexArray.push_back(v);
+				resultMesh.indexArray.push_back(nIndexedVerts++);
+				vIndex = nIndexedVerts;	
+			} else {
+				resultMesh.indexArray.push_back(vIndex-1);
+			}
+		}
+
+		computedNormalOffset += static_cast<uint32_t>( chunk.computedNormals.size() );
+		chunk = ParsedChunk();
+	}
+
+	stats.dedupMs = finishPhase( phaseStart );
+
+	//
+	// 5. Group the triangles by material (stable, the file order is kept inside a group)
+	//
 
-	std::error_code ec;
-	std::size_t fileSize = std::filesystem::file_size( fileName, ec );
+	std::vector<GLuint> materialIndexCounts( materialNames.size(), 0 );
+	for ( const unsigned int materialId : triMaterialIds ) materialIndexCounts[ materialId ] += 3;
 
-	if ( ec ) throw(EXC_FILENOTFOUND);
+	GLuint indexOffset = 0;
+	for ( unsigned int materialId = 0; materialId < materialNames.size(); ++materialId )
+	{
+		if ( materialIndexCounts[ materialId ] == 0 ) continue; // usemtl without faces
+
+		resultModel.subMeshes.push_back( { indexOffset, materialIndexCounts[ materialId ], materialId } );
+		indexOffset += materialIndexCounts[ materialId ];
+	}
+
+	if ( resultModel.subMeshes.size() > 1 )
+	{
+		std::vector<GLuint> materialWriteOffsets( materialNames.size(), 0 );
+		for ( const SubMesh& subMesh : resultModel.subMeshes ) materialWriteOffsets[ subMesh.materialId ] = subMesh.indexOffset;
+
+		std::vector<GLuint> groupedIndices( resultMesh.indexArray.size() );
+		for ( std::size_t tri = 0; tri < triMaterialIds.size(); ++tri )
+		{
+			GLuint& writeOffset = materialWriteOffsets[ triMaterialIds[ tri ] ];
+			std::copy_n( resultMesh.indexArray.cbegin() + 3 * tri, 3, groupedIndices.begin() + writeOffset );
+			writeOffset += 3;
+		}
+		resultMesh.indexArray = std::move( groupedIndices );
+	}
+
+	resultModel.materials.resize( materialNames.size() );
+	for ( std::size_t i = 0; i < materialNames.size(); ++i ) resultModel.materials[ i ].name = materialNames[ i ];
 
-	std::vector<char> objRawData( fileSize );
+	stats.groupMs = finishPhase( phaseStart );
+
+	return resultModel;
+}
 
+ObjParser::StreamStats ObjParser::parseStream( const std::filesystem::path& fileName, const BatchCallback& onBatch, std::size_t memoryBudget, std::size_t maxBatchVertices )
+{
 	std::ifstream objFileStrm( fileName, std::ios::binary );
 
 	if ( !objFileStrm ) throw(EXC_FILENOTFOUND);
 
-	objFileStrm.read( objRawData.data(), fileSize );
+	memoryBudget = std::max( memoryBudget, MIN_STREAM_BUDGET );
+
+	StreamStats stats;
+	stats.memoryBudget = memoryBudget;
+	stats.windowBytes = memoryBudget / 64;
+
+	// Faces may refer to any earlier attribute, the ones that do not fit into the cache are spilled to disk
+	const std::size_t attributeCacheBytes = memoryBudget / 4 / 3;
+	SpilledArray<glm::vec3> positions( attributeCacheBytes );
+	SpilledArray<glm::vec3> normals( attributeCacheBytes );
+	SpilledArray<glm::vec2> texcoords( attributeCacheBytes );
+
+	// A batch vertex takes its Vertex, about two triangles worth of indices and at most 8/3 slots of the deduplication map.
+	// The index count is limited too, so a batch of few but often reused vertices cannot grow without bounds.
+	constexpr std::size_t BATCH_BYTES_PER_VERTEX = sizeof( Vertex ) + 6 * sizeof( GLuint ) + 3 * ( sizeof( IndexedVert ) + sizeof( unsigned int ) );
+	maxBatchVertices = std::clamp<std::size_t>( maxBatchVertices, 3, memoryBudget / 8 / BATCH_BYTES_PER_VERTEX );
+	const std::size_t maxBatchIndices = 6 * maxBatchVertices;
+
+	Mesh batch;
+	batch.vertexArray.reserve( maxBatchVertices );
+	batch.indexArray.reserve( maxBatchIndices );
+	FlatIndexMap<IndexedVert, IndexedVertHash> vertexIndices( maxBatchVertices );
+	GLuint baseVertex = 0;
+
+	auto flushBatch = [ & ]()
+	{
+		if ( batch.indexArray.empty() ) return;
+
+		onBatch( batch, baseVertex );
+
+		baseVertex += static_cast<GLuint>( batch.vertexArray.size() );
+		batch.vertexArray.clear();
+		batch.indexArray.clear();
+		vertexIndices.Clear();
+	};
+
+	std::vector<char> window( stats.windowBytes );
+
+	// The triangulation needs random access to the positions, so the ones used by the faces of a window are gathered first
+	std::vector<glm::vec3> windowPositions;
+	std::vector<uint32_t>  windowPositionIds; // global index of windowPositions[ i ]
+
+	// everything but the parsed window, which is passed in
+	auto trackMemory = [ & ]( const std::size_t chunkBytes )
+	{
+		const std::size_t bytes = capacityBytes( window ) + chunkBytes + capacityBytes( windowPositions ) + capacityBytes( windowPositionIds )
+								+ capacityBytes( batch.vertexArray ) + capacityBytes( batch.indexArray ) + vertexIndices.MemoryBytes()
+								+ positions.MemoryBytes() + normals.MemoryBytes() + texcoords.MemoryBytes();
+		stats.peakBytes = std::max( stats.peakBytes, bytes );
+	};
+
+	std::size_t carriedSize = 0; // incomplete last line of the previous window
+	uint32_t computedNormalOffset = 0;
+	bool endOfFile = false;
+
+	while ( !endOfFile )
+	{
+		objFileStrm.read( window.data() + carriedSize, static_cast<std::streamsize>( window.size() - carriedSize ) );
+		const std::size_t filledSize = carriedSize + static_cast<std::size_t>( objFileStrm.gcount() );
+		endOfFile = !objFileStrm;
+		stats.fileBytes += filledSize - carriedSize;
+
+		// only complete lines are parsed, the rest is carried over to the next window
+		std::size_t linesSize = filledSize;
+		if ( !endOfFile )
+		{
+			while ( linesSize > 0 && window[ linesSize - 1 ] != '\n' ) --linesSize;
+
+			// the window does not grow, that would break the budget
+			if ( linesSize == 0 ) throw(EXC_LINETOOLONG);
+		}
+
+		ParsedChunk chunk;
+		chunk.dataBegin = window.data();
+		chunk.dataEnd = window.data() + linesSize;
+
+		ParseChunk( chunk );
+
+		trackMemory( capacityBytes( chunk.positions ) + capacityBytes( chunk.normals ) + capacityBytes( chunk.texcoords )
+					 + capacityBytes( chunk.faces ) + capacityBytes( chunk.faceVerts ) );
+
+		for ( const glm::vec3& position : chunk.positions ) positions.PushBack( position );
+		for ( const glm::vec3& normal : chunk.normals ) normals.PushBack( normal );
+		for ( const glm::vec2& texcoord : chunk.texcoords ) texcoords.PushBack( texcoord );
+		chunk.positions = std::vector<glm::vec3>();
+		chunk.normals = std::vector<glm::vec3>();
+		chunk.texcoords = std::vector<glm::vec2>();
+
+		const std::size_t faceBytes = capacityBytes( chunk.faces ) + capacityBytes( chunk.faceVerts );
+
+		windowPositions.clear();
+		windowPositionIds.clear();
+		{
+			FlatIndexMap<uint32_t, PositionIndexHash> windowPositionIndices( std::min( chunk.faceVerts.size(), positions.Size() ) );
+
+			for ( IndexedVert& vertex : chunk.faceVerts )
+			{
+				if ( vertex.v >= positions.Size() ) // stays out of range, the face is dropped by TriangulateChunk
+				{
+					vertex.v = ~0u;
+					continue;
+				}
+
+				unsigned int& localIndex = windowPositionIndices[ vertex.v ];
+				if ( localIndex == 0 )
+				{
+					windowPositions.push_back( positions.At( vertex.v ) );
+					windowPositionIds.push_back( vertex.v );
+					localIndex = static_cast<unsigned int>( windowPositions.size() );
+				}
+				vertex.v = localIndex - 1;
+			}
+
+			trackMemory( faceBytes + windowPositionIndices.MemoryBytes() );
+		}
+
+		// without any vt the texcoord is zero, see below
+		TriangulateChunk( chunk, windowPositions, normals.Size(), std::max<std::size_t>( texcoords.Size(), 1 ) );
+		stats.invalidFaces += chunk.invalidFaces;
+
+		// the raw faces were released by TriangulateChunk, but they were alive next to its output
+		trackMemory( faceBytes + capacityBytes( chunk.triVerts ) + capacityBytes( chunk.computedNormals ) + capacityBytes( chunk.triMaterialSlots ) );
+
+		for ( std::size_t i = 0; i < chunk.triVerts.size(); i += 3 )
+		{
+			// a triangle never straddles two batches
+			if ( batch.vertexArray.size() + 3 > maxBatchVertices || batch.indexArray.size() + 3 > maxBatchIndices ) flushBatch();
+
+			for ( std::size_t corner = i; corner < i + 3; ++corner )
+			{
+				IndexedVert vertex = chunk.triVerts[ corner ];
+				const uint32_t localPositionIdx = vertex.v;
+				vertex.v = windowPositionIds[ localPositionIdx ];
+
+				const bool hasComputedNormal = ( vertex.vn & COMPUTED_NORMAL_FLAG ) != 0;
+				const uint32_t localNormalIdx = vertex.vn & ~COMPUTED_NORMAL_FLAG;
+				if ( hasComputedNormal ) vertex.vn = COMPUTED_NORMAL_FLAG | ( computedNormalOffset + localNormalIdx );
+
+				unsigned int& vIndex = vertexIndices[ vertex ];
+				if ( vIndex == 0 ) // new vertex in this batch
+				{
+					Vertex v;
+					v.position = windowPositions[ localPositionIdx ];
+					v.texcoord = texcoords.Size() == 0 ? glm::vec2( 0.0f ) : texcoords.At( vertex.vt );
+					v.normal = hasComputedNormal ? chunk.computedNormals[ localNormalIdx ] : normals.At( vertex.vn );
+
+					batch.vertexArray.push_back( v );
+					vIndex = static_cast<unsigned int>( batch.vertexArray.size() );
+				}
+				batch.indexArray.push_back( vIndex - 1 );
+			}
+		}
+
+		computedNormalOffset += static_cast<uint32_t>( chunk.computedNormals.size() );
+
+		carriedSize = filledSize - linesSize;
+		std::memmove( window.data(), window.data() + linesSize, carriedSize );
+	}
+
+	flushBatch();
+
+	stats.cacheBytes = positions.MemoryBytes() + normals.MemoryBytes() + texcoords.MemoryBytes();
+	stats.spilledBytes = positions.SpilledBytes() + normals.SpilledBytes() + texcoords.SpilledBytes();
+	stats.maxBatchVertices = maxBatchVertices;
+
+	return stats;
+}
+
+std::vector<ObjParser::Material> ObjParser::parseMtl( const std::filesystem::path& fileName )
+{
+	std::vector<Material> materials;
+
+	MappedFile mtlFile( fileName, MappedFile::AccessHint::Sequential );
+
+	if ( !mtlFile ) throw(EXC_FILENOTFOUND);
 
 	InMemoryTokenizer tokenizer;
+	tokenizer.SetData( mtlFile.Data(), mtlFile.Size() );
 
-	tokenizer.SetData( objRawData.data(), fileSize );
+	while ( tokenizer )
+	{
+		std::string_view token = tokenizer.NextToken();
 
-	unsigned int nIndexedVerts = 0;
+		if ( token.empty() ) break; // only whitespace was left
+
+		if ( token == "newmtl" ) // newmtl <material name>
+		{
+			materials.emplace_back();
+			materials.back().name = std::string( tokenizer.NextToken( true ) );
+		}
+		else if ( !materials.empty() ) // statements before the first newmtl are ignored
+		{
+			Material& material = materials.back();
+
+			if ( token == "Ka" )      tokenizer.NextFloats( glm::value_ptr( material.Ka ), 3 ); // Ka <r> <g> <b>
+			else if ( token == "Kd" ) tokenizer.NextFloats( glm::value_ptr( material.Kd ), 3 ); // Kd <r> <g> <b>
+			else if ( token == "Ks" ) tokenizer.NextFloats( glm::value_ptr( material.Ks ), 3 ); // Ks <r> <g> <b>
+			else if ( token == "Ns" ) tokenizer.NextFloats( &material.Ns, 1 ); // Ns <exponent>
+			else if ( token == "d" )  tokenizer.NextFloats( &material.d, 1 ); // d <opacity>
+			else if ( token == "Tr" ) // Tr <transparency>
+			{
+				float transparency = 0.0f;
+				tokenizer.NextFloats( &transparency, 1 );
+				material.d = 1.0f - transparency;
+			}
+			else if ( token == "map_Kd" ) // map_Kd [<options>] <file>, the file name is the last token
+			{
+				std::string_view mapFile;
+				for ( std::string_view mapT = tokenizer.NextToken( true ); !mapT.empty(); mapT = tokenizer.NextToken( true ) )
+					mapFile = mapT;
+
+				if ( !mapFile.empty() ) material.diffuseMap = fileName.parent_path() / std::filesystem::path( mapFile );
+			}
+		}
+
+		tokenizer.ToNextLine();
+	}
+
+	return materials;
+}
+
+std::vector<ObjParser::Material> ObjParser::loadMaterials( const std::filesystem::path& objFileName,
+														   const std::vector<std::string>& materialLibraries,
+														   const std::vector<std::string>& materialNames )
+{
+	std::vector<Material> libraryMaterials;
+	for ( const std::string& library : materialLibraries )
+	{
+		try
+		{
+			std::vector<Material> materials = parseMtl( objFileName.parent_path() / library );
+			libraryMaterials.insert( libraryMaterials.end(), materials.begin(), materials.end() );
+		}
+		catch ( Exception ) {} // a missing library only means default materials
+	}
+
+	std::vector<Material> materials( materialNames.size() );
+	for ( std::size_t i = 0; i < materialNames.size(); ++i )
+	{
+		auto it = std::find_if( libraryMaterials.cbegin(), libraryMaterials.cend(),
+								[ &name = materialNames[ i ] ]( const Material& material ) { return material.name == name; } );
+
+		if ( it != libraryMaterials.cend() )
+			materials[ i ] = *it;
+		else
+			materials[ i ].name = materialNames[ i ];
+	}
+
+	return materials;
+}
+
+void ObjParser::ParseChunk( ParsedChunk& chunk )
+{
+	InMemoryTokenizer tokenizer;
+
+	tokenizer.SetData( chunk.dataBegin, static_cast<std::size_t>( chunk.dataEnd - chunk.dataBegin ) );
+
+	uint32_t materialSlot = INHERITED_MATERIAL_SLOT;
 
 	while ( tokenizer )
 	{
 		std::string_view token = tokenizer.NextToken();
 
+		if ( token.empty() ) break; // only whitespace was left
+
 		if ( token[ 0 ] == '#' )
 		{
 			tokenizer.ToNextLine();
 			continue;
 		}
 
-		switch ( *reinterpret_cast<const unsigned short*>( token.data() ) )
+		// The mapped view ends exactly at the end of the file, so we must not read past the token.
+		// A single character token is always followed by a separator (or the end of the file).
+		switch ( From2Char( token[ 0 ], token.size() > 1 ? token[ 1 ] : ' ' ) )
 		{
-			case From2Char('m','t'): //mtllib <.mtl file>
+			case From2Char('m','t'): //mtllib <.mtl file>+
 			{
-				auto mtlFile = tokenizer.NextToken();
+				for ( std::string_view mtlFile = tokenizer.NextToken( true ); !mtlFile.empty(); mtlFile = tokenizer.NextToken( true ) )
+				{
+					chunk.materialLibraries.emplace_back( mtlFile );
+				}
 			} break;
 
 			case From2Char('u','s'): // usemtl <material name>
 			{
-				auto mtlName = tokenizer.NextToken();
+				auto mtlName = tokenizer.NextToken( true );
+				chunk.materialNames.emplace_back( mtlName );
+				materialSlot = static_cast<uint32_t>( chunk.materialNames.size() - 1 );
 			}break;
 
 			case From2Char('o',' '):
@@ -141,23 +1072,18 @@ ObjParser::Mesh ObjParser::parse(const std::filesystem::path& fileName)
 			case From2Char('v',' '):
 			case From2Char('v','\t'): // v <x> <y> <z> [<w>]
 			{
-				positions.emplace_back(glm::vec3());
+				chunk.positions.emplace_back(glm::vec3());
 
-				float& x = positions.back().x;
-				float& y = positions.back().y;
-				float& z = positions.back().z;
+				float& x = chunk.positions.back().x;
+				float& y = chunk.positions.back().y;
+				float& z = chunk.positions.back().z;
 
-				std::string_view coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), x );
-				coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), y );
-				coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), z );
-				coordT = tokenizer.NextToken(true);
+				tokenizer.NextFloats( glm::value_ptr( chunk.positions.back() ), 3 );
+				std::string_view coordT = tokenizer.NextToken(true);
 
 				if ( !coordT.empty() )
 				{
-					float w;
+					float w = 1.0f;
 					std::from_chars( coordT.data(), coordT.data() + coordT.size(), w );
 					x /= w;
 					y /= w;
@@ -166,44 +1092,28 @@ ObjParser::Mesh ObjParser::parse(const std::filesystem::path& fileName)
 			}break;
 			case From2Char('v','n'): // vn <nx> <ny> <nz>
 			{
-				normals.emplace_back(glm::vec3());
-
-				float& x = normals.back().x;
-				float& y = normals.back().y;
-				float& z = normals.back().z;
-
-				std::string_view coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), x );
-				coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), y );
-				coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), z );
-				
+				chunk.normals.emplace_back(glm::vec3());
+
+				tokenizer.NextFloats( glm::value_ptr( chunk.normals.back() ), 3 );
 			}break;
 			case From2Char('v','t'): // vt <s> <t>
 			{
-				texcoords.emplace_back(glm::vec2());
-
-				float& s = texcoords.back().x;
-				float& t = texcoords.back().y;
+				chunk.texcoords.emplace_back(glm::vec2());
 
-				std::string_view coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), s );
-				coordT = tokenizer.NextToken();
-				std::from_chars( coordT.data(), coordT.data() + coordT.size(), t );
-	
+				tokenizer.NextFloats( glm::value_ptr( chunk.texcoords.back() ), 2 );
 			}break;
 			case From2Char('f',' '):
 			case From2Char('f','\t'): // f (<pi>[/<ti>][/<ni>])3+
 			{
-				face_vertIds.clear();
-				needsNormalComputation = false;
+				FaceRecord face;
+				face.firstVert = chunk.faceVerts.size();
+				face.materialSlot = materialSlot;
 
 				std::string_view faceVertT = tokenizer.NextToken( true );
 				while ( !faceVertT.empty() )
 				{
-					face_vertIds.emplace_back( IndexedVert{} );
-					IndexedVert& idxVert = face_vertIds.back();
+					chunk.faceVerts.emplace_back( IndexedVert{} );
+					IndexedVert& idxVert = chunk.faceVerts.back();
 
 					size_t posEndOffs = faceVertT.find_first_of( '/', 0 );
 					if ( posEndOffs == std::string_view::npos ) posEndOffs = faceVertT.size();
@@ -223,233 +1133,256 @@ ObjParser::Mesh ObjParser::parse(const std::filesystem::path& fileName)
 						std::from_chars( faceVertT.data() + normStartOffs, faceVertT.data() + faceVertT.size(), idxVert.vn );
 						idxVert.vn--;
 					}
-					else needsNormalComputation = true;
+					else face.needsNormalComputation = true;
 					
 					faceVertT = tokenizer.NextToken( true );
 				}
 
-				if ( 3 < face_vertIds.size() )
-				{
-					std::vector<IndexedVert> face_vertIdsFace2Tris;
-					if ( 4 == face_vertIds.size() )
-					{
-						glm::vec3 v10 = positions[ face_vertIds[ 0 ].v ] - positions[ face_vertIds[ 1 ].v ];
-						glm::vec3 v12 = positions[ face_vertIds[ 2 ].v ] - positions[ face_vertIds[ 1 ].v ];
+				face.vertCount = static_cast<unsigned int>( chunk.faceVerts.size() - face.firstVert );
+				if ( face.vertCount >= 3 )
+					chunk.faces.push_back( face );
+				else // degenerate face, drop it
+					chunk.faceVerts.resize( face.firstVert );
+			}break;
+		}
 
-						glm::vec3 v32 = positions[ face_vertIds[ 2 ].v ] - positions[ face_vertIds[ 3 ].v ];
-						glm::vec3 v30 = positions[ face_vertIds[ 0 ].v ] - positions[ face_vertIds[ 3 ].v ];
+		tokenizer.ToNextLine();
+	}
+}
 
-						float angle_012 = ::acosf( glm::dot(v10,v12) / sqrtf( glm::dot(v10,v10) * glm::dot(v12,v12) ) );
-						float angle_230 = ::acosf( glm::dot(v32,v30) / sqrtf( glm::dot(v32,v32) * glm::dot(v30,v30) ) );
-						
-						if ( ( angle_012 + angle_230 ) <= glm::pi<float>() )
-						{
-							face_vertIdsFace2Tris =
-							{ face_vertIds[ 0 ], face_vertIds[ 1 ], face_vertIds[ 2 ],
-							  face_vertIds[ 0 ], face_vertIds[ 2 ], face_vertIds[ 3 ] };
-						}
-						else
-						{
-							face_vertIdsFace2Tris =
-							{ face_vertIds[ 0 ], face_vertIds[ 1 ], face_vertIds[ 3 ],
-							  face_vertIds[ 1 ], face_vertIds[ 2 ], face_vertIds[ 3 ] };
-						}
-					}
-					else 
-					{
-						// Calculate the best fitting plane
-						glm::vec3 MidPoint( 0.0 );
-						for ( const auto& vertex : face_vertIds )
-						{
-							MidPoint += positions[ vertex.v ];
-						}
-						MidPoint /= float( face_vertIds.size() );
+void ObjParser::TriangulateChunk( ParsedChunk& chunk, const std::vector<glm::vec3>& positions, const std::size_t normalCount, const std::size_t texcoordCount )
+{
+	std::vector<IndexedVert> face_vertIds;
+	face_vertIds.reserve( 6 );
+
+	chunk.triVerts.reserve( chunk.faceVerts.size() + chunk.faces.size() );
+	chunk.triMaterialSlots.reserve( chunk.faceVerts.size() / 3 );
 
-						std::vector<glm::vec3> centeredPoints( face_vertIds.size() );
+	for ( const FaceRecord& face : chunk.faces )
+	{
+		face_vertIds.assign( chunk.faceVerts.cbegin() + face.firstVert, chunk.faceVerts.cbegin() + face.firstVert + face.vertCount );
 
-						std::transform( face_vertIds.cbegin(), face_vertIds.cend(), centeredPoints.begin(),
-										[&positions,MidPoint]( const IndexedVert& faceV )->glm::vec3
-										{ return positions[ faceV.v ] - MidPoint;}
-										);
+		// An index past the attributes read so far (or a relative one, they are not supported) drops the whole face.
+		// The normal indices do not matter if the normals are computed anyway.
+		const bool isValid = std::all_of( face_vertIds.cbegin(), face_vertIds.cend(), [ & ]( const IndexedVert& vertex )
+		{
+			return vertex.v < positions.size() && vertex.vt < texcoordCount && ( face.needsNormalComputation || vertex.vn < normalCount );
+		} );
+		if ( !isValid )
+		{
+			++chunk.invalidFaces;
+			continue;
+		}
 
-						float cov_xx = 0.0f, cov_xy = 0.0f;
-						float cov_yy = 0.0f, cov_yz = 0.0f;
-						float cov_xz = 0.0f, cov_zz = 0.0f;
+		if ( 3 < face_vertIds.size() )
+		{
+			TriangulateFace( face_vertIds, positions );
+		}
 
-						for ( const glm::vec3& centeredP : centeredPoints )
-						{
-							cov_xx += centeredP.x * centeredP.x;
-							cov_xy += centeredP.x * centeredP.y;
-							
-							cov_yy += centeredP.y * centeredP.y;
-							cov_yz += centeredP.y * centeredP.z;
-
-							cov_xz += centeredP.x * centeredP.z;
-							cov_zz += centeredP.z * centeredP.z;
-						}
-
-						// viktor-vad: Very strange, but the pca.hpp and pca.inc disappeared from glm/gtx.
-						// Did not find any explanation for this.
-						// Instead of some header file copy-hacking, I implemented a 3x3 verion of eigen decomposition.
-						// It was not intended, but most likely it is faster than the original glm pca, since that is a general method with Housholder and QR.
-						// https://dl.acm.org/doi/epdf/10.1145/355578.366316
-						// https://en.wikipedia.org/wiki/Eigenvalue_algorithm#2%C3%972_matrices
-						glm::vec3 eigenVectors[2];
-						{
-							glm::vec3 eigenVectors_[3];
-							float p1 = cov_xy * cov_xy + cov_xz * cov_xz + cov_yz * cov_yz;
-							float trC = cov_xx + cov_yy + cov_zz;
-							float eig1 = 0.0f, eig2 = 0.0f, eig3 = 0.0f;
-
-							// normal case
-							if ( p1 > 1e-15f )
-							{
-								float q = trC / 3.0f;
-								float p2 = ( cov_xx - q ) * ( cov_xx - q ) + ( cov_yy - q ) * ( cov_yy - q ) + ( cov_zz - q ) * ( cov_zz - q ) + 2.0f * p1;
-								float p = std::sqrt( p2 / 6.0f );
-
-								float cov_xx_q = cov_xx - q;
-								float cov_yy_q = cov_yy - q;
-								float cov_zz_q = cov_zz - q;
-
-								float r = glm::clamp( ( cov_xx_q * cov_yy_q * cov_zz_q + 2.0f * cov_xy * cov_yz * cov_xz - cov_xx_q * cov_yz * cov_yz - cov_yy_q * cov_xz * cov_xz - cov_zz_q * cov_xy * cov_xy ) / ( 2.0f * p * p * p ),
-													  -1.0f, 1.0f );
-
-								float phi = ::acosf( r ) / 3.0f;
-
-								eig1 = q + 2.0f * p * std::cos( phi );
-								eig2 = q + 2.0f * p * std::cos( phi + ( 2.0f * glm::pi<float>() / 3.0f ) );
-								eig3 = trC - eig1 - eig2;
-							}
-							else // covariance matrix is numericaly diagonal. We assume eigen values are the diagonal values.
-							{
-								eig1 = std::max( { cov_xx, cov_yy, cov_zz } );
-								eig3 = std::min( { cov_xx, cov_yy, cov_zz } );
-								eig2 = trC - eig1 - eig2;
-							}
-
-							eigenVectors_[ 0 ] = glm::vec3( cov_xy * cov_xy + cov_xz * cov_xz + ( cov_xx - eig2 ) * ( cov_xx - eig3 ),
-														   cov_xy * ( ( cov_xx - eig3 ) + ( cov_yy - eig2 ) ) + cov_xz * cov_yz,
-														   cov_xz * ( ( cov_xx - eig3 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_yz );
-
-							eigenVectors_[ 1 ] = glm::vec3( cov_xy * ( ( cov_xx - eig1 ) + ( cov_yy - eig3 ) ) + cov_xz * cov_yz,
-														   cov_yz * cov_yz + cov_xy * cov_xy + ( cov_yy - eig1 ) * ( cov_yy - eig3 ),
-														   cov_yz * ( ( cov_yy - eig3 ) + ( cov_zz - eig1 ) ) + cov_xy * cov_xz );
-
-							eigenVectors_[ 2 ] = glm::vec3( cov_xz * ( ( cov_xx - eig1 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_yz,
-														   cov_yz * ( ( cov_yy - eig1 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_xz,
-														   cov_yz * cov_yz + cov_xz * cov_xz + ( cov_zz - eig1 ) * ( cov_zz - eig2 ) );
-							
-							// Simplification of original method.
-							// We only need the first 2 eigen vectors for 2D projection.
-							// Therefor we are not intereted, which is bigger, but in leaving the smallest out.
-							float minEig = std::min( { eig1, eig2, eig3 } );
-
-							if ( eig3 == minEig )
-							{
-								eigenVectors[ 0 ] = glm::normalize( eigenVectors_[ 0 ] );
-								eigenVectors[ 1 ] = glm::normalize( eigenVectors_[ 1 ] );
-							}
-							else if ( eig2 == minEig )
-							{
+		if ( face.needsNormalComputation )
+		{
+			for ( int i = 0; i < face_vertIds.size(); i += 3 )
+			{
+				glm::vec3 n = glm::normalize( glm::cross(
+					positions[face_vertIds[i + 1].v] - positions[face_vertIds[i].v],
+					positions[face_vertIds[i + 2].v] - positions[face_vertIds[i].v]
+				) );
+
+				uint32_t n_idx = COMPUTED_NORMAL_FLAG | static_cast<uint32_t>( chunk.computedNormals.size() );
+				chunk.computedNormals.push_back( n );
+				face_vertIds[ i ].vn = face_vertIds[ i + 1 ].vn = face_vertIds[ i + 2 ].vn = n_idx;
+			}
+		}
+
+		chunk.triVerts.insert( chunk.triVerts.end(), face_vertIds.cbegin(), face_vertIds.cend() );
+		chunk.triMaterialSlots.insert( chunk.triMaterialSlots.end(), face_vertIds.size() / 3, face.materialSlot );
+	}
+
+	// the raw faces are not needed anymore
+	chunk.faces = std::vector<FaceRecord>();
+	chunk.faceVerts = std::vector<IndexedVert>();
+}
+
+void ObjParser::TriangulateFace( std::vector<IndexedVert>& face_vertIds, const std::vector<glm::vec3>& positions )
+{
+	std::vector<IndexedVert> face_vertIdsFace2Tris;
+	if ( 4 == face_vertIds.size() )
+	{
+		glm::vec3 v10 = positions[ face_vertIds[ 0 ].v ] - positions[ face_vertIds[ 1 ].v ];
+		glm::vec3 v12 = positions[ face_vertIds[ 2 ].v ] - positions[ face_vertIds[ 1 ].v ];
+
+		glm::vec3 v32 = positions[ face_vertIds[ 2 ].v ] - positions[ face_vertIds[ 3 ].v ];
+		glm::vec3 v30 = positions[ face_vertIds[ 0 ].v ] - positions[ face_vertIds[ 3 ].v ];
+
+		float angle_012 = ::acosf( glm::dot(v10,v12) / sqrtf( glm::dot(v10,v10) * glm::dot(v12,v12) ) );
+		float angle_230 = ::acosf( glm::dot(v32,v30) / sqrtf( glm::dot(v32,v32) * glm::dot(v30,v30) ) );
+		
+		if ( ( angle_012 + angle_230 ) <= glm::pi<float>() )
+		{
+			face_vertIdsFace2Tris =
+			{ face_vertIds[ 0 ], face_vertIds[ 1 ], face_vertIds[ 2 ],
+			  face_vertIds[ 0 ], face_vertIds[ 2 ], face_vertIds[ 3 ] };
+		}
+		else
+		{
+			face_vertIdsFace2Tris =
+			{ face_vertIds[ 0 ], face_vertIds[ 1 ], face_vertIds[ 3 ],
+			  face_vertIds[ 1 ], face_vertIds[ 2 ], face_vertIds[ 3 ] };
+		}
+	}
+	else 
+	{
+		// Calculate the best fitting plane
+		glm::vec3 MidPoint( 0.0 );
+		for ( const auto& vertex : face_vertIds )
+		{
+			MidPoint += positions[ vertex.v ];
+		}
+		MidPoint /= float( face_vertIds.size() );
+
+		std::vector<glm::vec3> centeredPoints( face_vertIds.size() );
+
+		std::transform( face_vertIds.cbegin(), face_vertIds.cend(), centeredPoints.begin(),
+						[&positions,MidPoint]( const IndexedVert& faceV )->glm::vec3
+						{ return positions[ faceV.v ] - MidPoint;}
+						);
+
+		float cov_xx = 0.0f, cov_xy = 0.0f;
+		float cov_yy = 0.0f, cov_yz = 0.0f;
+		float cov_xz = 0.0f, cov_zz = 0.0f;
+
+		for ( const glm::vec3& centeredP : centeredPoints )
+		{
+			cov_xx += centeredP.x * centeredP.x;
+			cov_xy += centeredP.x * centeredP.y;
+			
+			cov_yy += centeredP.y * centeredP.y;
+			cov_yz += centeredP.y * centeredP.z;
+
+			cov_xz += centeredP.x * centeredP.z;
+			cov_zz += centeredP.z * centeredP.z;
+		}
+
+		// viktor-vad: Very strange, but the pca.hpp and pca.inc disappeared from glm/gtx.
+		// Did not find any explanation for this.
+		// Instead of some header file copy-hacking, I implemented a 3x3 verion of eigen decomposition.
+		// It was not intended, but most likely it is faster than the original glm pca, since that is a general method with Housholder and QR.
+		// https://dl.acm.org/doi/epdf/10.1145/355578.366316
+		// https://en.wikipedia.org/wiki/Eigenvalue_algorithm#2%C3%972_matrices
+		glm::vec3 eigenVectors[2];
+		{
+			glm::vec3 eigenVectors_[3];
+			float p1 = cov_xy * cov_xy + cov_xz * cov_xz + cov_yz * cov_yz;
+			float trC = cov_xx + cov_yy + cov_zz;
+			float eig1 = 0.0f, eig2 = 0.0f, eig3 = 0.0f;
+
+			// normal case
+			if ( p1 > 1e-15f )
+			{
+				float q = trC / 3.0f;
+				float p2 = ( cov_xx - q ) * ( cov_xx - q ) + ( cov_yy - q ) * ( cov_yy - q ) + ( cov_zz - q ) * ( cov_zz - q ) + 2.0f * p1;
+				float p = std::sqrt( p2 / 6.0f );
+
+				float cov_xx_q = cov_xx - q;
+				float cov_yy_q = cov_yy - q;
+				float cov_zz_q = cov_zz - q;
+
+				float r = glm::clamp( ( cov_xx_q * cov_yy_q * cov_zz_q + 2.0f * cov_xy * cov_yz * cov_xz - cov_xx_q * cov_yz * cov_yz - cov_yy_q * cov_xz * cov_xz - cov_zz_q * cov_xy * cov_xy ) / ( 2.0f * p * p * p ),
+									  -1.0f, 1.0f );
+
+				float phi = ::acosf( r ) / 3.0f;
+
+				eig1 = q + 2.0f * p * std::cos( phi );
+				eig2 = q + 2.0f * p * std::cos( phi + ( 2.0f * glm::pi<float>() / 3.0f ) );
+				eig3 = trC - eig1 - eig2;
+			}
+			else // covariance matrix is numericaly diagonal. We assume eigen values are the diagonal values.
+			{
+				eig1 = std::max( { cov_xx, cov_yy, cov_zz } );
+				eig3 = std::min( { cov_xx, cov_yy, cov_zz } );
+				eig2 = trC - eig1 - eig2;
+			}
+
+			eigenVectors_[ 0 ] = glm::vec3( cov_xy * cov_xy + cov_xz * cov_xz + ( cov_xx - eig2 ) * ( cov_xx - eig3 ),
+										   cov_xy * ( ( cov_xx - eig3 ) + ( cov_yy - eig2 ) ) + cov_xz * cov_yz,
+										   cov_xz * ( ( cov_xx - eig3 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_yz );
+
+			eigenVectors_[ 1 ] = glm::vec3( cov_xy * ( ( cov_xx - eig1 ) + ( cov_yy - eig3 ) ) + cov_xz * cov_yz,
+										   cov_yz * cov_yz + cov_xy * cov_xy + ( cov_yy - eig1 ) * ( cov_yy - eig3 ),
+										   cov_yz * ( ( cov_yy - eig3 ) + ( cov_zz - eig1 ) ) + cov_xy * cov_xz );
+
+			eigenVectors_[ 2 ] = glm::vec3( cov_xz * ( ( cov_xx - eig1 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_yz,
+										   cov_yz * ( ( cov_yy - eig1 ) + ( cov_zz - eig2 ) ) + cov_xy * cov_xz,
+										   cov_yz * cov_yz + cov_xz * cov_xz + ( cov_zz - eig1 ) * ( cov_zz - eig2 ) );
+			
+			// Simplification of original method.
+			// We only need the first 2 eigen vectors for 2D projection.
+			// Therefor we are not intereted, which is bigger, but in leaving the smallest out.
+			float minEig = std::min( { eig1, eig2, eig3 } );
+
+			if ( eig3 == minEig )
+			{
+				eigenVectors[ 0 ] = glm::normalize( eigenVectors_[ 0 ] );
+				eigenVectors[ 1 ] = glm::normalize( eigenVectors_[ 1 ] );
+			}
+			else if ( eig2 == minEig )
+			{
                                 eigenVectors[ 0 ] = glm::normalize( eigenVectors_[ 0 ] );
                                 eigenVectors[ 1 ] = glm::normalize( eigenVectors_[ 2 ] );
                             }
-							else //if ( eig1 == minEig ) most unlikly case
-							{
+			else //if ( eig1 == minEig ) most unlikly case
+			{
                                 eigenVectors[ 0 ] = glm::normalize( eigenVectors_[ 1 ] );
                                 eigenVectors[ 1 ] = glm::normalize( eigenVectors_[ 2 ] );
                             }
-						}
-
-						std::vector<glm::vec2> facePointsProjected( face_vertIds.size() );
-						
-
-						std::transform(centeredPoints.cbegin(),centeredPoints.cend(),facePointsProjected.begin(),
-										[ &eigenVectors ]( const glm::vec3& cp )->glm::vec2
-										{
-											return glm::vec2(
-												glm::dot( cp, eigenVectors[0] ),
-												glm::dot( cp, eigenVectors[1] )
-											);
-										} );
-
-						// checking the orientation. CCW should be kept
-						float sum = 0.0;
-						for ( int i = 0; i < facePointsProjected.size() - 1; ++i )
-						{
-							sum += ( facePointsProjected[ i + 1 ].x - facePointsProjected[ i ].x ) *
-								( facePointsProjected[ i + 1 ].y + facePointsProjected[ i ].y );
-						}
-						sum += ( facePointsProjected.front().x - facePointsProjected.back().x ) *
-							( facePointsProjected.front().y + facePointsProjected.back().y );
-
-						if ( sum > 0.0f )
-						{
-							for ( int i = 0; i < facePointsProjected.size(); ++i )
-								facePointsProjected[ i ].y *= -1.0f;
-						}
-
-						std::vector<unsigned int> triIndices = triangulatePolygon( facePointsProjected );
-						
-						face_vertIdsFace2Tris.resize( triIndices.size() );
-						std::transform( triIndices.cbegin(), triIndices.cend(), face_vertIdsFace2Tris.begin(),
-										[ &face_vertIds ]( const unsigned int fTriId )->IndexedVert
-										{
-											return face_vertIds[ fTriId ];
-										} );
+		}
 
-					}
-					face_vertIds = std::move( face_vertIdsFace2Tris );
-				}
-				
-				if ( texcoords.empty() ) texcoords.emplace_back( glm::vec2( 0.0 ) );
-				
-				if ( needsNormalComputation )
-				{
-					for ( int i = 0; i < face_vertIds.size(); i += 3 )
-					{
-						glm::vec3 n = glm::normalize( glm::cross(
-							positions[face_vertIds[i + 1].v] - positions[face_vertIds[i].v],
-							positions[face_vertIds[i + 2].v] - positions[face_vertIds[i].v]
-						) );
-
-						unsigned int n_idx = static_cast<unsigned int>( normals.size() );
-						normals.push_back( n );
-						face_vertIds[ i ].vn = face_vertIds[ i + 1 ].vn = face_vertIds[ i + 2 ].vn = n_idx;
-					}
-				}
+		std::vector<glm::vec2> facePointsProjected( face_vertIds.size() );
+		
 
+		std::transform(centeredPoints.cbegin(),centeredPoints.cend(),facePointsProjected.begin(),
+						[ &eigenVectors ]( const glm::vec3& cp )->glm::vec2
+						{
+							return glm::vec2(
+								glm::dot( cp, eigenVectors[0] ),
+								glm::dot( cp, eigenVectors[1] )
+							);
+						} );
+
+		// checking the orientation. CCW should be kept
+		float sum = 0.0;
+		for ( int i = 0; i < facePointsProjected.size() - 1; ++i )
+		{
+			sum += ( facePointsProjected[ i + 1 ].x - facePointsProjected[ i ].x ) *
+				( facePointsProjected[ i + 1 ].y + facePointsProjected[ i ].y );
+		}
+		sum += ( facePointsProjected.front().x - facePointsProjected.back().x ) *
+			( facePointsProjected.front().y + facePointsProjected.back().y );
 
-				for ( const auto& vertex : face_vertIds )
-				{
-					unsigned int& vIndex = vertexIndices[ vertex ];
-					if (vIndex == 0) // new vertex
-					{
-						Vertex v;
-						v.position = positions[vertex.v];
-						v.texcoord = texcoords[vertex.vt];
-						v.normal = normals[vertex.vn];
-
-						resultMesh.vertexArray.push_back(v);
-						resultMesh.indexArray.push_back(nIndexedVerts++);
-						vIndex = nIndexedVerts;	
-					} else {
-						resultMesh.indexArray.push_back(vIndex-1);
-					}
-				}
-			}break;
+		if ( sum > 0.0f )
+		{
+			for ( int i = 0; i < facePointsProjected.size(); ++i )
+				facePointsProjected[ i ].y *= -1.0f;
 		}
 
-		tokenizer.ToNextLine();
-	}
+		std::vector<unsigned int> triIndices = triangulatePolygon( facePointsProjected );
+		
+		face_vertIdsFace2Tris.resize( triIndices.size() );
+		std::transform( triIndices.cbegin(), triIndices.cend(), face_vertIdsFace2Tris.begin(),
+						[ &face_vertIds ]( const unsigned int fTriId )->IndexedVert
+						{
+							return face_vertIds[ fTriId ];
+						} );
 
-	return resultMesh;
+	}
+	face_vertIds = std::move( face_vertIdsFace2Tris );
 }
 
+
 // Hash function for IndexedVert
 // version of fasthash64 https://github.com/ztanml/fast-hash
 // simplified for using only for 1 64 bit data (seed is the other one).
+// The position and texcoord indices form the data, the normal index is the seed.
 
 static inline constexpr uint64_t fasthash64_mix(uint64_t h)
 {
@@ -474,23 +1407,45 @@ static inline constexpr uint64_t fasthash64( uint64_t v, uint64_t seed )
 
 std::size_t ObjParser::IndexedVertHash::operator()( const IndexedVert& iv ) const noexcept
 {
-	return fasthash64( iv.vt, iv.vn_64 );
+	return fasthash64( ( static_cast<uint64_t>( iv.v ) << 32 ) | iv.vt, iv.vn );
 }
 
+// Hash of a directed polygon edge, the two vertex ids form the 64 bit key
+struct EdgeHash
+{
+	std::size_t operator()( const uint64_t edgeKey ) const noexcept
+	{
+		return fasthash64( edgeKey, 0 );
+	}
+};
+
+// Ear clipping, the ear with the smallest angle is cut first, followed by Delaunay flips around the new triangle.
+// The ears are kept in a priority queue and the triangles of the directed edges in a hash map,
+// so a polygon with n vertices is triangulated in O(n log n) instead of O(n^3).
 static std::vector<unsigned int> triangulatePolygon( const std::vector<glm::vec2>& polygon )
 {
 	constexpr float M_2PI = glm::two_pi<float>();
 	using Edge = std::array<unsigned int, 2>;
 
-	struct
+	struct Triangulation
 	{
 		std::vector<unsigned int> triIdxList;
-		
+		// directed edge -> 1 based triangle index, the entry is stale if the triangle was flipped since
+		FlatIndexMap<uint64_t, EdgeHash> edge2Tri;
+
+		explicit Triangulation( const std::size_t polygonSize ) : edge2Tri( polygonSize * 3 ) {}
+
+		static uint64_t EdgeKey( unsigned int i0, unsigned int i1 ) noexcept
+		{
+			return ( static_cast<uint64_t>( i0 ) << 32 ) | i1;
+		}
+
 		void AppendTriangle( unsigned int i0, unsigned int i1, unsigned int i2 )
 		{
 			triIdxList.push_back( i0 );
 			triIdxList.push_back( i1 );
 			triIdxList.push_back( i2 );
+			RegisterEdges( static_cast<unsigned int>( triIdxList.size() ) / 3 - 1 );
 		}
 
 		void SetTriangle( unsigned int triIdx, unsigned int i0, unsigned int i1, unsigned int i2 )
@@ -498,88 +1453,107 @@ static std::vector<unsigned int> triangulatePolygon( const std::vector<glm::vec2
 			triIdxList[ triIdx * 3    ] = i0;
 			triIdxList[ triIdx * 3 + 1] = i1;
 			triIdxList[ triIdx * 3 + 2] = i2;
+			RegisterEdges( triIdx );
+		}
+
+		void RegisterEdges( unsigned int triIdx )
+		{
+			for ( int k = 0; k < 3; ++k )
+			{
+				edge2Tri[ EdgeKey( triIdxList[ 3 * triIdx + k ], triIdxList[ 3 * triIdx + ( k + 1 ) % 3 ] ) ] = triIdx + 1;
+			}
 		}
 
 		bool findTri4Edge( const Edge& edge, unsigned int& triIdx, unsigned int& oppositeIdx ) const noexcept
 		{
-			for ( triIdx = static_cast<unsigned int>(triIdxList.size()) / 3 - 1;
-				  static_cast<int>( triIdx ) >= 0;
-				  triIdx-- ) // usually the neighbouring triangles are pushed later
+			const unsigned int triIdx1 = edge2Tri.Find( EdgeKey( edge[ 0 ], edge[ 1 ] ) );
+			if ( triIdx1 == 0 ) return false;
+
+			triIdx = triIdx1 - 1;
+			for ( int k = 0; k < 3; ++k )
 			{
-				if ( ( triIdxList[ 3 * triIdx ] == edge[ 0 ] ) && ( triIdxList[ 3 * triIdx + 1 ] == edge[ 1 ] ) )
+				if ( ( triIdxList[ 3 * triIdx + k ] == edge[ 0 ] ) && ( triIdxList[ 3 * triIdx + ( k + 1 ) % 3 ] == edge[ 1 ] ) )
 				{
-					oppositeIdx = triIdxList[ 3 * triIdx + 2 ];
-					return true;
-				}
-				if ( ( triIdxList[ 3 * triIdx + 1] == edge[ 0 ] ) && ( triIdxList[ 3 * triIdx + 2 ] == edge[ 1 ] ) )
-				{
-					oppositeIdx = triIdxList[ 3 * triIdx ];
-					return true;
-				}
-				if ( ( triIdxList[ 3 * triIdx + 2] == edge[ 0 ] ) && ( triIdxList[ 3 * triIdx ] == edge[ 1 ] ) )
-				{
-					oppositeIdx = triIdxList[ 3 * triIdx + 1 ];
+					oppositeIdx = triIdxList[ 3 * triIdx + ( k + 2 ) % 3 ];
 					return true;
 				}
 			}
 
+			// the triangle does not have this edge anymore
 			return false;
 		}
 
-	} triangulation;
+	} triangulation( polygon.size() );
 	triangulation.triIdxList.reserve( polygon.size() * 3 - 6 );
 
-	struct PolygonNode
+	// The remaining polygon is a doubly linked list over the vertex ids
+	const unsigned int nodeCount = static_cast<unsigned int>( polygon.size() );
+	std::vector<unsigned int> prevNode( nodeCount ), nextNode( nodeCount );
+	std::vector<float> nodeAngle( nodeCount );
+	std::vector<bool> nodeRemoved( nodeCount, false );
+
+	struct Ear
 	{
-		unsigned int id;
 		float angle;
-	};
-
-	std::vector<PolygonNode> polygonNodes( polygon.size() );
-	std::list< std::array<unsigned int, 2> > edges2check;
+		unsigned int id;
 
-	auto advNode = [ &polygonNodes ]( const size_t i,const long int di )->size_t
-	{
-		 return ( polygonNodes.size() + i + di ) % polygonNodes.size();
+		// std::priority_queue is a max heap, the smallest angle has to be on top.
+		// Equal angles are cut in vertex order.
+		bool operator<( const Ear& other ) const noexcept
+		{
+			return angle != other.angle ? angle > other.angle : id > other.id;
+		}
 	};
 
-	auto computeAngle = [ & ]( const size_t i )->void
+	// the angles of the neighbours change when an ear is cut, the outdated entries are skipped when popped
+	std::priority_queue<Ear> ears;
+	std::deque<Edge> edges2check;
+
+	auto computeAngle = [ & ]( const unsigned int i )->void
 	{
-		glm::vec2 prevP = polygon[ polygonNodes[advNode(i,-1)].id ];
-		glm::vec2     P = polygon[ polygonNodes[        i    ].id ];
-		glm::vec2 postP = polygon[ polygonNodes[advNode(i, 1)].id ];
+		glm::vec2 prevP = polygon[ prevNode[ i ] ];
+		glm::vec2     P = polygon[           i   ];
+		glm::vec2 postP = polygon[ nextNode[ i ] ];
 
 		float angle1 = atan2f( prevP.y - P.y, prevP.x - P.x );
 		float angle2 = atan2f( postP.y - P.y, postP.x - P.x );
 
-		polygonNodes[ i ].angle = angle1 - angle2;
-		if ( polygonNodes[ i ].angle < 0.0f )
+		nodeAngle[ i ] = angle1 - angle2;
+		if ( nodeAngle[ i ] < 0.0f )
 		{
-			polygonNodes[ i ].angle += M_2PI;
+			nodeAngle[ i ] += M_2PI;
+		}
+		else if ( std::isnan( nodeAngle[ i ] ) ) // NaN or infinite coordinates, cut it last; a NaN key would also break the heap order
+		{
+			nodeAngle[ i ] = M_2PI;
 		}
 
+		ears.push( { nodeAngle[ i ], i } );
 	};
 
-	for ( unsigned int i = 0; i < polygonNodes.size(); ++i )
+	for ( unsigned int i = 0; i < nodeCount; ++i )
 	{
-		polygonNodes[ i ].id = i;
+		prevNode[ i ] = ( i + nodeCount - 1 ) % nodeCount;
+		nextNode[ i ] = ( i + 1 ) % nodeCount;
 	}
-	for ( unsigned int i = 0; i < polygonNodes.size(); ++i )
+	for ( unsigned int i = 0; i < nodeCount; ++i )
 	{
 		computeAngle( i );
 	}
 
-	while ( polygonNodes.size() > 2 )
+	for ( unsigned int remainingCount = nodeCount; remainingCount > 2; --remainingCount )
 	{
-		unsigned int minAngleIdx = static_cast<unsigned int>( 
-			std::distance( polygonNodes.cbegin(), 
-						   std::min_element( polygonNodes.cbegin(), polygonNodes.cend(),
-						[]( const PolygonNode& n1, const PolygonNode& n2 ) { return n1.angle < n2.angle; } 
-						) ) );
+		Ear ear = ears.top();
+		ears.pop();
+		while ( nodeRemoved[ ear.id ] || nodeAngle[ ear.id ] != ear.angle )
+		{
+			ear = ears.top();
+			ears.pop();
+		}
 
-		const unsigned int i0 = polygonNodes[ advNode( minAngleIdx, -1 ) ].id;
-		const unsigned int i1 = polygonNodes[          minAngleIdx       ].id;
-		const unsigned int i2 = polygonNodes[ advNode( minAngleIdx,  1 ) ].id;
+		const unsigned int i0 = prevNode[ ear.id ];
+		const unsigned int i1 = ear.id;
+		const unsigned int i2 = nextNode[ ear.id ];
 
 		triangulation.AppendTriangle( i0, i1, i2 );
 
@@ -614,7 +1588,10 @@ static std::vector<unsigned int> triangulatePolygon( const std::vector<glm::vec2
 							 P2mP3.x, P2mP3.y, glm::dot( P2mP3, P2mP3 )
 				);
 
-				if ( glm::determinant( D ) > 0.0 )
+				// The points of a regular polygon are on one circle, the determinant is 0 up to rounding errors of either sign,
+				// so the same edges would be flipped back and forth forever. Only clearly non-Delaunay edges are flipped.
+				const float maxLength2 = std::max( { D[ 0 ][ 2 ], D[ 1 ][ 2 ], D[ 2 ][ 2 ] } );
+				if ( glm::determinant( D ) > 1e-5f * maxLength2 * maxLength2 )
 				{
 					triangulation.SetTriangle( leftTriIdx,  _idx0, _idx1, _idx3 );
 					triangulation.SetTriangle( rightTriIdx, _idx1, _idx2, _idx3 );
@@ -627,9 +1604,11 @@ static std::vector<unsigned int> triangulatePolygon( const std::vector<glm::vec2
 			}
 		}
 
-		polygonNodes.erase( polygonNodes.cbegin() + minAngleIdx );
-		computeAngle( advNode( minAngleIdx, -1 ) );
-		computeAngle( advNode( minAngleIdx,  0 ) );
+		nodeRemoved[ i1 ] = true;
+		nextNode[ i0 ] = i2;
+		prevNode[ i2 ] = i0;
+		computeAngle( i0 );
+		computeAngle( i2 );
 	}
 	return triangulation.triIdxList;
 }
\ No newline at end of file
@@ -3,11 +3,12 @@
 #include <filesystem>
 #include <fstream>
 #include <vector>
-#include <unordered_map>
+#include <string>
 #include <functional>
 
 #include "GLUtils.hpp"
 
+class ThreadPool;
 
 class ObjParser
 {
@@ -15,41 +16,142 @@ public:
 
 	typedef MeshObject<Vertex> Mesh;
 
-	static Mesh parse(const std::filesystem::path& fileName);
+	// threadCount: number of threads parsing the file in parallel (HARDWARE_THREADS = one per core).
+	// Small files are always parsed on the calling thread; the result does not depend on the thread count.
+	// Same as parseModel( fileName, threadCount ).mesh
+	static Mesh parse(const std::filesystem::path& fileName, unsigned int threadCount = 1);
 
-	enum Exception { EXC_FILENOTFOUND };
+	static constexpr unsigned int HARDWARE_THREADS = 0;
+
+	// Material read from an .mtl file (newmtl)
+	struct Material
+	{
+		std::string name;
+
+		glm::vec3 Ka = glm::vec3( 1.0f );
+		glm::vec3 Kd = glm::vec3( 1.0f );
+		glm::vec3 Ks = glm::vec3( 1.0f );
+		float     Ns = 1.0f; // shininess
+		float     d  = 1.0f; // opacity
+
+		std::filesystem::path diffuseMap; // map_Kd, relative to the working directory, empty if there is none
+	};
+
+	// Index range of the faces using one material
+	struct SubMesh
+	{
+		GLuint       indexOffset = 0;
+		GLuint       indexCount = 0;
+		unsigned int materialId = 0; // index into Model::materials
+	};
+
+	// Wall clock time of the phases of parseModel, for measuring the loader on real and synthetic files
+	struct ParseStats
+	{
+		std::size_t  fileBytes    = 0;
+		std::size_t  faceCorners  = 0; // vertices of the triangles before deduplication
+		std::size_t  invalidFaces = 0; // faces dropped, they refer to a v/vt/vn that does not exist
+		unsigned int threadCount  = 0; // chunks parsed in parallel
+
+		double tokenizeMs    = 0.0; // 1. chunks parsed
+		double mergeMs       = 0.0; // 2. attributes merged
+		double triangulateMs = 0.0; // 3. faces triangulated, normals computed
+		double dedupMs       = 0.0; // 4. vertices deduplicated
+		double groupMs       = 0.0; // 5. triangles grouped by material, materials loaded
+
+		double TotalMs() const noexcept { return tokenizeMs + mergeMs + triangulateMs + dedupMs + groupMs; }
+	};
+
+	// The faces are grouped by material (in the order of the first usemtl), so a model is drawn with one call per material.
+	// Faces before the first usemtl get a material with an empty name.
+	struct Model
+	{
+		Mesh mesh;
+		std::vector<SubMesh>     subMeshes;
+		std::vector<Material>    materials;
+		std::vector<std::string> materialLibraries; // mtllib files, relative to the OBJ file
+		ParseStats               stats;
+	};
+
+	// threadCount > 1 starts the workers for this parse only; a loader parsing several files should pass its ThreadPool instead
+	static Model parseModel( const std::filesystem::path& fileName, unsigned int threadCount = 1 );
+	// The large files are parsed in chunks on the workers of pool and on the calling thread (ThreadPool::ParallelFor),
+	// so a task of the same pool (e.g. an AssetLoader decode) may call it: the files loaded at once share the workers.
+	static Model parseModel( const std::filesystem::path& fileName, ThreadPool& pool );
+
+	// Parses OBJ text already in memory (e.g. generated by a benchmark, or the input of a fuzzer).
+	// No material library is read, the materials only get their names.
+	static Model parseMemory( const char* data, std::size_t size, unsigned int threadCount = 1 );
+	static Model parseMemory( const char* data, std::size_t size, ThreadPool& pool );
+
+	// Reads all materials of an .mtl file. Throws EXC_FILENOTFOUND.
+	static std::vector<Material> parseMtl( const std::filesystem::path& fileName );
+
+	// Materials of the given names from the libraries of an OBJ file.
+	// Missing libraries are skipped, names not found in any of them get the default material.
+	static std::vector<Material> loadMaterials( const std::filesystem::path& objFileName,
+												const std::vector<std::string>& materialLibraries,
+												const std::vector<std::string>& materialNames );
+
+	// Streaming import within a memory budget, for files that do not fit into memory (or into the memory one is willing to spend).
+	// The file is read in windows of memoryBudget / 64 bytes, a record may straddle two windows, but a line longer than the window
+	// throws EXC_LINETOOLONG. The triangles are handed over in batches of at most maxBatchVertices vertices as soon as they are complete.
+	// The indices of a batch are local to it, baseVertex is the number of vertices in the earlier batches,
+	// so a batch can go straight into a GPU buffer (e.g. drawn with glDrawElementsBaseVertex).
+	// Vertices are only deduplicated inside a batch; the triangles are the ones of parseModel, but in file order (not grouped by material).
+	//
+	// Memory: a quarter of the budget caches the v/vn/vt records, the ones that do not fit are spilled to a temporary file
+	// and read back when a face refers to them (throws EXC_TEMPFILE if that fails). Another eighth goes to the batch,
+	// maxBatchVertices is lowered to fit into it. The rest is left for the window and what is parsed from it.
+	// StreamStats::peakBytes is the largest total of these buffers (small temporaries of the n-gon triangulation are not counted).
+	using BatchCallback = std::function<void( const Mesh& batch, GLuint baseVertex )>;
+
+	struct StreamStats
+	{
+		std::size_t  memoryBudget     = 0; // after raising it to MIN_STREAM_BUDGET
+		std::size_t  fileBytes        = 0;
+		std::size_t  windowBytes      = 0;
+		std::size_t  cacheBytes       = 0; // attribute pages kept in memory
+		std::size_t  spilledBytes     = 0; // attribute pages written to the temporary file
+		std::size_t  peakBytes        = 0;
+		std::size_t  maxBatchVertices = 0; // after fitting it into the budget
+		std::size_t  invalidFaces     = 0;
+	};
+
+	static constexpr std::size_t MIN_STREAM_BUDGET = 64 << 10;
+
+	static StreamStats parseStream( const std::filesystem::path& fileName, const BatchCallback& onBatch,
+									std::size_t memoryBudget = 256 << 20, std::size_t maxBatchVertices = 1 << 16 );
+
+	// EXC_LINETOOLONG and EXC_TEMPFILE are only thrown by parseStream
+	enum Exception { EXC_FILENOTFOUND, EXC_LINETOOLONG, EXC_TEMPFILE };
 
 private:
 	struct IndexedVert
 	{
-		union
-		{
-			struct
-			{
-				uint32_t v,vt;
-			};
-			uint64_t v_vt = 0Ul;
-		}; 
-
-		union
-		{
-			struct
-			{
-				uint32_t dummy;
-				uint32_t vn;
-			};
-			uint64_t vn_64 = 0Ul;
-		}; 
-		
+		uint32_t v  = 0;
+		uint32_t vt = 0;
+		uint32_t vn = 0;
+
 		inline bool operator==( const IndexedVert& other ) const
 		{
-			return this->v_vt == other.v_vt && this->vn == other.vn;
+			return this->v == other.v && this->vt == other.vt && this->vn == other.vn;
 		}
-
 	};
 
 	struct IndexedVertHash
 	{
 		std::size_t operator()( const IndexedVert& iv ) const noexcept;
 	};
+
+	struct FaceRecord;
+	struct ParsedChunk;
+
+	// pool is null if the file is parsed on the calling thread
+	static Model ParseOnPool( const char* data, std::size_t size, ThreadPool* pool );
+	static void LoadMaterialsOf( const std::filesystem::path& fileName, Model& model );
+
+	static void ParseChunk( ParsedChunk& chunk );
+	static void TriangulateChunk( ParsedChunk& chunk, const std::vector<glm::vec3>& positions, std::size_t normalCount, std::size_t texcoordCount );
+	static void TriangulateFace( std::vector<IndexedVert>& face_vertIds, const std::vector<glm::vec3>& positions );
 };
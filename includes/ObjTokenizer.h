@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Whitespace tokenizer of ObjParser, directly on the text in memory (e.g. a mapped file), nothing is copied.
+// It never reads past the end of the data, so it can run on a view that ends exactly at the end of the file.
+class InMemoryTokenizer
+{
+public:
+	InMemoryTokenizer() = default;
+	void SetData( const char* ptr, size_t Length ) noexcept;
+	// The next whitespace separated token; empty at the end of the data, or at the end of the line if onlySameLine is set
+	std::string_view NextToken( bool onlySameLine = false ) noexcept;
+	// count numbers, each one the same as std::from_chars of the next token would give
+	void NextFloats( float* values, std::size_t count ) noexcept;
+	void ToNextLine() noexcept;
+	operator bool() const noexcept;
+private:
+	const char* currentPtr = nullptr;
+	const char* endPtr = nullptr;
+};
@@ -0,0 +1,213 @@
+#include "PixelPipeline.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Conversion between the 8 bit stored values and linear values in [0,1]
+struct ChannelTables
+{
+	std::array<float, 256> toLinear;
+	std::array<float, 255> midpoints; // halfway between the linear values of consecutive codes, for rounding back
+
+	// the code of the start of each bucket of linear values, Encode only has to step forward a few codes from there
+	static constexpr int ENCODE_BUCKETS = 4096;
+	std::array<std::uint8_t, ENCODE_BUCKETS> bucketCodes;
+
+	explicit ChannelTables( bool srgb )
+	{
+		for ( int code = 0; code < 256; ++code )
+		{
+			const float value = code / 255.0f;
+			if ( !srgb )
+				toLinear[ code ] = value;
+			else
+				toLinear[ code ] = ( value <= 0.04045f ) ? value / 12.92f : std::pow( ( value + 0.055f ) / 1.055f, 2.4f );
+		}
+		for ( int code = 0; code < 255; ++code ) midpoints[ code ] = 0.5f * ( toLinear[ code ] + toLinear[ code + 1 ] );
+
+		for ( int bucket = 0; bucket < ENCODE_BUCKETS; ++bucket )
+		{
+			const float bucketStart = static_cast<float>( bucket ) / ENCODE_BUCKETS;
+			bucketCodes[ bucket ] = static_cast<std::uint8_t>( std::upper_bound( midpoints.cbegin(), midpoints.cend(), bucketStart ) - midpoints.cbegin() );
+		}
+	}
+
+	// the code with the nearest linear value
+	std::uint8_t Encode( const float linear ) const noexcept
+	{
+		const int bucket = std::clamp( static_cast<int>( linear * ENCODE_BUCKETS ), 0, ENCODE_BUCKETS - 1 );
+
+		int code = bucketCodes[ bucket ];
+		while ( code < 255 && linear >= midpoints[ code ] ) ++code;
+		return static_cast<std::uint8_t>( code );
+	}
+};
+
+static const ChannelTables& channelTables( const bool srgb )
+{
+	static const ChannelTables linearTables( false );
+	static const ChannelTables srgbTables( true );
+	return srgb ? srgbTables : linearTables;
+}
+
+void PixelPipeline::CopyRows( ImageRGBA& image, const void* pixels, const int width, const int height, const int pitch, const bool flipVertically )
+{
+	image.width  = width;
+	image.height = height;
+	image.pixels.resize( static_cast<std::size_t>( width ) * height );
+
+	const std::size_t rowSize = static_cast<std::size_t>( width ) * sizeof( std::uint32_t );
+	for ( int y = 0; y < height; ++y )
+	{
+		const int sourceY = flipVertically ? height - 1 - y : y;
+		std::memcpy( image.pixels.data() + static_cast<std::size_t>( y ) * width, static_cast<const std::uint8_t*>( pixels ) + static_cast<std::ptrdiff_t>( sourceY ) * pitch, rowSize );
+	}
+}
+
+void PixelPipeline::PremultiplyAlpha( ImageRGBA& image )
+{
+	std::uint8_t* texel = reinterpret_cast<std::uint8_t*>( image.pixels.data() );
+	std::uint8_t* const end = texel + 4 * image.pixels.size();
+
+	for ( ; texel != end; texel += 4 )
+	{
+		const unsigned int alpha = texel[ 3 ];
+		for ( int channel = 0; channel < 3; ++channel )
+			texel[ channel ] = static_cast<std::uint8_t>( ( texel[ channel ] * alpha + 127 ) / 255 );
+	}
+}
+
+// Weighted sum of texels: the color channels in linear space, weighted by alpha, so fully transparent texels do not contribute their color
+struct TexelAccumulator
+{
+	float weightedColor[ 3 ] = {};
+	float color[ 3 ] = {};
+	float alpha = 0.0f;
+
+	void Add( const std::uint8_t* texel, const float weight, const ChannelTables& tables ) noexcept
+	{
+		const float texelAlpha = weight * texel[ 3 ] / 255.0f;
+		for ( int channel = 0; channel < 3; ++channel )
+		{
+			const float linear = tables.toLinear[ texel[ channel ] ];
+			weightedColor[ channel ] += texelAlpha * linear;
+			color[ channel ] += weight * linear;
+		}
+		alpha += texelAlpha;
+	}
+
+	// the weights have to sum to 1
+	void Store( std::uint8_t* texel, const ChannelTables& tables ) const noexcept
+	{
+		// fully transparent texels keep their plain average
+		for ( int channel = 0; channel < 3; ++channel )
+			texel[ channel ] = tables.Encode( alpha > 0.0f ? weightedColor[ channel ] / alpha : color[ channel ] );
+
+		texel[ 3 ] = static_cast<std::uint8_t>( std::lround( std::min( alpha, 1.0f ) * 255.0f ) );
+	}
+};
+
+static const std::uint8_t* texelAt( const ImageRGBA& image, const int x, const int y ) noexcept
+{
+	return reinterpret_cast<const std::uint8_t*>( image.pixels.data() + static_cast<std::size_t>( y ) * image.width + x );
+}
+
+// One level down: every texel is the average of a 2x2 block, the last row or column of an odd size is dropped
+static ImageRGBA downsample( const ImageRGBA& source, const ChannelTables& tables )
+{
+	ImageRGBA result;
+	result.width  = std::max( 1, source.width / 2 );
+	result.height = std::max( 1, source.height / 2 );
+	result.pixels.resize( static_cast<std::size_t>( result.width ) * result.height );
+
+	std::uint8_t* resultTexel = reinterpret_cast<std::uint8_t*>( result.pixels.data() );
+
+	for ( int y = 0; y < result.height; ++y )
+	{
+		const int rows[ 2 ] = { std::min( 2 * y, source.height - 1 ), std::min( 2 * y + 1, source.height - 1 ) };
+
+		for ( int x = 0; x < result.width; ++x, resultTexel += 4 )
+		{
+			const int columns[ 2 ] = { std::min( 2 * x, source.width - 1 ), std::min( 2 * x + 1, source.width - 1 ) };
+
+			TexelAccumulator accumulator;
+			for ( const int row : rows )
+			{
+				for ( const int column : columns ) accumulator.Add( texelAt( source, column, row ), 0.25f, tables );
+			}
+			accumulator.Store( resultTexel, tables );
+		}
+	}
+
+	return result;
+}
+
+// Bilinear filtering at the texel centers, edges clamped
+static ImageRGBA resampleBilinear( const ImageRGBA& source, const int width, const int height, const ChannelTables& tables )
+{
+	ImageRGBA result;
+	result.width  = width;
+	result.height = height;
+	result.pixels.resize( static_cast<std::size_t>( width ) * height );
+
+	const float scaleX = static_cast<float>( source.width ) / width;
+	const float scaleY = static_cast<float>( source.height ) / height;
+
+	std::uint8_t* resultTexel = reinterpret_cast<std::uint8_t*>( result.pixels.data() );
+
+	for ( int y = 0; y < height; ++y )
+	{
+		const float sourceY = std::clamp( ( y + 0.5f ) * scaleY - 0.5f, 0.0f, static_cast<float>( source.height - 1 ) );
+		const int y0 = static_cast<int>( sourceY );
+		const int y1 = std::min( y0 + 1, source.height - 1 );
+		const float fy = sourceY - y0;
+
+		for ( int x = 0; x < width; ++x, resultTexel += 4 )
+		{
+			const float sourceX = std::clamp( ( x + 0.5f ) * scaleX - 0.5f, 0.0f, static_cast<float>( source.width - 1 ) );
+			const int x0 = static_cast<int>( sourceX );
+			const int x1 = std::min( x0 + 1, source.width - 1 );
+			const float fx = sourceX - x0;
+
+			TexelAccumulator accumulator;
+			accumulator.Add( texelAt( source, x0, y0 ), ( 1.0f - fx ) * ( 1.0f - fy ), tables );
+			accumulator.Add( texelAt( source, x1, y0 ), fx * ( 1.0f - fy ), tables );
+			accumulator.Add( texelAt( source, x0, y1 ), ( 1.0f - fx ) * fy, tables );
+			accumulator.Add( texelAt( source, x1, y1 ), fx * fy, tables );
+			accumulator.Store( resultTexel, tables );
+		}
+	}
+
+	return result;
+}
+
+ImageRGBA PixelPipeline::Resample( ImageRGBA image, int width, int height, bool srgb )
+{
+	const ChannelTables& tables = channelTables( srgb );
+
+	// the box filter halves while the image is at least twice as large, so the bilinear filter never skips texels
+	while ( image.width >= 2 * width && image.height >= 2 * height ) image = downsample( image, tables );
+
+	if ( image.width == width && image.height == height ) return image;
+
+	return resampleBilinear( image, width, height, tables );
+}
+
+std::vector<ImageRGBA> PixelPipeline::BuildMipChain( ImageRGBA image, bool srgb )
+{
+	const ChannelTables& tables = channelTables( srgb );
+
+	std::vector<ImageRGBA> levels;
+	levels.push_back( std::move( image ) );
+
+	while ( levels.back().width > 1 || levels.back().height > 1 )
+	{
+		ImageRGBA nextLevel = downsample( levels.back(), tables );
+		levels.push_back( std::move( nextLevel ) );
+	}
+
+	return levels;
+}
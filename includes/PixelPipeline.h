@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "GLUtils.hpp"
+
+// CPU side processing of decoded images (ImageFromFile), no OpenGL calls, so it can run on any thread.
+// The pixels are 8 bit per channel, R, G, B, A in memory.
+class PixelPipeline
+{
+public:
+	// Copies width x height texels from rows of pitch bytes (e.g. the pixels of an SDL surface, the rows may be padded) into the image.
+	// flipVertically: the rows are copied in reverse order, SDL (0,0 top left) to OpenGL texture (0,0 bottom left) without a separate pass.
+	static void CopyRows( ImageRGBA& image, const void* pixels, int width, int height, int pitch, bool flipVertically );
+
+	// rgb *= a, for blending with GL_ONE, GL_ONE_MINUS_SRC_ALPHA: the filtered texels of transparent regions do not bleed their color
+	static void PremultiplyAlpha( ImageRGBA& image );
+
+	// Mip levels with a 2x2 box filter down to 1x1, levels[ 0 ] is the image itself.
+	// The color channels are averaged in linear space if srgb is set (glGenerateMipmap averages the stored sRGB values, which darkens),
+	// weighted by alpha, so fully transparent texels do not contribute their color.
+	// The input has to be straight (not premultiplied) alpha, premultiply the levels afterwards if needed.
+	static std::vector<ImageRGBA> BuildMipChain( ImageRGBA image, bool srgb = true );
+
+	// Resizes to width x height (e.g. to the common size of the layers of a texture array):
+	// halved with the same box filter while it is at least twice as large, then filtered bilinearly. Straight alpha, like BuildMipChain.
+	static ImageRGBA Resample( ImageRGBA image, int width, int height, bool srgb = true );
+};
@@ -0,0 +1,127 @@
+#include "ProgramCache.h"
+#include "CacheFile.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#include <SDL2/SDL.h>
+
+struct ProgramCacheHeader
+{
+	char     magic[ 4 ];
+	uint32_t version;
+	uint64_t key;
+	uint32_t binaryFormat;
+	uint32_t binaryLength;
+};
+
+static constexpr char BPROG_MAGIC[ 4 ] = { 'B', 'P', 'R', 'G' };
+
+static std::string glString( const GLenum name )
+{
+	const GLubyte* value = glGetString( name );
+	return value != nullptr ? reinterpret_cast<const char*>( value ) : std::string();
+}
+
+bool ProgramCache::IsSupported()
+{
+	GLint formatCount = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount );
+	return formatCount > 0;
+}
+
+uint64_t ProgramCache::KeyFor( const std::vector<std::string_view>& sources )
+{
+	// each part is '\0' terminated, so moving text between the parts changes the key
+	std::string keyText;
+	for ( const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION } ) keyText.append( glString( name ) ).push_back( '\0' );
+	for ( const std::string_view source : sources ) keyText.append( source ).push_back( '\0' );
+
+	return HashFileContent( keyText.data(), keyText.size() );
+}
+
+bool ProgramCache::Load( const GLuint programID, const std::filesystem::path& cacheFileName, uint64_t key )
+{
+	MappedFile cacheFile( cacheFileName, MappedFile::AccessHint::Sequential );
+	if ( !cacheFile || cacheFile.Size() < sizeof( ProgramCacheHeader ) ) return false;
+
+	ProgramCacheHeader header;
+	std::memcpy( &header, cacheFile.Data(), sizeof( header ) );
+
+	if ( std::memcmp( header.magic, BPROG_MAGIC, sizeof( BPROG_MAGIC ) ) != 0
+		 || header.version != VERSION
+		 || header.key != key
+		 || cacheFile.Size() != sizeof( header ) + header.binaryLength )
+	{
+		return false;
+	}
+
+	// a format the driver does not know would be a GL error, not just a failed link
+	GLint formatCount = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount );
+	std::vector<GLint> formats( formatCount );
+	if ( formatCount > 0 ) glGetIntegerv( GL_PROGRAM_BINARY_FORMATS, formats.data() );
+	if ( std::find( formats.cbegin(), formats.cend(), static_cast<GLint>( header.binaryFormat ) ) == formats.cend() ) return false;
+
+	glProgramBinary( programID, header.binaryFormat, cacheFile.Data() + sizeof( header ), static_cast<GLsizei>( header.binaryLength ) );
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv( programID, GL_LINK_STATUS, &linked );
+	if ( linked == GL_FALSE )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_INFO,
+						"[ProgramCache] The driver rejected %s, compiling again", cacheFileName.string().c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+bool ProgramCache::Store( const GLuint programID, const std::filesystem::path& cacheFileName, uint64_t key )
+{
+	GLint binaryLength = 0;
+	glGetProgramiv( programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength );
+	if ( binaryLength <= 0 ) return false;
+
+	std::vector<char> binary( binaryLength );
+	GLenum binaryFormat = 0;
+	glGetProgramBinary( programID, binaryLength, &binaryLength, &binaryFormat, binary.data() );
+	if ( binaryLength <= 0 ) return false;
+
+	ProgramCacheHeader header = {};
+	std::memcpy( header.magic, BPROG_MAGIC, sizeof( BPROG_MAGIC ) );
+	header.version      = VERSION;
+	header.key          = key;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = static_cast<uint32_t>( binaryLength );
+
+	return WriteFileAtomically( cacheFileName, [ & ]( std::ostream& cacheStrm )
+	{
+		cacheStrm.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+		cacheStrm.write( binary.data(), binaryLength );
+	} );
+}
+
+std::filesystem::path ProgramCache::CachePathFor( const std::filesystem::path& vsFileName, const std::filesystem::path& fsFileName,
+												 const std::vector<std::string>& defines )
+{
+	std::filesystem::path cacheFileName = vsFileName;
+	cacheFileName += ".";
+	cacheFileName += fsFileName.filename();
+
+	// each variant gets its own file, so they do not overwrite each other; "NAME value" becomes NAME_value
+	for ( const std::string& define : defines )
+	{
+		std::string part = "." + define;
+		std::replace_if( part.begin() + 1, part.end(), []( char c ) { return !std::isalnum( static_cast<unsigned char>( c ) ) && c != '_'; }, '_' );
+		cacheFileName += part;
+	}
+
+	cacheFileName += ".bprog";
+	return cacheFileName;
+}
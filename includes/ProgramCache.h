@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Binary cache of linked programs (glGetProgramBinary / glProgramBinary), one .bprog file per shader pair and set of defines.
+//
+// An entry is keyed by the hash of the preprocessed shader sources (includes and defines resolved) and of the driver (vendor, renderer, version),
+// so an edited shader or a driver update simply recompiles and overwrites the entry.
+// The driver may still reject a binary with a matching key; Load then fails and the caller compiles as usual.
+class ProgramCache
+{
+public:
+	// Whether the driver can save program binaries at all (GL_NUM_PROGRAM_BINARY_FORMATS)
+	static bool IsSupported();
+
+	static uint64_t KeyFor( const std::vector<std::string_view>& sources );
+
+	// Links programID from the cached binary. False if there is no entry with this key, or the driver rejected it.
+	static bool Load( const GLuint programID, const std::filesystem::path& cacheFileName, uint64_t key );
+
+	// Saves the binary of the linked programID, which has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	static bool Store( const GLuint programID, const std::filesystem::path& cacheFileName, uint64_t key );
+
+	// <vertex shader>.<fragment shader file name>[.<define>...].bprog
+	static std::filesystem::path CachePathFor( const std::filesystem::path& vsFileName, const std::filesystem::path& fsFileName,
+											   const std::vector<std::string>& defines = {} );
+
+	static constexpr uint32_t VERSION = 1;
+};
@@ -0,0 +1,321 @@
+#include "ShaderReloader.h"
+#include "GLUtils.hpp"
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <SDL2/SDL.h>
+
+static const char* const STAGE_NAMES[] = { "vertex", "fragment" };
+
+ShaderReloader::ShaderReloader()
+{
+	m_watcher.SetChangeHandler( [ this ]( const std::vector<std::filesystem::path>& changedFiles ) { PreprocessChanged( changedFiles ); } );
+}
+
+void ShaderReloader::Init()
+{
+#ifdef GL_KHR_parallel_shader_compile
+	m_parallelCompile = GLEW_KHR_parallel_shader_compile;
+	if ( m_parallelCompile ) glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF ); // as many as the driver likes
+#endif
+}
+
+void ShaderReloader::Clean()
+{
+	for ( ReloadedProgram& program : m_programs )
+	{
+		Abandon( program );
+		for ( GLuint& shaderID : program.shaderIDs )
+		{
+			glDeleteShader( shaderID );
+			shaderID = 0;
+		}
+	}
+	m_programs.clear();
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_programFiles.clear();
+	m_preprocessed.clear();
+}
+
+void ShaderReloader::Add( GLuint& programID, const std::filesystem::path& vsFileName, const std::filesystem::path& fsFileName,
+						  const std::vector<std::string>& defines, const std::vector<std::filesystem::path>& includeFileNames )
+{
+	const ProgramFiles files = { { vsFileName, fsFileName }, defines, includeFileNames };
+	m_programs.push_back( { programID, files } );
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_programFiles.push_back( files );
+	}
+
+	std::vector<std::filesystem::path> fileNames = includeFileNames;
+	fileNames.insert( fileNames.end(), { vsFileName, fsFileName } );
+	for ( const std::filesystem::path& fileName : fileNames )
+	{
+		if ( std::find( m_watchedFiles.cbegin(), m_watchedFiles.cend(), fileName ) != m_watchedFiles.cend() ) continue;
+
+		m_watchedFiles.push_back( fileName );
+		m_watcher.Watch( fileName );
+	}
+}
+
+void ShaderReloader::ReloadAll()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_forceReload = true;
+	}
+	m_watcher.ReportAll();
+}
+
+void ShaderReloader::PreprocessChanged( const std::vector<std::filesystem::path>& changedFiles )
+{
+	std::vector<ProgramFiles> programFiles;
+	bool force = false;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		programFiles = m_programFiles;
+		force = std::exchange( m_forceReload, false );
+	}
+
+	auto changed = [ &changedFiles ]( const std::filesystem::path& fileName )
+	{
+		return std::find( changedFiles.cbegin(), changedFiles.cend(), fileName ) != changedFiles.cend();
+	};
+
+	std::vector<PreprocessedProgram> preprocessed;
+	for ( std::size_t program = 0; program < programFiles.size(); ++program )
+	{
+		const ProgramFiles& files = programFiles[ program ];
+		if ( std::none_of( files.shaderFileNames.cbegin(), files.shaderFileNames.cend(), changed )
+			 && std::none_of( files.includeFileNames.cbegin(), files.includeFileNames.cend(), changed ) ) continue;
+
+		// both stages are read, the GL thread decides which one needs compiling; a file that cannot be read is logged by PreprocessShader
+		PreprocessedProgram sources;
+		sources.program = program;
+		sources.force = force;
+		if ( !PreprocessShader( sources.sources[ VERTEX_STAGE ], files.shaderFileNames[ VERTEX_STAGE ], files.defines )
+			 || !PreprocessShader( sources.sources[ FRAGMENT_STAGE ], files.shaderFileNames[ FRAGMENT_STAGE ], files.defines ) ) continue;
+
+		preprocessed.push_back( std::move( sources ) );
+	}
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	if ( programFiles.size() != m_programFiles.size() ) return; // Clean was called meanwhile
+	std::move( preprocessed.begin(), preprocessed.end(), std::back_inserter( m_preprocessed ) );
+}
+
+void ShaderReloader::Update()
+{
+	std::vector<PreprocessedProgram> preprocessed;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		preprocessed.swap( m_preprocessed );
+	}
+
+	for ( PreprocessedProgram& sources : preprocessed )
+	{
+		if ( sources.program < m_programs.size() ) Queue( m_programs[ sources.program ], sources );
+	}
+
+	// without parallel compiles a step blocks until the driver is done, so there is only one per frame
+	int blockingSteps = 1;
+	auto mayStep = [ this, &blockingSteps ]( const ReloadedProgram& program )
+	{
+		if ( m_parallelCompile ) return program.state == ReloadState::Queued || IsComplete( program );
+		return blockingSteps-- > 0;
+	};
+
+	for ( ReloadedProgram& program : m_programs )
+	{
+		if ( program.state == ReloadState::Idle || !mayStep( program ) ) continue;
+
+		switch ( program.state )
+		{
+		case ReloadState::Queued:
+			for ( const GLuint shaderID : program.pendingShaderIDs )
+			{
+				if ( shaderID != 0 ) glCompileShader( shaderID );
+			}
+			program.state = ReloadState::Compiling;
+			break;
+
+		case ReloadState::Compiling:
+			if ( !FinishCompile( program ) ) break;
+
+			program.pendingProgramID = glCreateProgram();
+			for ( int stage = 0; stage < STAGE_COUNT; ++stage )
+				glAttachShader( program.pendingProgramID, program.pendingShaderIDs[ stage ] != 0 ? program.pendingShaderIDs[ stage ] : program.shaderIDs[ stage ] );
+
+			if ( ProgramCache::IsSupported() ) glProgramParameteri( program.pendingProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+			glLinkProgram( program.pendingProgramID );
+			program.state = ReloadState::Linking;
+			break;
+
+		case ReloadState::Linking:
+			FinishLink( program );
+			break;
+
+		case ReloadState::Idle:
+			break;
+		}
+	}
+}
+
+void ShaderReloader::Queue( ReloadedProgram& program, PreprocessedProgram& preprocessed )
+{
+	// a newer save replaces the reload in progress; its stages are compared to the current shader objects,
+	// so a stage changed by the abandoned reload is compiled again
+	Abandon( program );
+
+	for ( int stage = 0; stage < STAGE_COUNT; ++stage )
+	{
+		std::string& source = preprocessed.sources[ stage ];
+		if ( !preprocessed.force && program.shaderIDs[ stage ] != 0 && source == program.sources[ stage ] ) continue;
+
+		const GLenum shaderType = ( stage == VERTEX_STAGE ) ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER;
+		const GLuint shaderID = glCreateShader( shaderType );
+		const char* sourcePointer = source.data();
+		const GLint sourceLength = static_cast<GLint>( source.size() );
+		glShaderSource( shaderID, 1, &sourcePointer, &sourceLength );
+
+		program.pendingShaderIDs[ stage ] = shaderID;
+		program.pendingSources[ stage ] = std::move( source );
+	}
+
+	const bool anyPending = std::any_of( program.pendingShaderIDs.cbegin(), program.pendingShaderIDs.cend(), []( const GLuint id ) { return id != 0; } );
+	program.state = anyPending ? ReloadState::Queued : ReloadState::Idle;
+}
+
+bool ShaderReloader::IsComplete( const ReloadedProgram& program ) const
+{
+#ifdef GL_KHR_parallel_shader_compile
+	GLint isComplete = GL_TRUE;
+	if ( program.state == ReloadState::Compiling )
+	{
+		for ( const GLuint shaderID : program.pendingShaderIDs )
+		{
+			if ( shaderID != 0 && isComplete ) glGetShaderiv( shaderID, GL_COMPLETION_STATUS_KHR, &isComplete );
+		}
+	}
+	else if ( program.state == ReloadState::Linking )
+	{
+		glGetProgramiv( program.pendingProgramID, GL_COMPLETION_STATUS_KHR, &isComplete );
+	}
+	return isComplete == GL_TRUE;
+#else
+	return true;
+#endif
+}
+
+// False (and the reload is dropped) if a stage did not compile
+bool ShaderReloader::FinishCompile( ReloadedProgram& program )
+{
+	for ( int stage = 0; stage < STAGE_COUNT; ++stage )
+	{
+		const GLuint shaderID = program.pendingShaderIDs[ stage ];
+		if ( shaderID == 0 ) continue;
+
+		GLint result = GL_FALSE;
+		GLint infoLogLength = 0;
+		glGetShaderiv( shaderID, GL_COMPILE_STATUS, &result );
+		glGetShaderiv( shaderID, GL_INFO_LOG_LENGTH, &infoLogLength );
+		if ( result == GL_TRUE && infoLogLength <= 1 ) continue;
+
+		std::string infoLog( std::max( infoLogLength, 1 ), '\0' );
+		glGetShaderInfoLog( shaderID, infoLogLength, nullptr, infoLog.data() );
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						result == GL_TRUE ? SDL_LOG_PRIORITY_WARN : SDL_LOG_PRIORITY_ERROR,
+						"[Shaders] %s (%s shader): %s", program.files.shaderFileNames[ stage ].string().c_str(),
+						STAGE_NAMES[ stage ], infoLog.c_str() );
+
+		if ( result != GL_TRUE )
+		{
+			SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+							SDL_LOG_PRIORITY_WARN,
+							"[Shaders] %s + %s did not compile, keeping the previous program",
+							program.files.shaderFileNames[ VERTEX_STAGE ].string().c_str(), program.files.shaderFileNames[ FRAGMENT_STAGE ].string().c_str() );
+			Abandon( program );
+			return false;
+		}
+	}
+	return true;
+}
+
+void ShaderReloader::FinishLink( ReloadedProgram& program )
+{
+	GLint result = GL_FALSE;
+	GLint infoLogLength = 0;
+	glGetProgramiv( program.pendingProgramID, GL_LINK_STATUS, &result );
+	glGetProgramiv( program.pendingProgramID, GL_INFO_LOG_LENGTH, &infoLogLength );
+
+	const std::string vsFileName = program.files.shaderFileNames[ VERTEX_STAGE ].string();
+	const std::string fsFileName = program.files.shaderFileNames[ FRAGMENT_STAGE ].string();
+
+	if ( result != GL_TRUE || infoLogLength > 1 )
+	{
+		std::string infoLog( std::max( infoLogLength, 1 ), '\0' );
+		glGetProgramInfoLog( program.pendingProgramID, infoLogLength, nullptr, infoLog.data() );
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						result == GL_TRUE ? SDL_LOG_PRIORITY_WARN : SDL_LOG_PRIORITY_ERROR,
+						"[Shaders] %s + %s: %s", vsFileName.c_str(), fsFileName.c_str(), infoLog.c_str() );
+	}
+
+	if ( result != GL_TRUE )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_WARN,
+						"[Shaders] %s + %s did not link, keeping the previous program", vsFileName.c_str(), fsFileName.c_str() );
+		Abandon( program );
+		return;
+	}
+
+	// the shader objects stay, the next reload attaches the unchanged one again
+	for ( int stage = 0; stage < STAGE_COUNT; ++stage )
+	{
+		const GLuint pendingShaderID = program.pendingShaderIDs[ stage ];
+		glDetachShader( program.pendingProgramID, pendingShaderID != 0 ? pendingShaderID : program.shaderIDs[ stage ] );
+		if ( pendingShaderID == 0 ) continue;
+
+		glDeleteShader( program.shaderIDs[ stage ] );
+		program.shaderIDs[ stage ] = pendingShaderID;
+		program.sources[ stage ] = std::move( program.pendingSources[ stage ] );
+		program.pendingShaderIDs[ stage ] = 0;
+	}
+
+	glDeleteProgram( program.programID );
+	program.programID = program.pendingProgramID;
+	program.pendingProgramID = 0;
+	program.state = ReloadState::Idle;
+
+	// the next start loads this binary instead of compiling
+	if ( ProgramCache::IsSupported() )
+	{
+		ProgramCache::Store( program.programID,
+							 ProgramCache::CachePathFor( program.files.shaderFileNames[ VERTEX_STAGE ], program.files.shaderFileNames[ FRAGMENT_STAGE ], program.files.defines ),
+							 ProgramCache::KeyFor( { program.sources[ VERTEX_STAGE ], program.sources[ FRAGMENT_STAGE ] } ) );
+	}
+
+	SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+					SDL_LOG_PRIORITY_INFO,
+					"[Shaders] Reloaded %s + %s", vsFileName.c_str(), fsFileName.c_str() );
+}
+
+void ShaderReloader::Abandon( ReloadedProgram& program )
+{
+	for ( int stage = 0; stage < STAGE_COUNT; ++stage )
+	{
+		glDeleteShader( program.pendingShaderIDs[ stage ] );
+		program.pendingShaderIDs[ stage ] = 0;
+		program.pendingSources[ stage ].clear();
+	}
+
+	glDeleteProgram( program.pendingProgramID );
+	program.pendingProgramID = 0;
+	program.state = ReloadState::Idle;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "FileWatcher.h"
+
+// Rebuilds shader programs when their files change, without stalling the frame that notices it.
+//
+// The watcher thread reads and preprocesses the sources of the programs using a changed file.
+// Update, on the GL thread, compiles only the stages whose preprocessed source differs from the one of their shader object,
+// and links them with the kept shader object of the other stage into a new program.
+// The old program is replaced only if the new one links, so a broken shader never gets drawn with.
+//
+// With GL_KHR_parallel_shader_compile the driver compiles and links in the background and Update only polls GL_COMPLETION_STATUS_KHR.
+// Without it every Update does a single (blocking) compile or link step, so a change used by many programs is spread over frames.
+// A stage gets its shader object on the first reload that needs it, because the programs are usually loaded
+// from the ProgramCache without compiling anything; from then on it is reused.
+class ShaderReloader
+{
+public:
+	ShaderReloader();
+
+	ShaderReloader( const ShaderReloader& ) = delete;
+	ShaderReloader& operator=( const ShaderReloader& ) = delete;
+
+	void Init();
+	// Deletes the shader objects and the unfinished programs, and forgets the added programs (they belong to the caller)
+	void Clean();
+
+	// programID is an already built program (see AssembleProgram), the reloaded programs are written into it.
+	// includeFileNames: the files included by the shaders, a change in them reloads the program too.
+	void Add( GLuint& programID, const std::filesystem::path& vsFileName, const std::filesystem::path& fsFileName,
+			  const std::vector<std::string>& defines, const std::vector<std::filesystem::path>& includeFileNames );
+
+	// Every stage of every program is compiled again, even if its source did not change
+	void ReloadAll();
+
+	// Starts and finishes compiles and links, once per frame on the GL thread
+	void Update();
+
+private:
+	enum Stage { VERTEX_STAGE, FRAGMENT_STAGE, STAGE_COUNT };
+
+	struct ProgramFiles
+	{
+		std::array<std::filesystem::path, STAGE_COUNT> shaderFileNames;
+		std::vector<std::string>                       defines;
+		std::vector<std::filesystem::path>             includeFileNames;
+	};
+
+	// Sources of a program read by the watcher thread
+	struct PreprocessedProgram
+	{
+		std::size_t                          program = 0;
+		std::array<std::string, STAGE_COUNT> sources;
+		bool                                 force = false;
+	};
+
+	enum class ReloadState { Idle, Queued, Compiling, Linking };
+
+	struct ReloadedProgram
+	{
+		GLuint&      programID;
+		ProgramFiles files;
+
+		std::array<GLuint, STAGE_COUNT>      shaderIDs{}; // 0 until a reload needs it
+		std::array<std::string, STAGE_COUNT> sources;     // of shaderIDs
+
+		// the reload in progress, pendingShaderIDs is 0 for a kept stage
+		ReloadState                          state = ReloadState::Idle;
+		std::array<GLuint, STAGE_COUNT>      pendingShaderIDs{};
+		std::array<std::string, STAGE_COUNT> pendingSources;
+		GLuint                               pendingProgramID = 0;
+	};
+
+	void PreprocessChanged( const std::vector<std::filesystem::path>& changedFiles ); // on the watcher thread
+
+	void Queue( ReloadedProgram& program, PreprocessedProgram& preprocessed );
+	bool IsComplete( const ReloadedProgram& program ) const;
+	bool FinishCompile( ReloadedProgram& program );
+	void FinishLink( ReloadedProgram& program );
+	void Abandon( ReloadedProgram& program );
+
+	std::vector<ReloadedProgram>       m_programs;     // GL thread only
+	std::vector<std::filesystem::path> m_watchedFiles; // GL thread only
+	bool                               m_parallelCompile = false;
+
+	std::mutex                       m_mutex; // guards the members below, the watcher thread uses them too
+	std::vector<ProgramFiles>        m_programFiles;
+	std::vector<PreprocessedProgram> m_preprocessed;
+	bool                             m_forceReload = false;
+
+	// declared last, so its thread stops before the members above go away
+	FileWatcher m_watcher;
+};
@@ -0,0 +1,179 @@
+#include "TextureCache.h"
+#include "CacheFile.h"
+#include "ContentHash.h"
+#include "PixelPipeline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <SDL2/SDL.h>
+
+struct TextureCache::Header
+{
+	char     magic[ 4 ];
+	uint32_t version;
+
+	CacheSource source;
+
+	uint32_t options; // OPTION_* bits
+	uint32_t resampleWidth;  // Options::width
+	uint32_t resampleHeight; // Options::height
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+};
+
+static constexpr char BTEX_MAGIC[ 4 ] = { 'B', 'T', 'E', 'X' };
+
+static constexpr uint32_t OPTION_FLIP_VERTICALLY   = 1u << 0;
+static constexpr uint32_t OPTION_MIPMAPS           = 1u << 1;
+static constexpr uint32_t OPTION_PREMULTIPLY_ALPHA = 1u << 2;
+
+static uint32_t optionBits( const TextureCache::Options& options ) noexcept
+{
+	return ( options.flipVertically ? OPTION_FLIP_VERTICALLY : 0u )
+		 | ( options.mipMaps ? OPTION_MIPMAPS : 0u )
+		 | ( options.premultiplyAlpha ? OPTION_PREMULTIPLY_ALPHA : 0u );
+}
+
+// Each level is half the previous one (rounded down, at least 1), like glTexStorage2D expects
+static int levelSize( const uint32_t baseSize, const uint32_t level ) noexcept
+{
+	return static_cast<int>( std::max<uint32_t>( 1u, baseSize >> level ) );
+}
+
+std::filesystem::path TextureCache::CachePathFor( const std::filesystem::path& imageFileName, const Options& options )
+{
+	// each set of options gets its own file, so e.g. a cube map face and a texture of the same image do not overwrite each other:
+	// f(lipped), m(ipmapped), p(remultiplied) and the resampled size, like box.png.fm256x256.btex, or 0 for none of them
+	std::string tag = std::string( options.flipVertically ? "f" : "" ) + ( options.mipMaps ? "m" : "" ) + ( options.premultiplyAlpha ? "p" : "" );
+	if ( options.width != 0 || options.height != 0 ) tag += std::to_string( options.width ) + "x" + std::to_string( options.height );
+
+	std::filesystem::path cacheFileName = imageFileName;
+	cacheFileName += "." + ( tag.empty() ? std::string( "0" ) : tag ) + ".btex";
+	return cacheFileName;
+}
+
+CachedTexture TextureCache::Load( const std::filesystem::path& imageFileName, const Options& options )
+{
+	CachedTexture result;
+
+	std::error_code ec;
+	const uint64_t sourceSize = std::filesystem::file_size( imageFileName, ec );
+	const int64_t sourceTime = ec ? 0 : static_cast<int64_t>( std::filesystem::last_write_time( imageFileName, ec ).time_since_epoch().count() );
+	const bool sourceExists = !ec;
+
+	const std::filesystem::path cacheFileName = CachePathFor( imageFileName, options );
+
+	auto computeSourceHash = [ & ]() -> uint64_t
+	{
+		MappedFile sourceFile( imageFileName, MappedFile::AccessHint::Sequential );
+		return sourceFile ? HashFileContent( sourceFile.Data(), sourceFile.Size() ) : 0;
+	};
+
+	//
+	// Try the cache first
+	//
+
+	if ( sourceExists && result.cacheFile.Open( cacheFileName, MappedFile::AccessHint::Sequential ) && result.cacheFile.Size() >= sizeof( Header ) )
+	{
+		Header header;
+		std::memcpy( &header, result.cacheFile.Data(), sizeof( Header ) );
+
+		std::size_t payloadSize = 0;
+		for ( uint32_t level = 0; level < header.levelCount; ++level )
+			payloadSize += std::size_t( levelSize( header.width, level ) ) * levelSize( header.height, level ) * sizeof( std::uint32_t );
+
+		const bool headerValid = std::memcmp( header.magic, BTEX_MAGIC, sizeof( BTEX_MAGIC ) ) == 0
+								 && header.version == VERSION
+								 && header.options == optionBits( options )
+								 && header.resampleWidth == static_cast<uint32_t>( options.width )
+								 && header.resampleHeight == static_cast<uint32_t>( options.height )
+								 && header.levelCount > 0 && header.levelCount <= 32
+								 && result.cacheFile.Size() == sizeof( Header ) + payloadSize;
+
+		if ( headerValid && IsSourceUnchanged( header.source, sourceSize, sourceTime, computeSourceHash ) )
+		{
+			const char* levelData = result.cacheFile.Data() + sizeof( Header );
+			for ( uint32_t level = 0; level < header.levelCount; ++level )
+			{
+				CachedTexture::Level cachedLevel;
+				cachedLevel.width  = levelSize( header.width, level );
+				cachedLevel.height = levelSize( header.height, level );
+				cachedLevel.pixels = reinterpret_cast<const std::uint32_t*>( levelData );
+				result.levels.push_back( cachedLevel );
+
+				levelData += std::size_t( cachedLevel.width ) * cachedLevel.height * sizeof( std::uint32_t );
+			}
+			result.loadedFromCache = true;
+
+			// only the time has changed: store the new one, so the next load does not hash the source again
+			if ( header.source.time != sourceTime )
+			{
+				header.source.time = sourceTime;
+				if ( !RewriteHeader( cacheFileName, header ) )
+				{
+					SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+									SDL_LOG_PRIORITY_WARN,
+									"[TextureCache] Could not update the header of %s", cacheFileName.string().c_str() );
+				}
+			}
+
+			return result;
+		}
+	}
+	result.cacheFile.Close();
+
+	//
+	// Stale or missing cache: decode the source and rebuild it
+	//
+
+	ImageRGBA image;
+	if ( !ImageFromFile( image, imageFileName, options.flipVertically ) ) return result;
+
+	if ( options.width > 0 && options.height > 0 ) image = PixelPipeline::Resample( std::move( image ), options.width, options.height );
+
+	if ( options.mipMaps )
+		result.ownedLevels = PixelPipeline::BuildMipChain( std::move( image ) );
+	else
+		result.ownedLevels.push_back( std::move( image ) );
+
+	if ( options.premultiplyAlpha )
+	{
+		for ( ImageRGBA& level : result.ownedLevels ) PixelPipeline::PremultiplyAlpha( level );
+	}
+
+	for ( const ImageRGBA& level : result.ownedLevels )
+		result.levels.push_back( { level.width, level.height, level.pixels.data() } );
+
+	Header header = {};
+	std::memcpy( header.magic, BTEX_MAGIC, sizeof( BTEX_MAGIC ) );
+	header.version        = VERSION;
+	header.source         = { sourceSize, sourceTime, computeSourceHash() };
+	header.options        = optionBits( options );
+	header.resampleWidth  = static_cast<uint32_t>( options.width );
+	header.resampleHeight = static_cast<uint32_t>( options.height );
+	header.width          = static_cast<uint32_t>( result.ownedLevels.front().width );
+	header.height         = static_cast<uint32_t>( result.ownedLevels.front().height );
+	header.levelCount     = static_cast<uint32_t>( result.ownedLevels.size() );
+
+	if ( !Write( cacheFileName, header, result.ownedLevels ) )
+	{
+		SDL_LogMessage( SDL_LOG_CATEGORY_APPLICATION,
+						SDL_LOG_PRIORITY_WARN,
+						"[TextureCache] Could not write %s", cacheFileName.string().c_str() );
+	}
+
+	return result;
+}
+
+bool TextureCache::Write( const std::filesystem::path& cacheFileName, const Header& header, const std::vector<ImageRGBA>& levels )
+{
+	return WriteFileAtomically( cacheFileName, [ & ]( std::ostream& cacheStrm )
+	{
+		cacheStrm.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+		for ( const ImageRGBA& level : levels )
+			cacheStrm.write( reinterpret_cast<const char*>( level.pixels.data() ), level.pixels.size() * sizeof( std::uint32_t ) );
+	} );
+}
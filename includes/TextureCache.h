@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "GLUtils.hpp"
+#include "MappedFile.h"
+
+// A texture loaded through the binary cache, levels[ 0 ] is the full size image.
+// The pixels are either in the mapped .btex file, or owned (when the cache had to be rebuilt).
+struct CachedTexture
+{
+	struct Level
+	{
+		int width  = 0;
+		int height = 0;
+		const std::uint32_t* pixels = nullptr; // 8 bit RGBA, no padding between the rows
+	};
+
+	std::vector<Level> levels; // empty if the image could not be loaded
+
+	bool loadedFromCache = false;
+
+	MappedFile             cacheFile;
+	std::vector<ImageRGBA> ownedLevels;
+};
+
+// Binary cache of decoded images (<asset>.<options>.btex next to the asset, one file per set of Options).
+//
+// The cache holds the pixels ready for upload: converted to RGBA, flipped, resampled, with the mip chain (PixelPipeline) and optionally
+// premultiplied alpha, so startup neither decodes the PNG/JPG nor builds the mipmaps.
+// It is keyed like MeshCache: by the size, modification time and content hash of the source, and by the Options.
+// When only the time differs and the content still matches, the new time is stored.
+class TextureCache
+{
+public:
+	struct Options
+	{
+		bool flipVertically   = true;  // OpenGL texture coordinates, not wanted for cube map faces
+		bool mipMaps          = true;  // full chain down to 1x1, PixelPipeline::BuildMipChain
+		bool premultiplyAlpha = false; // PixelPipeline::PremultiplyAlpha on every level
+		int  width            = 0;     // PixelPipeline::Resample to width x height before the mipmaps, 0: the size of the source
+		int  height           = 0;
+	};
+
+	// Loads the image from the cache, or decodes it and rebuilds the cache when it is stale. No OpenGL calls.
+	static CachedTexture Load( const std::filesystem::path& imageFileName, const Options& options );
+
+	static std::filesystem::path CachePathFor( const std::filesystem::path& imageFileName, const Options& options );
+
+	static constexpr uint32_t VERSION = 2;
+
+private:
+	struct Header;
+
+	static bool Write( const std::filesystem::path& cacheFileName, const Header& header, const std::vector<ImageRGBA>& levels );
+};
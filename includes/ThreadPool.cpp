@@ -0,0 +1,43 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool( unsigned int threadCount )
+{
+	if ( threadCount == HARDWARE_THREADS ) threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+
+	m_workers.reserve( threadCount );
+	for ( unsigned int i = 0; i < threadCount; ++i ) m_workers.emplace_back( &ThreadPool::WorkerLoop, this );
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopping = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for ( std::thread& worker : m_workers ) worker.join();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for ( ;; )
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_taskAvailable.wait( lock, [ this ]() { return m_stopping || !m_tasks.empty(); } );
+
+			// the queue is drained before stopping
+			if ( m_tasks.empty() ) return;
+
+			task = std::move( m_tasks.front() );
+			m_tasks.pop();
+		}
+
+		// the exceptions end up in the future of the task
+		task();
+	}
+}
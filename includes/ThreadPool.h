@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed number of worker threads running the submitted tasks in submission order.
+// The destructor finishes the tasks already submitted, then joins the workers.
+class ThreadPool
+{
+public:
+	static constexpr unsigned int HARDWARE_THREADS = 0; // one worker per core
+
+	explicit ThreadPool( unsigned int threadCount = HARDWARE_THREADS );
+	~ThreadPool();
+
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+
+	unsigned int ThreadCount() const noexcept { return static_cast<unsigned int>( m_workers.size() ); }
+
+	// The future holds the result, or the exception thrown by the task
+	template <typename F>
+	std::future<std::invoke_result_t<F>> Submit( F&& task );
+
+	// Calls func( i ) for every i in [ 0, count ) on the workers and on the calling thread, returns when all are done.
+	// The caller takes items too and only waits for the ones a worker has already started,
+	// so a task of this pool may call it without deadlock, even when every other worker is busy.
+	// The first exception thrown by func is rethrown, after the other items have finished.
+	template <typename F>
+	void ParallelFor( std::size_t count, F&& func );
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread>          m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex                        m_mutex;
+	std::condition_variable           m_taskAvailable;
+	bool                              m_stopping = false;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::Submit( F&& task )
+{
+	using ResultT = std::invoke_result_t<F>;
+
+	// std::function needs a copyable callable, the packaged_task is shared
+	auto packagedTask = std::make_shared<std::packaged_task<ResultT()>>( std::forward<F>( task ) );
+	std::future<ResultT> result = packagedTask->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_tasks.emplace( [ packagedTask ]() { ( *packagedTask )(); } );
+	}
+	m_taskAvailable.notify_one();
+
+	return result;
+}
+
+template <typename F>
+void ThreadPool::ParallelFor( const std::size_t count, F&& func )
+{
+	struct Shared
+	{
+		std::atomic<std::size_t> next{ 0 };
+		std::size_t              finished = 0;
+		std::exception_ptr       error;
+		std::mutex               mutex;
+		std::condition_variable  allFinished;
+	};
+	auto shared = std::make_shared<Shared>();
+
+	// func is only used for a claimed item, the caller is still waiting then
+	auto runItems = [ shared, count, &func ]()
+	{
+		for ( std::size_t i = shared->next++; i < count; i = shared->next++ )
+		{
+			std::exception_ptr error;
+			try
+			{
+				func( i );
+			}
+			catch ( ... )
+			{
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock( shared->mutex );
+			if ( error && !shared->error ) shared->error = error;
+			if ( ++shared->finished == count ) shared->allFinished.notify_all();
+		}
+	};
+
+	// a helper starting after the caller took the last item returns right away
+	const std::size_t helperCount = std::min<std::size_t>( count > 0 ? count - 1 : 0, m_workers.size() );
+	if ( helperCount > 0 )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			for ( std::size_t h = 0; h < helperCount; ++h ) m_tasks.emplace( runItems );
+		}
+		m_taskAvailable.notify_all();
+	}
+
+	runItems();
+
+	std::unique_lock<std::mutex> lock( shared->mutex );
+	shared->allFinished.wait( lock, [ &shared, count ]() { return shared->finished == count; } );
+	if ( shared->error ) std::rethrow_exception( shared->error );
+}
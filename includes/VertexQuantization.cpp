@@ -0,0 +1,165 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtx/transform.hpp>
+
+static constexpr float SNORM16_MAX = 32767.0f;
+
+// the same as the GPU does for normalized GL_SHORT attributes
+static inline float snorm16ToFloat( const int16_t value ) noexcept
+{
+	return std::max( static_cast<float>( value ) / SNORM16_MAX, -1.0f );
+}
+
+static inline int16_t floatToSnorm16( const float value ) noexcept
+{
+	return static_cast<int16_t>( std::round( glm::clamp( value, -1.0f, 1.0f ) * SNORM16_MAX ) );
+}
+
+QuantizedMesh VertexQuantization::QuantizeMesh( const MeshView<Vertex>& mesh )
+{
+	QuantizedMesh result;
+
+	glm::vec3 boundsMin( 0.0f ), boundsMax( 0.0f );
+	if ( mesh.vertexCount > 0 )
+	{
+		boundsMin = boundsMax = mesh.vertices[ 0 ].position;
+		for ( std::size_t i = 1; i < mesh.vertexCount; ++i )
+		{
+			boundsMin = glm::min( boundsMin, mesh.vertices[ i ].position );
+			boundsMax = glm::max( boundsMax, mesh.vertices[ i ].position );
+		}
+	}
+
+	result.center = ( boundsMin + boundsMax ) * 0.5f;
+	result.halfExtent = ( boundsMax - boundsMin ) * 0.5f;
+	// a flat axis has only the 0 coordinate, any scale keeps the matrix invertible
+	for ( int i = 0; i < 3; ++i )
+		if ( result.halfExtent[ i ] <= 0.0f ) result.halfExtent[ i ] = 1.0f;
+
+	result.dequantization = glm::translate( result.center ) * glm::scale( result.halfExtent );
+
+	result.mesh.vertexArray.resize( mesh.vertexCount );
+	for ( std::size_t i = 0; i < mesh.vertexCount; ++i )
+	{
+		const Vertex& vertex = mesh.vertices[ i ];
+		VertexQuantized& quantized = result.mesh.vertexArray[ i ];
+
+		EncodePosition( vertex.position, result.center, result.halfExtent, quantized.position );
+		quantized.position[ 3 ] = 0;
+		EncodeNormal( vertex.normal, quantized.normal );
+		EncodeTexcoord( vertex.texcoord, quantized.texcoord );
+	}
+
+	result.mesh.indexArray.assign( mesh.indices, mesh.indices + mesh.indexCount );
+
+	return result;
+}
+
+QuantizationError VertexQuantization::MeasureError( const MeshView<Vertex>& mesh, const QuantizedMesh& quantizedMesh )
+{
+	QuantizationError error;
+
+	for ( std::size_t i = 0; i < mesh.vertexCount; ++i )
+	{
+		const Vertex& vertex = mesh.vertices[ i ];
+		const VertexQuantized& quantized = quantizedMesh.mesh.vertexArray[ i ];
+
+		error.position = std::max( error.position, glm::distance( vertex.position, DecodePosition( quantized.position, quantizedMesh.center, quantizedMesh.halfExtent ) ) );
+
+		// from the chord length, acos of the dot product is not precise for small angles.
+		// A normal without a direction has nothing to compare with.
+		const float normalLength = glm::length( vertex.normal );
+		if ( normalLength > 0.0f && std::isfinite( normalLength ) )
+		{
+			const float chord = glm::distance( vertex.normal / normalLength, DecodeNormal( quantized.normal ) );
+			error.normalAngle = std::max( error.normalAngle, 2.0f * std::asin( std::min( chord * 0.5f, 1.0f ) ) );
+		}
+
+		const glm::vec2 texcoordDiff = glm::abs( vertex.texcoord - DecodeTexcoord( quantized.texcoord ) );
+		error.texcoord = std::max( { error.texcoord, texcoordDiff.x, texcoordDiff.y } );
+	}
+
+	return error;
+}
+
+void VertexQuantization::EncodePosition( const glm::vec3& position, const glm::vec3& center, const glm::vec3& halfExtent, int16_t encoded[ 3 ] )
+{
+	const glm::vec3 relative = ( position - center ) / halfExtent;
+	for ( int i = 0; i < 3; ++i ) encoded[ i ] = floatToSnorm16( relative[ i ] );
+}
+
+glm::vec3 VertexQuantization::DecodePosition( const int16_t encoded[ 3 ], const glm::vec3& center, const glm::vec3& halfExtent )
+{
+	return center + halfExtent * glm::vec3( snorm16ToFloat( encoded[ 0 ] ), snorm16ToFloat( encoded[ 1 ] ), snorm16ToFloat( encoded[ 2 ] ) );
+}
+
+void VertexQuantization::EncodeNormal( const glm::vec3& normal, int16_t encoded[ 2 ] )
+{
+	// a zero length (or NaN) normal has no direction, it gets +z instead of garbage
+	const float length1 = std::abs( normal.x ) + std::abs( normal.y ) + std::abs( normal.z );
+	if ( !( length1 > 0.0f ) || !std::isfinite( length1 ) )
+	{
+		encoded[ 0 ] = encoded[ 1 ] = 0;
+		return;
+	}
+
+	// project to the octahedron, then unfold the lower half onto the outer triangles of the square
+	const glm::vec3 n = normal / length1;
+	glm::vec2 oct( n.x, n.y );
+	if ( n.z < 0.0f )
+	{
+		oct = glm::vec2( ( 1.0f - std::abs( n.y ) ) * ( n.x >= 0.0f ? 1.0f : -1.0f ),
+						 ( 1.0f - std::abs( n.x ) ) * ( n.y >= 0.0f ? 1.0f : -1.0f ) );
+	}
+
+	const glm::vec3 unitNormal = n / glm::length( n );
+	float bestDistance = std::numeric_limits<float>::infinity();
+	for ( int i = 0; i < 4; ++i )
+	{
+		const float x = ( i & 1 ) ? std::ceil( oct.x * SNORM16_MAX ) : std::floor( oct.x * SNORM16_MAX );
+		const float y = ( i & 2 ) ? std::ceil( oct.y * SNORM16_MAX ) : std::floor( oct.y * SNORM16_MAX );
+		const int16_t candidate[ 2 ] =
+		{
+			static_cast<int16_t>( glm::clamp( x, -SNORM16_MAX, SNORM16_MAX ) ),
+			static_cast<int16_t>( glm::clamp( y, -SNORM16_MAX, SNORM16_MAX ) ),
+		};
+
+		// the first candidate is always taken, so encoded is set even if a distance is not a number
+		const float distance = glm::distance( unitNormal, DecodeNormal( candidate ) );
+		if ( i == 0 || distance < bestDistance )
+		{
+			bestDistance = distance;
+			encoded[ 0 ] = candidate[ 0 ];
+			encoded[ 1 ] = candidate[ 1 ];
+		}
+	}
+}
+
+// Must match OctDecode in Vert_PosNormTex.vert
+glm::vec3 VertexQuantization::DecodeNormal( const int16_t encoded[ 2 ] )
+{
+	const glm::vec2 oct( snorm16ToFloat( encoded[ 0 ] ), snorm16ToFloat( encoded[ 1 ] ) );
+
+	glm::vec3 n( oct.x, oct.y, 1.0f - std::abs( oct.x ) - std::abs( oct.y ) );
+	const float t = std::max( -n.z, 0.0f );
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	return glm::normalize( n );
+}
+
+void VertexQuantization::EncodeTexcoord( const glm::vec2& texcoord, uint16_t encoded[ 2 ] )
+{
+	encoded[ 0 ] = glm::packHalf1x16( texcoord.x );
+	encoded[ 1 ] = glm::packHalf1x16( texcoord.y );
+}
+
+glm::vec2 VertexQuantization::DecodeTexcoord( const uint16_t encoded[ 2 ] )
+{
+	return glm::vec2( glm::unpackHalf1x16( encoded[ 0 ] ), glm::unpackHalf1x16( encoded[ 1 ] ) );
+}
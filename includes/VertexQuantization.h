@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include <glm/glm.hpp>
+
+#include "GLUtils.hpp"
+
+// Compact version of Vertex, 16 bytes instead of 32.
+//
+// position: snorm16, relative to the bounding box of the mesh, the box is restored by QuantizedMesh::dequantization
+// normal:   octahedral encoding in 2 x snorm16 (https://jcgt.org/published/0003/02/01/), decoded in the vertex shader
+// texcoord: 2 x half float
+struct VertexQuantized
+{
+	int16_t  position[ 4 ]; // w is padding, keeps the normal 4 byte aligned
+	int16_t  normal[ 2 ];
+	uint16_t texcoord[ 2 ];
+};
+
+static_assert( sizeof( VertexQuantized ) == 16, "VertexQuantized is expected to be tightly packed" );
+
+// Attribute layout of VertexQuantized.
+// The octahedral normal goes to location 3, the shader decodes it when octNormals is set, location 1 stays unused.
+inline const std::initializer_list<VertexAttributeDescriptor> VERTEX_QUANTIZED_ATTRIBUTES =
+{
+	{ 0, offsetof( VertexQuantized, position ), 3, GL_SHORT,      GL_TRUE  },
+	{ 3, offsetof( VertexQuantized, normal   ), 2, GL_SHORT,      GL_TRUE  },
+	{ 2, offsetof( VertexQuantized, texcoord ), 2, GL_HALF_FLOAT, GL_FALSE },
+};
+
+struct QuantizedMesh
+{
+	MeshObject<VertexQuantized> mesh;
+
+	// the bounding box the positions are relative to
+	glm::vec3 center     = glm::vec3( 0.0f );
+	glm::vec3 halfExtent = glm::vec3( 1.0f );
+
+	// Maps the snorm16 positions back into the bounding box, the world matrix of the positions is world * dequantization.
+	// The normals are not affected by it, worldIT is still computed from world alone.
+	glm::mat4 dequantization = glm::mat4( 1.0f );
+};
+
+// Largest differences between a mesh and its quantized version (the "quantize" check of BomberApeBench tests these bounds).
+// Expected bounds: position half a step of the box (halfExtent / 32767 / 2 per axis),
+// normal about 0.005 degrees (normals without a direction are skipped), texcoord 2^-11 relative (half float rounding).
+struct QuantizationError
+{
+	float position = 0.0f;    // distance, in the units of the mesh
+	float normalAngle = 0.0f; // radians
+	float texcoord = 0.0f;    // per component
+};
+
+class VertexQuantization
+{
+public:
+	static QuantizedMesh QuantizeMesh( const MeshView<Vertex>& mesh );
+
+	static QuantizationError MeasureError( const MeshView<Vertex>& mesh, const QuantizedMesh& quantizedMesh );
+
+	// snorm16 encoding of a position in [boundsMin, boundsMax] and its inverse
+	static void  EncodePosition( const glm::vec3& position, const glm::vec3& center, const glm::vec3& halfExtent, int16_t encoded[ 3 ] );
+	static glm::vec3 DecodePosition( const int16_t encoded[ 3 ], const glm::vec3& center, const glm::vec3& halfExtent );
+
+	// Octahedral encoding of a unit vector. Of the 4 nearest snorm16 pairs the one decoding closest to the normal is chosen.
+	// The length does not matter, a zero length (or NaN) normal is encoded as +z.
+	static void  EncodeNormal( const glm::vec3& normal, int16_t encoded[ 2 ] );
+	static glm::vec3 DecodeNormal( const int16_t encoded[ 2 ] );
+
+	static void  EncodeTexcoord( const glm::vec2& texcoord, uint16_t encoded[ 2 ] );
+	static glm::vec2 DecodeTexcoord( const uint16_t encoded[ 2 ] );
+};
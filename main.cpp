@@ -44,8 +44,10 @@ int main( int argc, char* args[] )
 
 	// beállíthatjuk azt, hogy pontosan milyen OpenGL context-et szeretnénk létrehozni - ha nem tesszük, akkor
 	// automatikusan a legmagasabb elérhető verziójút kapjuk
-	//SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	//SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+	// 4.4 kell: a GeometryArena és a FrameRingBuffer glBufferStorage-et (4.4), a GeometryArena glVertexAttribFormat-ot (4.3) használ,
+	// így egy régebbi driveren már a context létrehozása hibát ad, nem az első rajzolás
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 4);
 
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 #ifdef _DEBUG 
@@ -92,7 +94,7 @@ int main( int argc, char* args[] )
 	SDL_GLContext	context = SDL_GL_CreateContext(win);
 	if (context == nullptr)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "[OGL context creation] Error during the creation of the OGL context: %s", SDL_GetError());
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "[OGL context creation] Error during the creation of the OGL context, OpenGL 4.4 core profile is required: %s", SDL_GetError());
 		return 1;
 	}	
 